@@ -0,0 +1,161 @@
+#include "bplus_tree.hpp"
+
+#include "../simple-bst/bst.hpp"
+#include "../splay/splay_tree.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+template <typename T>
+struct Id {
+	T const &operator()(T const &x) const
+	{ return x; }
+};
+
+using BPlusTreeType = BPlusTree<int, int, Id<int>, std::less<int>>;
+using SplayTreeType = SplayTree<int, int, Id<int>, std::less<int>>;
+using RBTree = BinarySearchTree<int, int, Id<int>, std::less<int>,
+			std::allocator<int>, RedBlackBalance>;
+
+template <typename F>
+double measure(F f)
+{
+	auto const start = std::chrono::steady_clock::now();
+	f();
+	auto const stop = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double>(stop - start).count();
+}
+
+struct Timings {
+	double insert;
+	double lookup;
+	double lower;
+	double scan;
+	double range;
+	long check;
+};
+
+/**
+ * Inserts keys 0, 2, 4, ... in random order, then runs uniformly random
+ * find and lower_bound (half of them miss), a full in-order scan and short
+ * range scans (lower_bound and the next 100 elements). SplayTree lookups
+ * splay, so uniform random queries are the worst case for it.
+ *
+ * BPlusTree runs twice: with the scalar (branchless binary search) and
+ * with the best vector node search kernels.
+ **/
+template <typename Tree>
+Timings run_tree(std::vector<int> const &keys, std::vector<int> const &probes)
+{
+	Timings timings;
+	Tree tree;
+	long check = 0;
+
+	timings.insert = measure([&] {
+		for (int key : keys)
+			tree.insert(key);
+	});
+
+	timings.lookup = measure([&] {
+		for (int probe : probes)
+			check += tree.find(probe) == tree.end() ? 0 : 1;
+	});
+
+	timings.lower = measure([&] {
+		for (int probe : probes) {
+			auto it = tree.lower_bound(probe);
+
+			check += it == tree.end() ? -1 : *it;
+		}
+	});
+
+	timings.scan = measure([&] {
+		for (int const &x : tree)
+			check += x;
+	});
+
+	size_t const ranges = std::min<size_t>(probes.size(), 100000);
+	timings.range = measure([&] {
+		for (size_t i = 0; i != ranges; ++i) {
+			auto it = tree.lower_bound(probes[i]);
+
+			for (size_t j = 0; j != 100 && it != tree.end(); ++j)
+				check += *it++;
+		}
+	});
+
+	timings.check = check;
+	return timings;
+}
+
+void print_row(size_t size, char const *op, double rb, double splay,
+			double scalar, double vector)
+{
+	std::cout << size << "\t" << op << "\t" << rb << "\t" << splay
+		<< "\t" << scalar << "\t" << vector << std::endl;
+}
+
+void run_size(size_t size, size_t lookups)
+{
+	std::mt19937 gen(size);
+	std::vector<int> keys(size);
+	for (size_t i = 0; i != size; ++i)
+		keys[i] = static_cast<int>(2 * i);
+	std::shuffle(keys.begin(), keys.end(), gen);
+
+	std::uniform_int_distribution<int> dist(0, static_cast<int>(2 * size));
+	std::vector<int> probes(lookups);
+	for (size_t i = 0; i != lookups; ++i)
+		probes[i] = dist(gen);
+
+	Timings const rb = run_tree<RBTree>(keys, probes);
+	Timings const splay = run_tree<SplayTreeType>(keys, probes);
+
+	node_search_use(node_search_scalar);
+	Timings const scalar = run_tree<BPlusTreeType>(keys, probes);
+	node_search_use(node_search_best_isa());
+	Timings const vector = run_tree<BPlusTreeType>(keys, probes);
+
+	if (rb.check != splay.check || splay.check != scalar.check
+			|| scalar.check != vector.check)
+		std::cout << "results differ!" << std::endl;
+
+	print_row(size, "insert", rb.insert, splay.insert, scalar.insert,
+				vector.insert);
+	print_row(size, "find", rb.lookup, splay.lookup, scalar.lookup,
+				vector.lookup);
+	print_row(size, "lower", rb.lower, splay.lower, scalar.lower,
+				vector.lower);
+	print_row(size, "scan", rb.scan, splay.scan, scalar.scan,
+				vector.scan);
+	print_row(size, "range", rb.range, splay.range, scalar.range,
+				vector.range);
+}
+
+int main(int argc, char **argv)
+{
+	size_t const lookups = argc > 1 ? atol(argv[1]) : 1000000;
+	std::vector<size_t> sizes;
+
+	for (int i = 2; i < argc; ++i)
+		sizes.push_back(atol(argv[i]));
+	if (sizes.empty()) {
+		sizes.push_back(100000);
+		sizes.push_back(1000000);
+		sizes.push_back(10000000);
+	}
+
+	std::cout << "random inserts, " << lookups << " random lookups, "
+		<< "full scan and range scans, seconds" << std::endl;
+	std::cout << "keys\top\tRB BinarySearchTree\tSplayTree"
+		<< "\tBPlusTree scalar\tBPlusTree vector" << std::endl;
+	for (size_t size : sizes)
+		run_size(size, lookups);
+
+	return 0;
+}
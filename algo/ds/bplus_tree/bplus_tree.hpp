@@ -0,0 +1,1221 @@
+#ifndef __BPLUS_TREE_HPP__
+#define __BPLUS_TREE_HPP__
+
+#include "node_search.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Nodes of BPlusTree take bplus_node_lines cache lines: a search reads
+ * all lines of a node anyway, so they are prefetched together when the
+ * descent enters the node, while the fan out keeps the tree much lower
+ * than a binary one (a level per cache miss instead of a level per key).
+ **/
+size_t const bplus_cache_line = 64;
+size_t const bplus_node_lines = 4;
+size_t const bplus_node_size = bplus_cache_line * bplus_node_lines;
+
+inline void bplus_prefetch(void const *node, size_t size)
+{
+#if defined(__GNUC__)
+	char const *const bytes = static_cast<char const *>(node);
+
+	for (size_t offset = 0; offset < size; offset += bplus_cache_line)
+		__builtin_prefetch(bytes + offset);
+#else
+	(void)node;
+	(void)size;
+#endif
+}
+
+struct BPlusNode {
+	BPlusNode *parent;
+	size_t count;
+
+	BPlusNode()
+	: parent(0), count(0)
+	{ }
+};
+
+/**
+ * Leaves are linked in a circular list through the head of the tree, so
+ * scans never touch inner nodes and end() (the head) can be decremented.
+ **/
+struct BPlusLeafLink : public BPlusNode {
+	BPlusLeafLink *prev;
+	BPlusLeafLink *next;
+
+	BPlusLeafLink()
+	: BPlusNode(), prev(this), next(this)
+	{ }
+};
+
+/**
+ * Values (keys of inner nodes) are kept in raw storage, count of them at
+ * the beginning are constructed. At least 4 of them fit in a node, even if
+ * they don't fit in bplus_node_size.
+ **/
+template <typename Val>
+struct BPlusLeaf : public BPlusLeafLink {
+	using Slot = typename std::aligned_storage<sizeof(Val),
+				alignof(Val)>::type;
+
+	static size_t const fit = bplus_node_size > sizeof(BPlusLeafLink)
+		? (bplus_node_size - sizeof(BPlusLeafLink)) / sizeof(Val) : 0;
+	static size_t const capacity = fit < 4 ? 4 : fit;
+
+	Slot slots[capacity];
+
+	BPlusLeaf()
+	{ }
+
+	Val *values()
+	{ return reinterpret_cast<Val *>(slots); }
+
+	Val const *values() const
+	{ return reinterpret_cast<Val const *>(slots); }
+};
+
+template <typename Key>
+struct BPlusInner : public BPlusNode {
+	using Slot = typename std::aligned_storage<sizeof(Key),
+				alignof(Key)>::type;
+
+	static size_t const header = sizeof(BPlusNode) + sizeof(BPlusNode *);
+	static size_t const fit = bplus_node_size > header
+		? (bplus_node_size - header)
+			/ (sizeof(Key) + sizeof(BPlusNode *)) : 0;
+	static size_t const capacity = fit < 4 ? 4 : fit;
+
+	BPlusNode *children[capacity + 1];
+	Slot slots[capacity];
+
+	BPlusInner()
+	{ }
+
+	Key *keys()
+	{ return reinterpret_cast<Key *>(slots); }
+
+	Key const *keys() const
+	{ return reinterpret_cast<Key const *>(slots); }
+};
+
+template <typename Val, typename Leaf>
+struct BPlusIterator : public std::iterator<
+			std::bidirectional_iterator_tag, Val> {
+	using Self = BPlusIterator<Val, Leaf>;
+	using Trait = std::iterator_traits<Self>;
+	using Ref = typename Trait::reference;
+	using Ptr = typename Trait::pointer;
+
+	BPlusLeafLink *leaf;
+	size_t index;
+
+	BPlusIterator()
+	: leaf(), index()
+	{ }
+
+	BPlusIterator(BPlusLeafLink *leaf, size_t index)
+	: leaf(leaf), index(index)
+	{ }
+
+	Ref operator*() const
+	{ return static_cast<Leaf *>(leaf)->values()[index]; }
+
+	Ptr operator->() const
+	{ return static_cast<Leaf *>(leaf)->values() + index; }
+
+	Self &operator++()
+	{
+		if (++index == leaf->count) {
+			leaf = leaf->next;
+			index = 0;
+		}
+		return *this;
+	}
+
+	Self operator++(int)
+	{
+		Self tmp = *this;
+		++*this;
+		return tmp;
+	}
+
+	Self &operator--()
+	{
+		if (!index) {
+			leaf = leaf->prev;
+			index = leaf->count;
+		}
+		--index;
+		return *this;
+	}
+
+	Self operator--(int)
+	{
+		Self tmp = *this;
+		--*this;
+		return tmp;
+	}
+
+	bool operator==(Self const &other) const
+	{ return leaf == other.leaf && index == other.index; }
+
+	bool operator!=(Self const &other) const
+	{ return !(*this == other); }
+};
+
+template <typename Val, typename Leaf>
+struct BPlusConstIterator : public std::iterator<
+			std::bidirectional_iterator_tag, Val,
+			ptrdiff_t, Val const *, Val const &> {
+	using Self = BPlusConstIterator<Val, Leaf>;
+	using Iter = BPlusIterator<Val, Leaf>;
+	using Trait = std::iterator_traits<Self>;
+	using Ref = typename Trait::reference;
+	using Ptr = typename Trait::pointer;
+
+	BPlusLeafLink const *leaf;
+	size_t index;
+
+	BPlusConstIterator()
+	: leaf(), index()
+	{ }
+
+	BPlusConstIterator(BPlusLeafLink const *leaf, size_t index)
+	: leaf(leaf), index(index)
+	{ }
+
+	BPlusConstIterator(Iter it)
+	: leaf(it.leaf), index(it.index)
+	{ }
+
+	Ref operator*() const
+	{ return static_cast<Leaf const *>(leaf)->values()[index]; }
+
+	Ptr operator->() const
+	{ return static_cast<Leaf const *>(leaf)->values() + index; }
+
+	Self &operator++()
+	{
+		if (++index == leaf->count) {
+			leaf = leaf->next;
+			index = 0;
+		}
+		return *this;
+	}
+
+	Self operator++(int)
+	{
+		Self tmp = *this;
+		++*this;
+		return tmp;
+	}
+
+	Self &operator--()
+	{
+		if (!index) {
+			leaf = leaf->prev;
+			index = leaf->count;
+		}
+		--index;
+		return *this;
+	}
+
+	Self operator--(int)
+	{
+		Self tmp = *this;
+		--*this;
+		return tmp;
+	}
+
+	bool operator==(Self const &other) const
+	{ return leaf == other.leaf && index == other.index; }
+
+	bool operator!=(Self const &other) const
+	{ return !(*this == other); }
+};
+
+template <typename Val, typename Leaf>
+inline bool operator==(BPlusIterator<Val, Leaf> const &lhs,
+			BPlusConstIterator<Val, Leaf> const &rhs)
+{ return lhs.leaf == rhs.leaf && lhs.index == rhs.index; }
+
+template <typename Val, typename Leaf>
+inline bool operator!=(BPlusIterator<Val, Leaf> const &lhs,
+			BPlusConstIterator<Val, Leaf> const &rhs)
+{ return !(lhs == rhs); }
+
+/**
+ * Ordered multiset with the interface of BinarySearchTree, but values are
+ * stored in B+ tree leaves of bplus_node_size bytes: a lookup costs a
+ * cache miss (a few adjacent lines) per level of a tree log(n) / log(fan
+ * out) high, and scans walk arrays of values in linked leaves.
+ *
+ * Inner nodes keep copies of keys: all keys in children[i] are not
+ * greater than keys[i] and all keys in children[i + 1] are not less than
+ * it, so equal keys may span several leaves. Every node but the root is
+ * at least half full.
+ *
+ * Keys of inner nodes (and values of leaves when values are keys, KeyOf
+ * must be the identity then) of arithmetic types ordered by std::less are
+ * searched with vector instructions.
+ *
+ * Unlike node based trees, insert and erase move values within and
+ * between leaves, so they invalidate all iterators. Moves of values and
+ * copies of keys must not throw, insert is strongly exception safe
+ * otherwise.
+ **/
+template <typename Key, typename Val, typename KeyOf, typename KeyCmp,
+	typename Allocator = std::allocator<Val>>
+class BPlusTree {
+	using Self = BPlusTree<Key, Val, KeyOf, KeyCmp, Allocator>;
+	using Leaf = BPlusLeaf<Val>;
+	using Inner = BPlusInner<Key>;
+	using ValueAllocTrait = std::allocator_traits<Allocator>;
+	using LeafAlloc = typename
+		ValueAllocTrait::template rebind_alloc<Leaf>;
+	using LeafAllocTrait = std::allocator_traits<LeafAlloc>;
+	using InnerAlloc = typename
+		ValueAllocTrait::template rebind_alloc<Inner>;
+	using InnerAllocTrait = std::allocator_traits<InnerAlloc>;
+
+	static size_t const leaf_capacity = Leaf::capacity;
+	static size_t const leaf_min = Leaf::capacity / 2;
+	static size_t const inner_capacity = Inner::capacity;
+	static size_t const inner_min = Inner::capacity / 2;
+
+	/**
+	 * Arithmetic keys in their natural order are searched with vector
+	 * kernels (see node_search), leaves too when values are the keys.
+	 **/
+	using PackedKeys = std::integral_constant<bool,
+		NodeSearchKey<Key>::value
+		&& std::is_same<KeyCmp, std::less<Key>>::value>;
+	using PackedValues = std::integral_constant<bool,
+		PackedKeys::value && std::is_same<Val, Key>::value>;
+
+	static_assert(sizeof(typename Leaf::Slot) == sizeof(Val),
+			"values must be stored without gaps");
+	static_assert(sizeof(typename Inner::Slot) == sizeof(Key),
+			"keys must be stored without gaps");
+
+	/**
+	 * head links the first and the last leaves, height is the number
+	 * of inner levels (0 when the root is a leaf or there is no root).
+	 **/
+	struct Impl : public LeafAlloc {
+		BPlusLeafLink head;
+		BPlusNode *root;
+		size_t height;
+		size_t size;
+		KeyCmp cmp;
+
+		Impl(KeyCmp const &cmp, LeafAlloc const &a)
+		: LeafAlloc(a), head(), root(0), height(0), size(0), cmp(cmp)
+		{ }
+	};
+
+	/**
+	 * Nodes a split of a leaf may take, allocated before the tree is
+	 * changed.
+	 **/
+	struct Spares {
+		Leaf *leaf;
+		Inner *inners[sizeof(size_t) * 8];
+		size_t count;
+	};
+
+public:
+	using key_type = Key;
+	using iterator = BPlusIterator<Val, Leaf>;
+	using const_iterator = BPlusConstIterator<Val, Leaf>;
+	using value_type = typename iterator::value_type;
+	using reference = typename iterator::reference;
+	using const_reference = typename const_iterator::reference;
+	using size_type = size_t;
+
+	explicit BPlusTree(KeyCmp const &cmp = KeyCmp(),
+				Allocator const &a = Allocator())
+	: impl(cmp, LeafAlloc(a))
+	{ }
+
+	explicit BPlusTree(Allocator const &a)
+	: impl(KeyCmp(), LeafAlloc(a))
+	{ }
+
+	template <typename It>
+	BPlusTree(It first, It last, KeyCmp const &cmp = KeyCmp(),
+				Allocator const &a = Allocator())
+	: impl(cmp, LeafAlloc(a))
+	{
+		try {
+			insert(first, last);
+		} catch (...) {
+			clear();
+			throw;
+		}
+	}
+
+	BPlusTree(Self &&other)
+	: impl(other.impl.cmp, other.leaf_allocator())
+	{ swap_trees(other); }
+
+	~BPlusTree()
+	{ clear(); }
+
+	BPlusTree &operator=(Self &&other)
+	{
+		if (this != &other) {
+			clear();
+			swap(other);
+		}
+		return *this;
+	}
+
+	void swap(Self &other)
+	{
+		using std::swap;
+		swap_trees(other);
+		swap(leaf_allocator(), other.leaf_allocator());
+		swap(impl.cmp, other.impl.cmp);
+	}
+
+	void clear()
+	{
+		if (impl.root)
+			destroy_subtree(impl.root, impl.height);
+		impl.head.prev = &impl.head;
+		impl.head.next = &impl.head;
+		impl.root = 0;
+		impl.height = 0;
+		impl.size = 0;
+	}
+
+	bool empty() const
+	{ return impl.size == 0; }
+
+	size_t size() const
+	{ return impl.size; }
+
+	/**
+	 * Number of inner levels above the leaves.
+	 **/
+	size_t height() const
+	{ return impl.height; }
+
+	iterator begin()
+	{ return iterator(impl.head.next, 0); }
+
+	const_iterator begin() const
+	{ return const_iterator(impl.head.next, 0); }
+
+	iterator end()
+	{ return iterator(&impl.head, 0); }
+
+	const_iterator end() const
+	{ return const_iterator(&impl.head, 0); }
+
+	iterator insert(Val const &x)
+	{
+		Val tmp(x);
+
+		return insert_value(tmp);
+	}
+
+	iterator insert(Val &&x)
+	{ return insert_value(x); }
+
+	template <typename It>
+	void insert(It first, It last)
+	{
+		for (; first != last; ++first)
+			insert(*first);
+	}
+
+	template <typename ... Args>
+	iterator emplace(Args && ... args)
+	{
+		Val tmp(std::forward<Args>(args)...);
+
+		return insert_value(tmp);
+	}
+
+	const_iterator lower_bound(Key const &key) const
+	{ return bound<false>(key); }
+
+	const_iterator upper_bound(Key const &key) const
+	{ return bound<true>(key); }
+
+	iterator lower_bound(Key const &key)
+	{ return make_iterator(bound<false>(key)); }
+
+	iterator upper_bound(Key const &key)
+	{ return make_iterator(bound<true>(key)); }
+
+	const_iterator find(Key const &key) const
+	{
+		const_iterator it = lower_bound(key);
+
+		if (it == end() || impl.cmp(key, KeyOf()(*it)))
+			return end();
+		return it;
+	}
+
+	iterator find(Key const &key)
+	{ return make_iterator(static_cast<Self const *>(this)->find(key)); }
+
+	std::pair<const_iterator, const_iterator>
+	equal_range(Key const &key) const
+	{ return std::make_pair(lower_bound(key), upper_bound(key)); }
+
+	std::pair<iterator, iterator> equal_range(Key const &key)
+	{ return std::make_pair(lower_bound(key), upper_bound(key)); }
+
+	size_t count(Key const &key) const
+	{ return std::distance(lower_bound(key), upper_bound(key)); }
+
+	/**
+	 * Returns iterator to the element that followed the erased one.
+	 **/
+	iterator erase(const_iterator it)
+	{
+		Leaf *const leaf = static_cast<Leaf *>(
+				const_cast<BPlusLeafLink *>(it.leaf));
+
+		return erase_at(leaf, it.index);
+	}
+
+	iterator erase(const_iterator first, const_iterator last)
+	{
+		if (first == begin() && last == end()) {
+			clear();
+			return end();
+		}
+
+		/* every erase moves values, so last is of no use after it */
+		for (size_t n = std::distance(first, last); n; --n)
+			first = erase(first);
+		return make_iterator(first);
+	}
+
+	/**
+	 * Checks structure of the tree (fill of nodes, order of keys and
+	 * separators, parent pointers and links of leaves), for tests.
+	 **/
+	bool validate() const
+	{
+		BPlusLeafLink const *leaf = &impl.head;
+		size_t size = 0;
+
+		if (!impl.root)
+			return impl.height == 0 && impl.size == 0
+				&& impl.head.next == &impl.head
+				&& impl.head.prev == &impl.head;
+
+		return impl.root->parent == 0
+			&& validate_node(impl.root, impl.height, 0, 0,
+					leaf, size)
+			&& leaf->next == &impl.head
+			&& impl.head.prev == leaf
+			&& size == impl.size;
+	}
+
+private:
+	LeafAlloc &leaf_allocator()
+	{ return *static_cast<LeafAlloc *>(&impl); }
+
+	LeafAlloc const &leaf_allocator() const
+	{ return *static_cast<LeafAlloc const *>(&impl); }
+
+	static Key const &key_of(Val const &x)
+	{ return KeyOf()(x); }
+
+	iterator make_iterator(const_iterator it)
+	{ return iterator(const_cast<BPlusLeafLink *>(it.leaf), it.index); }
+
+	Leaf *create_leaf()
+	{
+		Leaf *leaf = LeafAllocTrait::allocate(impl, 1);
+
+		::new (static_cast<void *>(leaf)) Leaf();
+		return leaf;
+	}
+
+	void free_leaf(Leaf *leaf)
+	{
+		leaf->~Leaf();
+		LeafAllocTrait::deallocate(impl, leaf, 1);
+	}
+
+	Inner *create_inner()
+	{
+		InnerAlloc alloc(leaf_allocator());
+		Inner *inner = InnerAllocTrait::allocate(alloc, 1);
+
+		::new (static_cast<void *>(inner)) Inner();
+		return inner;
+	}
+
+	void free_inner(Inner *inner)
+	{
+		InnerAlloc alloc(leaf_allocator());
+
+		inner->~Inner();
+		InnerAllocTrait::deallocate(alloc, inner, 1);
+	}
+
+	template <typename T, typename ... Args>
+	void construct(T *at, Args && ... args)
+	{ LeafAllocTrait::construct(impl, at, std::forward<Args>(args)...); }
+
+	template <typename T>
+	void destroy(T *at)
+	{ LeafAllocTrait::destroy(impl, at); }
+
+	template <typename T>
+	void relocate(T *to, T *from)
+	{
+		construct(to, std::move(*from));
+		destroy(from);
+	}
+
+	/**
+	 * Relocates n elements, ranges may overlap within a node.
+	 **/
+	template <typename T>
+	void relocate(T *to, T *from, size_t n)
+	{
+		if (std::less<T *>()(to, from)) {
+			for (size_t i = 0; i != n; ++i)
+				relocate(to + i, from + i);
+		} else {
+			for (size_t i = n; i--; )
+				relocate(to + i, from + i);
+		}
+	}
+
+	static void move_children(Inner *to, size_t at, BPlusNode **from,
+				size_t n)
+	{
+		std::memmove(to->children + at, from, n * sizeof(*from));
+		for (size_t i = 0; i != n; ++i)
+			to->children[at + i]->parent = to;
+	}
+
+	static void link_leaf_after(BPlusLeafLink *leaf, BPlusLeafLink *prev)
+	{
+		leaf->prev = prev;
+		leaf->next = prev->next;
+		prev->next->prev = leaf;
+		prev->next = leaf;
+	}
+
+	static void unlink_leaf(BPlusLeafLink *leaf)
+	{
+		leaf->prev->next = leaf->next;
+		leaf->next->prev = leaf->prev;
+	}
+
+	static size_t child_index(Inner const *parent, BPlusNode const *child)
+	{
+		size_t i = 0;
+
+		while (parent->children[i] != child)
+			++i;
+		return i;
+	}
+
+	/**
+	 * Number of keys less than key (Upper == false) or not greater than
+	 * key (Upper == true) among n keys given by get. The search halves
+	 * the range without branching on the comparison: a node spans few
+	 * cache lines, so mispredicted branches cost more than the loads.
+	 **/
+	template <bool Upper, typename Get>
+	size_t search(Get get, size_t n, Key const &key) const
+	{
+		size_t first = 0;
+
+		if (!n)
+			return 0;
+
+		while (n > 1) {
+			size_t const half = n / 2;
+
+			first = before<Upper>(get(first + half), key)
+				? first + half : first;
+			n -= half;
+		}
+		return first + before<Upper>(get(first), key);
+	}
+
+	template <bool Upper>
+	bool before(Key const &x, Key const &key) const
+	{ return Upper ? !impl.cmp(key, x) : impl.cmp(x, key); }
+
+	template <bool Upper>
+	BPlusLeafLink const *find_leaf(Key const &key) const
+	{
+		BPlusNode const *node = impl.root;
+
+		for (size_t level = impl.height; level; --level) {
+			Inner const *const inner = static_cast<Inner const *>(
+						node);
+			node = inner->children[key_search<Upper>(
+				inner->keys(), inner->count, key,
+				PackedKeys())];
+			bplus_prefetch(node, level > 1 ? sizeof(Inner)
+						: sizeof(Leaf));
+		}
+		return static_cast<BPlusLeafLink const *>(node);
+	}
+
+	template <bool Upper>
+	size_t leaf_search(Leaf const *leaf, Key const &key) const
+	{ return leaf_search<Upper>(leaf, key, PackedValues()); }
+
+	template <bool Upper>
+	size_t leaf_search(Leaf const *leaf, Key const &key,
+				std::false_type) const
+	{
+		Val const *const values = leaf->values();
+
+		return search<Upper>([values](size_t i) -> Key const &
+			{ return key_of(values[i]); }, leaf->count, key);
+	}
+
+	template <bool Upper>
+	size_t leaf_search(Leaf const *leaf, Key const &key,
+				std::true_type) const
+	{ return node_search<Upper>(leaf->values(), leaf->count, key); }
+
+	template <bool Upper>
+	size_t key_search(Key const *keys, size_t n, Key const &key,
+				std::false_type) const
+	{
+		return search<Upper>([keys](size_t i) -> Key const &
+			{ return keys[i]; }, n, key);
+	}
+
+	template <bool Upper>
+	size_t key_search(Key const *keys, size_t n, Key const &key,
+				std::true_type) const
+	{ return node_search<Upper>(keys, n, key); }
+
+	template <bool Upper>
+	const_iterator bound(Key const &key) const
+	{
+		if (!impl.root)
+			return end();
+
+		Leaf const *const leaf = static_cast<Leaf const *>(
+					find_leaf<Upper>(key));
+		size_t const index = leaf_search<Upper>(leaf, key);
+
+		if (index == leaf->count)
+			return const_iterator(leaf->next, 0);
+		return const_iterator(leaf, index);
+	}
+
+	/**
+	 * Moves x into the tree after all the equal keys.
+	 **/
+	iterator insert_value(Val &x)
+	{
+		if (!impl.root) {
+			Leaf *const leaf = create_leaf();
+
+			link_leaf_after(leaf, &impl.head);
+			impl.root = leaf;
+		}
+
+		Key const &key = key_of(x);
+		Leaf *const leaf = static_cast<Leaf *>(
+			const_cast<BPlusLeafLink *>(find_leaf<true>(key)));
+		size_t const pos = leaf_search<true>(leaf, key);
+
+		if (leaf->count < leaf_capacity) {
+			insert_into_leaf(leaf, pos, x);
+			return iterator(leaf, pos);
+		}
+
+		Spares spares;
+		reserve_spares(leaf, spares);
+
+		Leaf *const right = spares.leaf;
+		size_t const left_size = (leaf_capacity + 1) / 2;
+		Leaf *target = leaf;
+		size_t at = pos;
+
+		link_leaf_after(right, leaf);
+		if (pos < left_size) {
+			right->count = leaf_capacity - left_size + 1;
+			relocate(right->values(),
+				leaf->values() + left_size - 1, right->count);
+		} else {
+			right->count = leaf_capacity - left_size;
+			relocate(right->values(),
+				leaf->values() + left_size, right->count);
+			target = right;
+			at = pos - left_size;
+		}
+		leaf->count -= right->count;
+		insert_into_leaf(target, at, x);
+
+		Key separator(key_of(right->values()[0]));
+		insert_into_parent(leaf, separator, right, spares);
+		return iterator(target, at);
+	}
+
+	void insert_into_leaf(Leaf *leaf, size_t pos, Val &x)
+	{
+		Val *const values = leaf->values();
+
+		relocate(values + pos + 1, values + pos, leaf->count - pos);
+		construct(values + pos, std::move(x));
+		++leaf->count;
+		++impl.size;
+	}
+
+	/**
+	 * Allocates a leaf and inner nodes for all the full ancestors of
+	 * leaf (and a new root if all of them are full).
+	 **/
+	void reserve_spares(Leaf *leaf, Spares &spares)
+	{
+		BPlusNode *node = leaf->parent;
+		size_t needed = 0;
+
+		for (; node && node->count == inner_capacity;
+					node = node->parent)
+			++needed;
+		if (!node)
+			++needed;
+
+		spares.leaf = 0;
+		spares.count = 0;
+
+		try {
+			spares.leaf = create_leaf();
+			while (spares.count != needed)
+				spares.inners[spares.count++] = create_inner();
+		} catch (...) {
+			if (spares.leaf)
+				free_leaf(spares.leaf);
+			while (spares.count)
+				free_inner(spares.inners[--spares.count]);
+			throw;
+		}
+	}
+
+	/**
+	 * Adds separator and right after left into the parent of left,
+	 * full parents are split on the way up.
+	 **/
+	void insert_into_parent(BPlusNode *left, Key &separator,
+				BPlusNode *right, Spares &spares)
+	{
+		for (;;) {
+			Inner *const parent = static_cast<Inner *>(
+						left->parent);
+
+			if (!parent) {
+				Inner *const root = spares.inners[
+						--spares.count];
+
+				construct(root->keys(), std::move(separator));
+				root->children[0] = left;
+				root->children[1] = right;
+				root->count = 1;
+				left->parent = root;
+				right->parent = root;
+				impl.root = root;
+				++impl.height;
+				return;
+			}
+
+			size_t const pos = child_index(parent, left);
+
+			if (parent->count < inner_capacity) {
+				insert_into_inner(parent, pos, separator,
+							right);
+				return;
+			}
+
+			Inner *const sibling = spares.inners[--spares.count];
+			Key up(split_inner(parent, pos, separator, right,
+						sibling));
+
+			left = parent;
+			right = sibling;
+			separator = std::move(up);
+		}
+	}
+
+	void insert_into_inner(Inner *inner, size_t pos, Key &key,
+				BPlusNode *child)
+	{
+		Key *const keys = inner->keys();
+
+		relocate(keys + pos + 1, keys + pos, inner->count - pos);
+		construct(keys + pos, std::move(key));
+		std::memmove(inner->children + pos + 2,
+			inner->children + pos + 1,
+			(inner->count - pos) * sizeof(BPlusNode *));
+		inner->children[pos + 1] = child;
+		child->parent = inner;
+		++inner->count;
+	}
+
+	/**
+	 * Splits full inner node that takes key at pos (and child after
+	 * it), the upper half goes to right and the middle key is returned.
+	 **/
+	Key split_inner(Inner *inner, size_t pos, Key &key, BPlusNode *child,
+				Inner *right)
+	{
+		size_t const mid = (inner_capacity + 1) / 2;
+		Key *const keys = inner->keys();
+		Key *const rkeys = right->keys();
+
+		/* keys and children as if key and child were inserted */
+		for (size_t i = mid + 1; i <= inner_capacity; ++i) {
+			Key *const to = rkeys + i - mid - 1;
+
+			if (i == pos)
+				construct(to, std::move(key));
+			else
+				relocate(to, keys + (i < pos ? i : i - 1));
+		}
+		for (size_t i = mid + 1; i <= inner_capacity + 1; ++i) {
+			BPlusNode *const node = i <= pos ? inner->children[i]
+				: i == pos + 1 ? child
+				: inner->children[i - 1];
+
+			right->children[i - mid - 1] = node;
+			node->parent = right;
+		}
+		right->count = inner_capacity - mid;
+
+		Key *const middle = mid == pos ? &key
+				: keys + (mid < pos ? mid : mid - 1);
+		Key up(std::move(*middle));
+
+		if (middle != &key)
+			destroy(middle);
+
+		if (pos < mid) {
+			relocate(keys + pos + 1, keys + pos, mid - 1 - pos);
+			construct(keys + pos, std::move(key));
+			std::memmove(inner->children + pos + 2,
+				inner->children + pos + 1,
+				(mid - 1 - pos) * sizeof(BPlusNode *));
+			inner->children[pos + 1] = child;
+			child->parent = inner;
+		}
+		inner->count = mid;
+		return up;
+	}
+
+	iterator erase_at(Leaf *leaf, size_t index)
+	{
+		Val *const values = leaf->values();
+
+		destroy(values + index);
+		relocate(values + index, values + index + 1,
+				leaf->count - index - 1);
+		--leaf->count;
+		--impl.size;
+
+		iterator next(leaf, index);
+		if (index == leaf->count)
+			next = iterator(leaf->next, 0);
+
+		if (leaf == impl.root) {
+			if (!leaf->count) {
+				unlink_leaf(leaf);
+				free_leaf(leaf);
+				impl.root = 0;
+				return end();
+			}
+			return next;
+		}
+
+		if (leaf->count < leaf_min)
+			rebalance_leaf(leaf, next);
+		return next;
+	}
+
+	/**
+	 * Refills leaf from a sibling or merges them, next is kept pointing
+	 * to the same element.
+	 **/
+	void rebalance_leaf(Leaf *leaf, iterator &next)
+	{
+		Inner *const parent = static_cast<Inner *>(leaf->parent);
+		size_t const pos = child_index(parent, leaf);
+		Leaf *const left = pos ? static_cast<Leaf *>(
+					parent->children[pos - 1]) : 0;
+		Leaf *const right = pos < parent->count
+			? static_cast<Leaf *>(parent->children[pos + 1]) : 0;
+
+		if (left && left->count > leaf_min) {
+			relocate(leaf->values() + 1, leaf->values(),
+						leaf->count);
+			relocate(leaf->values(),
+					left->values() + left->count - 1);
+			--left->count;
+			++leaf->count;
+			parent->keys()[pos - 1] = key_of(leaf->values()[0]);
+			if (next.leaf == leaf)
+				++next.index;
+			return;
+		}
+
+		if (right && right->count > leaf_min) {
+			relocate(leaf->values() + leaf->count,
+						right->values());
+			relocate(right->values(), right->values() + 1,
+						right->count - 1);
+			--right->count;
+			++leaf->count;
+			parent->keys()[pos] = key_of(right->values()[0]);
+			if (next.leaf == right && next.index == 0)
+				next = iterator(leaf, leaf->count - 1);
+			return;
+		}
+
+		if (left) {
+			if (next.leaf == leaf)
+				next = iterator(left, left->count + next.index);
+			merge_leaves(left, leaf, parent, pos - 1);
+		} else {
+			if (next.leaf == right)
+				next = iterator(leaf, leaf->count + next.index);
+			merge_leaves(leaf, right, parent, pos);
+		}
+	}
+
+	/**
+	 * Moves all values of right (children[pos + 1] of parent) to left.
+	 **/
+	void merge_leaves(Leaf *left, Leaf *right, Inner *parent, size_t pos)
+	{
+		relocate(left->values() + left->count, right->values(),
+					right->count);
+		left->count += right->count;
+		right->count = 0;
+		unlink_leaf(right);
+		free_leaf(right);
+		remove_from_inner(parent, pos);
+	}
+
+	/**
+	 * Removes key pos and the child after it from inner node and
+	 * restores fill of the ancestors.
+	 **/
+	void remove_from_inner(Inner *inner, size_t pos)
+	{
+		Key *const keys = inner->keys();
+
+		destroy(keys + pos);
+		relocate(keys + pos, keys + pos + 1, inner->count - pos - 1);
+		std::memmove(inner->children + pos + 1,
+			inner->children + pos + 2,
+			(inner->count - pos - 1) * sizeof(BPlusNode *));
+		--inner->count;
+
+		if (inner == impl.root) {
+			if (!inner->count) {
+				impl.root = inner->children[0];
+				impl.root->parent = 0;
+				--impl.height;
+				free_inner(inner);
+			}
+			return;
+		}
+
+		if (inner->count < inner_min)
+			rebalance_inner(inner);
+	}
+
+	void rebalance_inner(Inner *inner)
+	{
+		Inner *const parent = static_cast<Inner *>(inner->parent);
+		size_t const pos = child_index(parent, inner);
+		Inner *const left = pos ? static_cast<Inner *>(
+					parent->children[pos - 1]) : 0;
+		Inner *const right = pos < parent->count
+			? static_cast<Inner *>(parent->children[pos + 1]) : 0;
+		Key *const keys = inner->keys();
+
+		if (left && left->count > inner_min) {
+			/* rotate the last child of left through parent */
+			relocate(keys + 1, keys, inner->count);
+			relocate(keys, parent->keys() + pos - 1);
+			relocate(parent->keys() + pos - 1,
+					left->keys() + left->count - 1);
+			std::memmove(inner->children + 1, inner->children,
+				(inner->count + 1) * sizeof(BPlusNode *));
+			move_children(inner, 0, left->children + left->count,
+					1);
+			--left->count;
+			++inner->count;
+			return;
+		}
+
+		if (right && right->count > inner_min) {
+			relocate(keys + inner->count, parent->keys() + pos);
+			relocate(parent->keys() + pos, right->keys());
+			relocate(right->keys(), right->keys() + 1,
+					right->count - 1);
+			move_children(inner, inner->count + 1, right->children,
+					1);
+			std::memmove(right->children, right->children + 1,
+				right->count * sizeof(BPlusNode *));
+			--right->count;
+			++inner->count;
+			return;
+		}
+
+		if (left)
+			merge_inners(left, inner, parent, pos - 1);
+		else
+			merge_inners(inner, right, parent, pos);
+	}
+
+	/**
+	 * Moves separator pos of parent and all keys and children of right
+	 * (children[pos + 1] of parent) to left.
+	 **/
+	void merge_inners(Inner *left, Inner *right, Inner *parent,
+				size_t pos)
+	{
+		Key *const keys = left->keys();
+
+		construct(keys + left->count, std::move(parent->keys()[pos]));
+		relocate(keys + left->count + 1, right->keys(), right->count);
+		move_children(left, left->count + 1, right->children,
+					right->count + 1);
+		left->count += right->count + 1;
+		right->count = 0;
+		free_inner(right);
+		remove_from_inner(parent, pos);
+	}
+
+	void destroy_subtree(BPlusNode *node, size_t level)
+	{
+		if (!level) {
+			Leaf *const leaf = static_cast<Leaf *>(node);
+
+			for (size_t i = 0; i != leaf->count; ++i)
+				destroy(leaf->values() + i);
+			free_leaf(leaf);
+			return;
+		}
+
+		Inner *const inner = static_cast<Inner *>(node);
+
+		for (size_t i = 0; i <= inner->count; ++i)
+			destroy_subtree(inner->children[i], level - 1);
+		for (size_t i = 0; i != inner->count; ++i)
+			destroy(inner->keys() + i);
+		free_inner(inner);
+	}
+
+	static void adopt_head(BPlusLeafLink *head, bool empty)
+	{
+		if (empty) {
+			head->prev = head;
+			head->next = head;
+		} else {
+			head->next->prev = head;
+			head->prev->next = head;
+		}
+	}
+
+	/**
+	 * Exchanges nodes, but not allocators and comparators.
+	 **/
+	void swap_trees(Self &other)
+	{
+		bool const empty = !impl.root;
+		bool const other_empty = !other.impl.root;
+
+		std::swap(impl.head.prev, other.impl.head.prev);
+		std::swap(impl.head.next, other.impl.head.next);
+		std::swap(impl.root, other.impl.root);
+		std::swap(impl.height, other.impl.height);
+		std::swap(impl.size, other.impl.size);
+		adopt_head(&impl.head, other_empty);
+		adopt_head(&other.impl.head, empty);
+	}
+
+	/**
+	 * All values in the subtree are within [low, high] (null bound is
+	 * no bound), leaves are visited in order and checked to follow
+	 * leaf in the list.
+	 **/
+	bool validate_node(BPlusNode const *node, size_t level,
+				Key const *low, Key const *high,
+				BPlusLeafLink const *&leaf, size_t &size) const
+	{
+		bool const root = node == impl.root;
+
+		if (!level) {
+			Leaf const *const cur = static_cast<Leaf const *>(node);
+			Val const *const values = cur->values();
+
+			if (cur->count > leaf_capacity || !cur->count
+					|| (!root && cur->count < leaf_min)
+					|| cur->prev != leaf
+					|| leaf->next != cur)
+				return false;
+
+			for (size_t i = 0; i != cur->count; ++i) {
+				Key const &key = key_of(values[i]);
+
+				if ((low && impl.cmp(key, *low))
+					|| (high && impl.cmp(*high, key))
+					|| (i && impl.cmp(key,
+						key_of(values[i - 1]))))
+					return false;
+			}
+
+			leaf = cur;
+			size += cur->count;
+			return true;
+		}
+
+		Inner const *const inner = static_cast<Inner const *>(node);
+		Key const *const keys = inner->keys();
+
+		if (inner->count > inner_capacity || !inner->count
+				|| (!root && inner->count < inner_min))
+			return false;
+
+		for (size_t i = 0; i <= inner->count; ++i) {
+			Key const *const lo = i ? keys + i - 1 : low;
+			Key const *const hi = i < inner->count ? keys + i
+						: high;
+
+			if ((lo && hi && impl.cmp(*hi, *lo))
+					|| inner->children[i]->parent != inner
+					|| !validate_node(inner->children[i],
+						level - 1, lo, hi, leaf, size))
+				return false;
+		}
+		return true;
+	}
+
+	Impl impl;
+};
+
+#endif /*__BPLUS_TREE_HPP__*/
@@ -0,0 +1,407 @@
+#include "node_search.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NODE_SEARCH_X86
+#include <immintrin.h>
+#endif
+
+template <bool Upper, typename T>
+static inline bool before(T x, T key)
+{ return Upper ? !(key < x) : x < key; }
+
+/**
+ * Takes branchless binary search steps until at most window keys are left,
+ * the position is then in [first, first + n].
+ **/
+template <bool Upper, typename T>
+static inline size_t narrow(T const *keys, size_t &n, T key, size_t window)
+{
+	size_t first = 0;
+
+	while (n > window) {
+		size_t const half = n / 2;
+
+		first = before<Upper>(keys[first + half], key)
+			? first + half : first;
+		n -= half;
+	}
+	return first;
+}
+
+template <typename T, bool Upper>
+static size_t scalar_search(T const *keys, size_t n, T key)
+{
+	if (!n)
+		return 0;
+
+	size_t const first = narrow<Upper>(keys, n, key, 1);
+
+	return first + before<Upper>(keys[first], key);
+}
+
+template <typename T>
+static NodeSearchFn<T> scalar_fn()
+{
+	NodeSearchFn<T> const fn = {
+		&scalar_search<T, false>,
+		&scalar_search<T, true>
+	};
+
+	return fn;
+}
+
+/* constant initialized, so searches before start up code runs work */
+NodeSearchTable node_search_table = {
+	{ &scalar_search<int32_t, false>, &scalar_search<int32_t, true> },
+	{ &scalar_search<uint32_t, false>, &scalar_search<uint32_t, true> },
+	{ &scalar_search<int64_t, false>, &scalar_search<int64_t, true> },
+	{ &scalar_search<uint64_t, false>, &scalar_search<uint64_t, true> },
+	{ &scalar_search<float, false>, &scalar_search<float, true> },
+	{ &scalar_search<double, false>, &scalar_search<double, true> }
+};
+
+static NodeSearchIsa current_isa = node_search_scalar;
+
+#if defined(NODE_SEARCH_X86)
+
+/**
+ * Operations of a kernel: Vec holds lanes keys, less and greater return
+ * bit masks of lanes less and greater than the probe. Unsigned keys are
+ * biased to compare them as signed ones.
+ **/
+#define SSE2 __attribute__((target("sse2")))
+#define AVX2 __attribute__((target("avx2,popcnt")))
+
+struct Sse2Int32 {
+	using Key = int32_t;
+	using Vec = __m128i;
+	static size_t const lanes = 4;
+
+	SSE2 static Vec splat(Key key)
+	{ return _mm_set1_epi32(key); }
+
+	SSE2 static Vec load(Key const *keys)
+	{ return _mm_loadu_si128(reinterpret_cast<Vec const *>(keys)); }
+
+	SSE2 static int less(Vec v, Vec probe)
+	{ return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(v, probe))); }
+
+	SSE2 static int greater(Vec v, Vec probe)
+	{ return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(v, probe))); }
+};
+
+struct Sse2Uint32 : public Sse2Int32 {
+	using Key = uint32_t;
+
+	SSE2 static Vec bias()
+	{ return _mm_set1_epi32(INT32_MIN); }
+
+	SSE2 static Vec splat(Key key)
+	{ return _mm_xor_si128(_mm_set1_epi32(key), bias()); }
+
+	SSE2 static Vec load(Key const *keys)
+	{
+		return _mm_xor_si128(_mm_loadu_si128(
+			reinterpret_cast<Vec const *>(keys)), bias());
+	}
+};
+
+struct Sse2Float {
+	using Key = float;
+	using Vec = __m128;
+	static size_t const lanes = 4;
+
+	SSE2 static Vec splat(Key key)
+	{ return _mm_set1_ps(key); }
+
+	SSE2 static Vec load(Key const *keys)
+	{ return _mm_loadu_ps(keys); }
+
+	SSE2 static int less(Vec v, Vec probe)
+	{ return _mm_movemask_ps(_mm_cmplt_ps(v, probe)); }
+
+	SSE2 static int greater(Vec v, Vec probe)
+	{ return _mm_movemask_ps(_mm_cmplt_ps(probe, v)); }
+};
+
+struct Sse2Double {
+	using Key = double;
+	using Vec = __m128d;
+	static size_t const lanes = 2;
+
+	SSE2 static Vec splat(Key key)
+	{ return _mm_set1_pd(key); }
+
+	SSE2 static Vec load(Key const *keys)
+	{ return _mm_loadu_pd(keys); }
+
+	SSE2 static int less(Vec v, Vec probe)
+	{ return _mm_movemask_pd(_mm_cmplt_pd(v, probe)); }
+
+	SSE2 static int greater(Vec v, Vec probe)
+	{ return _mm_movemask_pd(_mm_cmplt_pd(probe, v)); }
+};
+
+struct Avx2Int32 {
+	using Key = int32_t;
+	using Vec = __m256i;
+	static size_t const lanes = 8;
+
+	AVX2 static Vec splat(Key key)
+	{ return _mm256_set1_epi32(key); }
+
+	AVX2 static Vec load(Key const *keys)
+	{ return _mm256_loadu_si256(reinterpret_cast<Vec const *>(keys)); }
+
+	AVX2 static int less(Vec v, Vec probe)
+	{
+		return _mm256_movemask_ps(_mm256_castsi256_ps(
+				_mm256_cmpgt_epi32(probe, v)));
+	}
+
+	AVX2 static int greater(Vec v, Vec probe)
+	{
+		return _mm256_movemask_ps(_mm256_castsi256_ps(
+				_mm256_cmpgt_epi32(v, probe)));
+	}
+};
+
+struct Avx2Uint32 : public Avx2Int32 {
+	using Key = uint32_t;
+
+	AVX2 static Vec bias()
+	{ return _mm256_set1_epi32(INT32_MIN); }
+
+	AVX2 static Vec splat(Key key)
+	{ return _mm256_xor_si256(_mm256_set1_epi32(key), bias()); }
+
+	AVX2 static Vec load(Key const *keys)
+	{
+		return _mm256_xor_si256(_mm256_loadu_si256(
+			reinterpret_cast<Vec const *>(keys)), bias());
+	}
+};
+
+struct Avx2Int64 {
+	using Key = int64_t;
+	using Vec = __m256i;
+	static size_t const lanes = 4;
+
+	AVX2 static Vec splat(Key key)
+	{ return _mm256_set1_epi64x(key); }
+
+	AVX2 static Vec load(Key const *keys)
+	{ return _mm256_loadu_si256(reinterpret_cast<Vec const *>(keys)); }
+
+	AVX2 static int less(Vec v, Vec probe)
+	{
+		return _mm256_movemask_pd(_mm256_castsi256_pd(
+				_mm256_cmpgt_epi64(probe, v)));
+	}
+
+	AVX2 static int greater(Vec v, Vec probe)
+	{
+		return _mm256_movemask_pd(_mm256_castsi256_pd(
+				_mm256_cmpgt_epi64(v, probe)));
+	}
+};
+
+struct Avx2Uint64 : public Avx2Int64 {
+	using Key = uint64_t;
+
+	AVX2 static Vec bias()
+	{ return _mm256_set1_epi64x(INT64_MIN); }
+
+	AVX2 static Vec splat(Key key)
+	{ return _mm256_xor_si256(_mm256_set1_epi64x(key), bias()); }
+
+	AVX2 static Vec load(Key const *keys)
+	{
+		return _mm256_xor_si256(_mm256_loadu_si256(
+			reinterpret_cast<Vec const *>(keys)), bias());
+	}
+};
+
+struct Avx2Float {
+	using Key = float;
+	using Vec = __m256;
+	static size_t const lanes = 8;
+
+	AVX2 static Vec splat(Key key)
+	{ return _mm256_set1_ps(key); }
+
+	AVX2 static Vec load(Key const *keys)
+	{ return _mm256_loadu_ps(keys); }
+
+	AVX2 static int less(Vec v, Vec probe)
+	{ return _mm256_movemask_ps(_mm256_cmp_ps(v, probe, _CMP_LT_OQ)); }
+
+	AVX2 static int greater(Vec v, Vec probe)
+	{ return _mm256_movemask_ps(_mm256_cmp_ps(probe, v, _CMP_LT_OQ)); }
+};
+
+struct Avx2Double {
+	using Key = double;
+	using Vec = __m256d;
+	static size_t const lanes = 4;
+
+	AVX2 static Vec splat(Key key)
+	{ return _mm256_set1_pd(key); }
+
+	AVX2 static Vec load(Key const *keys)
+	{ return _mm256_loadu_pd(keys); }
+
+	AVX2 static int less(Vec v, Vec probe)
+	{ return _mm256_movemask_pd(_mm256_cmp_pd(v, probe, _CMP_LT_OQ)); }
+
+	AVX2 static int greater(Vec v, Vec probe)
+	{ return _mm256_movemask_pd(_mm256_cmp_pd(probe, v, _CMP_LT_OQ)); }
+};
+
+/**
+ * Keys are sorted, so counting the keys before the probe in every block
+ * gives its position without a single data dependent branch. Counting
+ * scans every key though, so wide nodes take branchless binary search
+ * steps down to a window of a few blocks first.
+ **/
+static size_t const window_blocks = 2;
+
+/**
+ * CPUs with just SSE2 may lack popcnt and __builtin_popcount becomes a
+ * library call, SSE2 masks have at most 4 bits, so a table does.
+ **/
+static unsigned char const nibble_bits[16] = {
+	0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+};
+
+template <typename Ops, bool Upper>
+SSE2 static size_t sse2_search(typename Ops::Key const *keys, size_t n,
+			typename Ops::Key key)
+{
+	typename Ops::Vec const probe = Ops::splat(key);
+	size_t count = narrow<Upper>(keys, n, key,
+				Ops::lanes * window_blocks);
+	size_t i = 0;
+
+	keys += count;
+
+	for (; i + Ops::lanes <= n; i += Ops::lanes) {
+		typename Ops::Vec const v = Ops::load(keys + i);
+		int const mask = Upper ? Ops::greater(v, probe)
+					: Ops::less(v, probe);
+
+		count += Upper ? Ops::lanes - nibble_bits[mask]
+				: nibble_bits[mask];
+	}
+	for (; i != n; ++i)
+		count += before<Upper>(keys[i], key);
+	return count;
+}
+
+template <typename Ops, bool Upper>
+AVX2 static size_t avx2_search(typename Ops::Key const *keys, size_t n,
+			typename Ops::Key key)
+{
+	typename Ops::Vec const probe = Ops::splat(key);
+	size_t count = narrow<Upper>(keys, n, key,
+				Ops::lanes * window_blocks);
+	size_t i = 0;
+
+	keys += count;
+
+	for (; i + Ops::lanes <= n; i += Ops::lanes) {
+		typename Ops::Vec const v = Ops::load(keys + i);
+		int const mask = Upper ? Ops::greater(v, probe)
+					: Ops::less(v, probe);
+
+		count += Upper ? Ops::lanes - __builtin_popcount(mask)
+				: __builtin_popcount(mask);
+	}
+	for (; i != n; ++i)
+		count += before<Upper>(keys[i], key);
+	return count;
+}
+
+template <typename Ops>
+static NodeSearchFn<typename Ops::Key> sse2_fn()
+{
+	NodeSearchFn<typename Ops::Key> const fn = {
+		&sse2_search<Ops, false>,
+		&sse2_search<Ops, true>
+	};
+
+	return fn;
+}
+
+template <typename Ops>
+static NodeSearchFn<typename Ops::Key> avx2_fn()
+{
+	NodeSearchFn<typename Ops::Key> const fn = {
+		&avx2_search<Ops, false>,
+		&avx2_search<Ops, true>
+	};
+
+	return fn;
+}
+
+#undef SSE2
+#undef AVX2
+
+#endif /*NODE_SEARCH_X86*/
+
+NodeSearchIsa node_search_best_isa()
+{
+#if defined(NODE_SEARCH_X86)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+		return node_search_avx2;
+	if (__builtin_cpu_supports("sse2"))
+		return node_search_sse2;
+#endif
+	return node_search_scalar;
+}
+
+NodeSearchIsa node_search_isa()
+{ return current_isa; }
+
+NodeSearchIsa node_search_use(NodeSearchIsa isa)
+{
+	NodeSearchIsa const best = node_search_best_isa();
+	NodeSearchTable table;
+
+	if (isa > best)
+		isa = best;
+
+	table.i32 = scalar_fn<int32_t>();
+	table.u32 = scalar_fn<uint32_t>();
+	table.i64 = scalar_fn<int64_t>();
+	table.u64 = scalar_fn<uint64_t>();
+	table.f32 = scalar_fn<float>();
+	table.f64 = scalar_fn<double>();
+
+#if defined(NODE_SEARCH_X86)
+	/* SSE2 has no 64 bit integer comparison */
+	if (isa == node_search_sse2) {
+		table.i32 = sse2_fn<Sse2Int32>();
+		table.u32 = sse2_fn<Sse2Uint32>();
+		table.f32 = sse2_fn<Sse2Float>();
+		table.f64 = sse2_fn<Sse2Double>();
+	}
+
+	if (isa == node_search_avx2) {
+		table.i32 = avx2_fn<Avx2Int32>();
+		table.u32 = avx2_fn<Avx2Uint32>();
+		table.i64 = avx2_fn<Avx2Int64>();
+		table.u64 = avx2_fn<Avx2Uint64>();
+		table.f32 = avx2_fn<Avx2Float>();
+		table.f64 = avx2_fn<Avx2Double>();
+	}
+#endif
+
+	node_search_table = table;
+	current_isa = isa;
+	return isa;
+}
+
+static NodeSearchIsa const startup_isa = node_search_use(
+					node_search_best_isa());
@@ -0,0 +1,101 @@
+#ifndef __NODE_SEARCH_HPP__
+#define __NODE_SEARCH_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * Search of a key in a sorted array of a wide tree node: lower returns the
+ * number of keys less than key, upper the number of keys not greater than
+ * key. Vector kernels compare key with a whole block of keys at once and
+ * count the bits of the mask, so the result doesn't depend on a single
+ * branch; the scalar fallback is a branchless binary search.
+ *
+ * Kernels are picked at start up for the best instruction set the CPU
+ * supports and can be switched with node_search_use (for tests and
+ * benchmarks, not while other threads search).
+ **/
+enum NodeSearchIsa {
+	node_search_scalar,
+	node_search_sse2,
+	node_search_avx2
+};
+
+NodeSearchIsa node_search_best_isa();
+NodeSearchIsa node_search_isa();
+
+/**
+ * Switches kernels to isa, or the best one the CPU supports if it
+ * doesn't support isa, returns the one in use.
+ **/
+NodeSearchIsa node_search_use(NodeSearchIsa isa);
+
+template <typename T>
+struct NodeSearchFn {
+	size_t (*lower)(T const *keys, size_t n, T key);
+	size_t (*upper)(T const *keys, size_t n, T key);
+};
+
+struct NodeSearchTable {
+	NodeSearchFn<int32_t> i32;
+	NodeSearchFn<uint32_t> u32;
+	NodeSearchFn<int64_t> i64;
+	NodeSearchFn<uint64_t> u64;
+	NodeSearchFn<float> f32;
+	NodeSearchFn<double> f64;
+};
+
+extern NodeSearchTable node_search_table;
+
+/**
+ * Types with search kernels.
+ **/
+template <typename T>
+struct NodeSearchKey : public std::false_type { };
+
+template <>
+struct NodeSearchKey<int32_t> : public std::true_type {
+	static NodeSearchFn<int32_t> const &fn()
+	{ return node_search_table.i32; }
+};
+
+template <>
+struct NodeSearchKey<uint32_t> : public std::true_type {
+	static NodeSearchFn<uint32_t> const &fn()
+	{ return node_search_table.u32; }
+};
+
+template <>
+struct NodeSearchKey<int64_t> : public std::true_type {
+	static NodeSearchFn<int64_t> const &fn()
+	{ return node_search_table.i64; }
+};
+
+template <>
+struct NodeSearchKey<uint64_t> : public std::true_type {
+	static NodeSearchFn<uint64_t> const &fn()
+	{ return node_search_table.u64; }
+};
+
+template <>
+struct NodeSearchKey<float> : public std::true_type {
+	static NodeSearchFn<float> const &fn()
+	{ return node_search_table.f32; }
+};
+
+template <>
+struct NodeSearchKey<double> : public std::true_type {
+	static NodeSearchFn<double> const &fn()
+	{ return node_search_table.f64; }
+};
+
+template <bool Upper, typename T>
+inline size_t node_search(T const *keys, size_t n, T key)
+{
+	NodeSearchFn<T> const &fn = NodeSearchKey<T>::fn();
+
+	return Upper ? fn.upper(keys, n, key) : fn.lower(keys, n, key);
+}
+
+#endif /*__NODE_SEARCH_HPP__*/
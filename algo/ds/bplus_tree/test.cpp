@@ -0,0 +1,372 @@
+#include "bplus_tree.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <set>
+#include <string>
+#include <vector>
+
+template <typename T>
+struct Id {
+	T const &operator()(T const &x) const
+	{ return x; }
+};
+
+/**
+ * Big keys leave room for 4 keys in an inner node and big values for 4
+ * values in a leaf, so small inputs already make deep trees.
+ **/
+struct BigKey {
+	int key;
+	char pad[60];
+
+	BigKey(int key = 0)
+	: key(key), pad()
+	{ }
+
+	bool operator<(BigKey const &other) const
+	{ return key < other.key; }
+
+	bool operator==(BigKey const &other) const
+	{ return key == other.key; }
+};
+
+/* not trivial, so lost or doubled values show up in sanitizers */
+struct Text {
+	std::string text;
+
+	Text(int key = 0)
+	: text(std::to_string(key))
+	{ text.resize(200, '.'); }
+
+	bool operator<(Text const &other) const
+	{ return key() < other.key(); }
+
+	bool operator==(Text const &other) const
+	{ return text == other.text; }
+
+	int key() const
+	{ return std::stoi(text); }
+};
+
+template <typename T>
+struct Traits {
+	static int key(T const &x)
+	{ return x; }
+};
+
+template <>
+struct Traits<BigKey> {
+	static int key(BigKey const &x)
+	{ return x.key; }
+};
+
+template <>
+struct Traits<Text> {
+	static int key(Text const &x)
+	{ return x.key(); }
+};
+
+using IntTree = BPlusTree<int, int, Id<int>, std::less<int>>;
+using BigTree = BPlusTree<BigKey, BigKey, Id<BigKey>, std::less<BigKey>>;
+using TextTree = BPlusTree<Text, Text, Id<Text>, std::less<Text>>;
+
+template <typename Tree, typename Check>
+void check_tree(Tree const &tree, Check const &check)
+{
+	using Val = typename Tree::value_type;
+
+	assert(tree.validate());
+	assert(tree.size() == check.size());
+	assert(tree.empty() == check.empty());
+	assert(std::equal(check.begin(), check.end(), tree.begin()));
+	assert(std::equal(check.rbegin(), check.rend(),
+		std::reverse_iterator<typename Tree::const_iterator>(
+			tree.end())));
+
+	int const limit = check.empty() ? 1
+			: Traits<Val>::key(*check.rbegin()) + 1;
+	for (int key = -1; key <= limit; ++key) {
+		Val const val(key);
+
+		typename Tree::const_iterator lower = tree.lower_bound(val);
+		typename Tree::const_iterator upper = tree.upper_bound(val);
+
+		/* neighbours of a bound tell its position */
+		assert((lower == tree.end()) ==
+			(check.lower_bound(val) == check.end()));
+		assert(lower == tree.end() || !(*lower < val));
+		assert(lower == tree.begin() || *std::prev(lower) < val);
+		assert((upper == tree.end()) ==
+			(check.upper_bound(val) == check.end()));
+		assert(upper == tree.end() || val < *upper);
+		assert(upper == tree.begin() || !(val < *std::prev(upper)));
+		assert(tree.count(val) == check.count(val));
+
+		if (check.count(val))
+			assert(*tree.find(val) == val);
+		else
+			assert(tree.find(val) == tree.end());
+	}
+}
+
+template <typename Tree>
+void run_random_test(size_t size, int keys)
+{
+	using Val = typename Tree::value_type;
+
+	Tree tree;
+	std::multiset<Val> check;
+
+	for (size_t i = 0; i != size; ++i) {
+		Val const val(rand() % keys);
+
+		typename Tree::iterator it = tree.insert(val);
+		check.insert(val);
+		assert(*it == val);
+		if (size <= 100)
+			assert(tree.validate());
+	}
+	check_tree(tree, check);
+
+	for (size_t i = 0; i != size; ++i) {
+		Val const val(rand() % keys);
+		typename Tree::iterator it = tree.find(val);
+
+		if (rand() % 3) {
+			if (it == tree.end())
+				continue;
+
+			/* erase returns the element after the erased one */
+			typename std::multiset<Val>::iterator next =
+				check.erase(check.find(val));
+			it = tree.erase(it);
+			assert((it == tree.end()) == (next == check.end()));
+			if (next != check.end())
+				assert(*it == *next);
+		} else {
+			tree.emplace(val);
+			check.insert(val);
+		}
+
+		if (size <= 100)
+			check_tree(tree, check);
+	}
+	check_tree(tree, check);
+
+	/* everything from the middle to the end and then the rest */
+	typename Tree::iterator mid = tree.begin();
+	std::advance(mid, tree.size() / 2);
+	typename std::multiset<Val>::iterator check_mid = check.begin();
+	std::advance(check_mid, check.size() / 2);
+	assert(tree.erase(mid, tree.end()) == tree.end());
+	check.erase(check_mid, check.end());
+	check_tree(tree, check);
+
+	while (!tree.empty()) {
+		typename Tree::iterator last = tree.end();
+		tree.erase(--last);
+		check.erase(--check.end());
+		if (size <= 1000)
+			assert(tree.validate());
+	}
+	check_tree(tree, check);
+	assert(tree.height() == 0);
+}
+
+template <typename Tree>
+void run_order_test(size_t size)
+{
+	using Val = typename Tree::value_type;
+
+	std::vector<Val> source;
+	for (size_t i = 0; i != size; ++i)
+		source.push_back(Val(static_cast<int>(i)));
+
+	Tree ascending(source.begin(), source.end());
+	Tree descending(source.rbegin(), source.rend());
+	std::multiset<Val> check(source.begin(), source.end());
+
+	check_tree(ascending, check);
+	check_tree(descending, check);
+
+	/* the first leaf keeps borrowing from and merging with the next */
+	for (size_t i = 2; i < size; ++i) {
+		typename Tree::iterator it = ascending.erase(
+					std::next(ascending.begin()));
+
+		assert(*it == Val(static_cast<int>(i)));
+		if (size <= 1000)
+			assert(ascending.validate());
+	}
+	assert(ascending.validate());
+
+	ascending.erase(ascending.begin(), ascending.end());
+	assert(ascending.empty());
+	assert(ascending.validate());
+
+	/* one key all over the leaves */
+	Tree same;
+	for (size_t i = 0; i != size; ++i)
+		same.insert(Val(1));
+	assert(same.count(Val(1)) == size);
+	assert(same.validate());
+	assert(same.find(Val(0)) == same.end());
+	assert(same.lower_bound(Val(2)) == same.end());
+	while (same.size() > size / 2)
+		same.erase(same.find(Val(1)));
+	assert(same.count(Val(1)) == size / 2);
+	assert(same.validate());
+}
+
+template <typename Tree>
+void run_move_test(size_t size)
+{
+	using Val = typename Tree::value_type;
+
+	std::vector<Val> source;
+	for (size_t i = 0; i != size; ++i)
+		source.push_back(Val(rand() % static_cast<int>(size + 1)));
+	std::multiset<Val> const check(source.begin(), source.end());
+
+	Tree tree(source.begin(), source.end());
+	Tree moved(std::move(tree));
+	check_tree(moved, check);
+	check_tree(tree, std::multiset<Val>());
+
+	Tree other;
+	other.insert(Val(42));
+	other.swap(moved);
+	check_tree(other, check);
+	check_tree(moved, std::multiset<Val>{Val(42)});
+
+	moved = std::move(other);
+	check_tree(moved, check);
+	check_tree(other, std::multiset<Val>());
+
+	/* moved from trees are usable */
+	other.insert(Val(1));
+	tree.insert(Val(2));
+	assert(*other.begin() == Val(1));
+	assert(*tree.begin() == Val(2));
+}
+
+/**
+ * Kernels against std::lower_bound and std::upper_bound on sorted arrays
+ * of every length up to a few blocks, with duplicates and extreme keys.
+ **/
+template <typename T>
+void run_node_search_test()
+{
+	std::vector<T> const special = {
+		std::numeric_limits<T>::lowest(), std::numeric_limits<T>::max(),
+		T(0), T(1), static_cast<T>(-1)
+	};
+
+	for (size_t n = 0; n != 70; ++n) {
+		std::vector<T> keys;
+		for (size_t i = 0; i != n; ++i)
+			keys.push_back(rand() % 5 ? static_cast<T>(rand() % 40)
+					: special[rand() % special.size()]);
+		std::sort(keys.begin(), keys.end());
+
+		std::vector<T> probes(special);
+		for (int i = -1; i != 41; ++i)
+			probes.push_back(static_cast<T>(i));
+
+		for (T probe : probes) {
+			size_t const lower = std::lower_bound(keys.begin(),
+					keys.end(), probe) - keys.begin();
+			size_t const upper = std::upper_bound(keys.begin(),
+					keys.end(), probe) - keys.begin();
+
+			assert(node_search<false>(keys.data(), n, probe)
+					== lower);
+			assert(node_search<true>(keys.data(), n, probe)
+					== upper);
+		}
+	}
+}
+
+template <typename T>
+void run_packed_tree_test(size_t size)
+{
+	using Tree = BPlusTree<T, T, Id<T>, std::less<T>>;
+
+	Tree tree;
+	std::multiset<T> check;
+
+	for (size_t i = 0; i != size; ++i) {
+		/* the upper half of unsigned keys compares as negative */
+		T const val = static_cast<T>(rand() % 64) * (rand() % 2
+			? static_cast<T>(1) : std::numeric_limits<T>::max()
+					/ 128);
+
+		tree.insert(val);
+		check.insert(val);
+	}
+	assert(tree.validate());
+	assert(std::equal(check.begin(), check.end(), tree.begin()));
+
+	for (T val : check) {
+		assert(*tree.lower_bound(val) == val);
+		assert(tree.count(val) == check.count(val));
+		assert(tree.upper_bound(val) == tree.end()
+			|| val < *tree.upper_bound(val));
+	}
+}
+
+int main()
+{
+	for (int isa = node_search_scalar; isa <= node_search_best_isa();
+				++isa) {
+		NodeSearchIsa const used = node_search_use(
+					static_cast<NodeSearchIsa>(isa));
+
+		assert(used == isa);
+
+		run_node_search_test<int32_t>();
+		run_node_search_test<uint32_t>();
+		run_node_search_test<int64_t>();
+		run_node_search_test<uint64_t>();
+		run_node_search_test<float>();
+		run_node_search_test<double>();
+
+		run_packed_tree_test<int32_t>(10000);
+		run_packed_tree_test<uint32_t>(10000);
+		run_packed_tree_test<int64_t>(10000);
+		run_packed_tree_test<uint64_t>(10000);
+		run_packed_tree_test<float>(10000);
+		run_packed_tree_test<double>(10000);
+		run_random_test<IntTree>(10000, 5000);
+	}
+	node_search_use(node_search_best_isa());
+
+	size_t const sizes[] = {0, 1, 2, 3, 10, 100, 1000, 10000};
+
+	for (size_t size : sizes) {
+		int const keys = static_cast<int>(size / 2 + 1);
+
+		run_random_test<IntTree>(size, keys);
+		run_random_test<BigTree>(size, keys);
+		run_order_test<IntTree>(size);
+		run_order_test<BigTree>(size);
+		run_move_test<IntTree>(size);
+		run_move_test<BigTree>(size);
+
+		if (size <= 1000) {
+			run_random_test<TextTree>(size, keys);
+			run_order_test<TextTree>(size);
+			run_move_test<TextTree>(size);
+		}
+	}
+	run_random_test<IntTree>(100000, 1000);
+
+	std::cout << "test is successfully passed" << std::endl;
+
+	return 0;
+}
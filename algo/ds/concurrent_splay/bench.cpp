@@ -0,0 +1,137 @@
+#include "concurrent_splay_tree.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+template <typename T>
+struct Ident
+{
+	T const & operator()(T const & t) const
+	{ return t; }
+};
+
+typedef SplayTree<int, int, Ident<int>, std::less<int> > Tree;
+typedef ConcurrentSplayTree<int, int, Ident<int>, std::less<int> >
+			ConcurrentTree;
+
+/**
+ * What the lookup service does today: splaying find under a single mutex.
+ **/
+class MutexTree
+{
+public:
+	explicit MutexTree(size_t)
+	{ }
+
+	void insert(int key)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_tree.insert(key);
+	}
+
+	bool contains(int key)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		return m_tree.find(key) != m_tree.end();
+	}
+
+private:
+	std::mutex m_lock;
+	Tree m_tree;
+};
+
+/**
+ * Skewed workload: 90% of lookups hit 1% of keys.
+ **/
+std::vector<int> SkewedKeys(size_t keys, size_t lookups, unsigned seed)
+{
+	std::mt19937 gen(seed);
+	size_t const hot = std::max(keys / 100, static_cast<size_t>(1));
+	std::vector<int> res;
+
+	res.reserve(lookups);
+	for (size_t i = 0; i != lookups; ++i)
+	{
+		if (gen() % 10)
+			res.push_back(static_cast<int>(gen() % hot));
+		else
+			res.push_back(static_cast<int>(gen() % keys));
+	}
+
+	return res;
+}
+
+/**
+ * Returns lookups per second with specified number of reader threads.
+ **/
+template <typename TreeType>
+double RunReaders(std::vector<int> const & keys, size_t lookups,
+			size_t readers, size_t period)
+{
+	TreeType tree(period);
+	for (size_t i = 0; i != keys.size(); ++i)
+		tree.insert(keys[i]);
+
+	std::vector< std::vector<int> > probes;
+	for (size_t r = 0; r != readers; ++r)
+		probes.push_back(SkewedKeys(keys.size(), lookups,
+					static_cast<unsigned>(r)));
+
+	std::vector<std::thread> threads;
+	std::vector<size_t> found(readers);
+
+	auto const start = std::chrono::steady_clock::now();
+	for (size_t r = 0; r != readers; ++r)
+	{
+		threads.emplace_back([&tree, &probes, &found, r] {
+			std::vector<int> const & p = probes[r];
+			size_t hits = 0;
+			for (size_t i = 0; i != p.size(); ++i)
+				hits += tree.contains(p[i]);
+			found[r] = hits;
+		});
+	}
+	for (size_t r = 0; r != readers; ++r)
+		threads[r].join();
+	auto const stop = std::chrono::steady_clock::now();
+
+	return readers * lookups /
+		std::chrono::duration<double>(stop - start).count();
+}
+
+int main(int argc, char **argv)
+{
+	size_t const keys = argc > 1 ? atol(argv[1]) : 1000000;
+	size_t const lookups = argc > 2 ? atol(argv[2]) : 1000000;
+	size_t const cores = std::max(std::thread::hardware_concurrency(), 1u);
+
+	std::vector<int> input;
+	input.reserve(keys);
+	for (size_t i = 0; i != keys; ++i)
+		input.push_back(static_cast<int>(i));
+	std::shuffle(input.begin(), input.end(), std::mt19937());
+
+	std::cout << keys << " keys, " << lookups
+		<< " skewed lookups per reader, Mlookups/s" << std::endl;
+	std::cout << "readers\tmutex\tshared\tshared, splay 1/64" << std::endl;
+
+	for (size_t readers = 1; readers <= cores; readers *= 2)
+	{
+		std::cout << readers << "\t"
+			<< RunReaders<MutexTree>(input, lookups, readers, 0)
+				/ 1e6 << "\t"
+			<< RunReaders<ConcurrentTree>(input, lookups, readers,
+				0) / 1e6 << "\t"
+			<< RunReaders<ConcurrentTree>(input, lookups, readers,
+				64) / 1e6 << std::endl;
+	}
+
+	return 0;
+}
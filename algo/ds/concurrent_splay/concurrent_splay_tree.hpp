@@ -0,0 +1,160 @@
+#ifndef __CONCURRENT_SPLAY_TREE_HPP__
+#define __CONCURRENT_SPLAY_TREE_HPP__
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+
+#include "../splay/splay_tree.hpp"
+
+/**
+ * Read-mostly front-end for SplayTree. Every lookup in SplayTree splays, so
+ * even readers need exclusive access. Here lookups go through non-splaying
+ * SplayTree::find under a shared lock, so readers run in parallel, and only
+ * writers take the lock exclusively.
+ *
+ * Splaying on reads is throttled by splay_period: with zero reads never
+ * splay, otherwise every splay_period-th lookup in the tree that found the
+ * key tries to splay it to the root. The try doesn't block: if the lock
+ * can't be taken exclusively right away (somebody else reads or writes) the
+ * splay is just skipped, so hot keys still move up the tree when readers
+ * leave it alone for a moment, but readers never wait for each other.
+ *
+ * Values are returned by copy or visited under the lock: iterators into the
+ * tree would be invalidated by concurrent writers.
+ **/
+template < typename Key, typename Val, typename KeyVal, typename Cmp,
+			typename Alloc = std::allocator<Val>,
+			typename Policy = BottomUpSplay >
+class ConcurrentSplayTree
+{
+public:
+	typedef SplayTree<Key, Val, KeyVal, Cmp, Alloc, Policy> tree_type;
+	typedef Key key_type;
+	typedef Val value_type;
+	typedef size_t size_type;
+
+	explicit ConcurrentSplayTree(size_t splay_period = 0)
+		: m_period(splay_period)
+		, m_reads(0)
+	{ }
+
+	ConcurrentSplayTree(ConcurrentSplayTree const &) = delete;
+	ConcurrentSplayTree & operator=(ConcurrentSplayTree const &) = delete;
+
+	void set_splay_period(size_t splay_period) throw()
+	{
+		m_period.store(splay_period, std::memory_order_relaxed);
+	}
+
+	size_t splay_period() const throw()
+	{
+		return m_period.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Calls f(value) for the element with key k under the shared lock,
+	 * returns false if there is no such element.
+	 **/
+	template <typename F>
+	bool visit(Key const & k, F f) const
+	{
+		{
+			std::shared_lock<std::shared_timed_mutex> lock(m_lock);
+			tree_type const & tree = m_tree;
+			typename tree_type::const_iterator const it =
+						tree.find(k);
+
+			if (it == tree.end())
+				return false;
+			f(*it);
+		}
+
+		MaybeSplay(k);
+		return true;
+	}
+
+	bool find(Key const & k, value_type & val) const
+	{
+		return visit(k, [&val] (value_type const & v) { val = v; });
+	}
+
+	bool contains(Key const & k) const
+	{
+		return visit(k, [] (value_type const &) { });
+	}
+
+	bool insert_unique(value_type const & val)
+	{
+		std::unique_lock<std::shared_timed_mutex> lock(m_lock);
+		return m_tree.insert_unique(val).second;
+	}
+
+	void insert(value_type const & val)
+	{
+		std::unique_lock<std::shared_timed_mutex> lock(m_lock);
+		m_tree.insert(val);
+	}
+
+	/**
+	 * Erases one element with key k, returns number of erased elements.
+	 **/
+	size_t erase(Key const & k)
+	{
+		std::unique_lock<std::shared_timed_mutex> lock(m_lock);
+		typename tree_type::iterator const it = m_tree.find(k);
+
+		if (it == m_tree.end())
+			return 0;
+
+		m_tree.erase(it);
+		return 1;
+	}
+
+	void clear()
+	{
+		std::unique_lock<std::shared_timed_mutex> lock(m_lock);
+		m_tree.clear();
+	}
+
+	size_t size() const
+	{
+		std::shared_lock<std::shared_timed_mutex> lock(m_lock);
+		return m_tree.size();
+	}
+
+	/**
+	 * Calls f(tree) with exclusive access to the underlying tree, e. g.
+	 * for iteration or bulk updates.
+	 **/
+	template <typename F>
+	void apply(F f)
+	{
+		std::unique_lock<std::shared_timed_mutex> lock(m_lock);
+		f(m_tree);
+	}
+
+private:
+	void MaybeSplay(Key const & k) const
+	{
+		size_t const period = m_period.load(std::memory_order_relaxed);
+
+		if (!period || (m_reads.fetch_add(1, std::memory_order_relaxed)
+					+ 1) % period)
+			return;
+
+		std::unique_lock<std::shared_timed_mutex> lock(m_lock,
+					std::try_to_lock);
+		if (lock)
+			m_tree.find(k);
+	}
+
+	mutable std::shared_timed_mutex m_lock;
+	mutable tree_type m_tree;
+	std::atomic<size_t> m_period;
+	mutable std::atomic<size_t> m_reads;
+};
+
+#endif /*__CONCURRENT_SPLAY_TREE_HPP__*/
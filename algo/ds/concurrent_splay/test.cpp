@@ -0,0 +1,183 @@
+#include "concurrent_splay_tree.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <set>
+#include <thread>
+#include <vector>
+
+template <typename T>
+struct Ident
+{
+	T const & operator()(T const & t) const
+	{ return t; }
+};
+
+typedef ConcurrentSplayTree<int, int, Ident<int>, std::less<int> > TreeType;
+typedef ConcurrentSplayTree<int, int, Ident<int>, std::less<int>,
+			std::allocator<int>, TopDownSplay> TopDownTreeType;
+
+template <typename TreeType>
+void RunSerialTest(size_t size, size_t period)
+{
+	TreeType tree(period);
+	std::set<int> check;
+
+	for (size_t i = 0; i != size; ++i)
+	{
+		int const key = rand() % static_cast<int>(size);
+		assert(tree.insert_unique(key) == check.insert(key).second);
+	}
+	assert(tree.size() == check.size());
+
+	for (size_t i = 0; i != size; ++i)
+	{
+		int const key = rand() % static_cast<int>(size);
+		int value = -1;
+		bool const found = check.count(key);
+
+		assert(tree.contains(key) == found);
+		assert(tree.find(key, value) == found);
+		assert(!found || value == key);
+	}
+
+	for (size_t i = 0; i != size / 2; ++i)
+	{
+		int const key = rand() % static_cast<int>(size);
+		assert(tree.erase(key) == check.erase(key));
+	}
+
+	tree.apply([&check] (typename TreeType::tree_type & t) {
+		assert(t.size() == check.size());
+		assert(std::equal(check.begin(), check.end(), t.begin()));
+	});
+
+	tree.clear();
+	assert(tree.size() == 0);
+}
+
+/**
+ * Readers look up even keys that are always in the tree while a writer
+ * inserts and erases odd keys.
+ **/
+template <typename TreeType>
+void RunConcurrentTest(size_t size, size_t readers, size_t period)
+{
+	TreeType tree(period);
+
+	for (size_t i = 0; i < size; i += 2)
+		tree.insert(static_cast<int>(i));
+
+	std::vector<std::thread> threads;
+	for (size_t r = 0; r != readers; ++r)
+	{
+		threads.emplace_back([&tree, size, r] {
+			for (size_t i = 0; i != 10 * size; ++i)
+			{
+				int const key = static_cast<int>(
+						(i * 2 + r * 2) % size) & ~1;
+				int value = -1;
+
+				assert(tree.find(key, value));
+				assert(value == key);
+			}
+		});
+	}
+
+	threads.emplace_back([&tree, size] {
+		for (size_t i = 1; i < size; i += 2)
+			tree.insert(static_cast<int>(i));
+		for (size_t i = 1; i < size; i += 4)
+			assert(tree.erase(static_cast<int>(i)) == 1);
+	});
+
+	for (size_t i = 0; i != threads.size(); ++i)
+		threads[i].join();
+
+	std::set<int> check;
+	for (size_t i = 0; i < size; ++i)
+		if (i % 2 == 0 || i % 4 == 3)
+			check.insert(static_cast<int>(i));
+
+	tree.apply([&check] (typename TreeType::tree_type & t) {
+		assert(t.size() == check.size());
+		assert(std::equal(check.begin(), check.end(), t.begin()));
+	});
+}
+
+struct CountingLess
+{
+	bool operator()(int lhs, int rhs) const
+	{
+		++s_calls;
+		return lhs < rhs;
+	}
+
+	static size_t s_calls;
+};
+
+size_t CountingLess::s_calls = 0;
+
+typedef ConcurrentSplayTree<int, int, Ident<int>, CountingLess>
+			CountingTreeType;
+
+/**
+ * Lookups are counted per tree: lookups interleaved between two trees with
+ * splay_period of 2 splay the key to the root of both.
+ **/
+void RunPeriodTest()
+{
+	CountingTreeType first(2);
+	CountingTreeType second(2);
+
+	for (int i = 0; i != 1000; ++i)
+	{
+		first.insert(i);
+		second.insert(i);
+	}
+
+	for (int i = 0; i != 2; ++i)
+	{
+		assert(first.contains(0));
+		assert(second.contains(0));
+	}
+
+	CountingTreeType * const trees[] = {&first, &second};
+	for (size_t i = 0; i != 2; ++i)
+	{
+		trees[i]->apply([] (CountingTreeType::tree_type & t) {
+			CountingTreeType::tree_type const & tree = t;
+
+			CountingLess::s_calls = 0;
+			assert(tree.find(0) != tree.end());
+			assert(CountingLess::s_calls <= 2);
+		});
+	}
+}
+
+int main()
+{
+	size_t const sizes[] = {1, 10, 100, 1000, 10000};
+	size_t const periods[] = {0, 1, 16};
+
+	for (size_t i = 0; i != sizeof(sizes) / sizeof(sizes[0]); ++i)
+	{
+		for (size_t j = 0; j != sizeof(periods) / sizeof(periods[0]); ++j)
+		{
+			RunSerialTest<TreeType>(sizes[i], periods[j]);
+			RunSerialTest<TopDownTreeType>(sizes[i], periods[j]);
+			RunConcurrentTest<TreeType>(sizes[i], 4, periods[j]);
+			RunConcurrentTest<TopDownTreeType>(sizes[i], 4,
+						periods[j]);
+		}
+	}
+
+	RunPeriodTest();
+
+	std::cout << "test is successfully passed" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,146 @@
+#include "flat_file.hpp"
+
+#include "../simple-bst/bst.hpp"
+#include "../splay/splay_tree.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <vector>
+
+template <typename T>
+struct Id {
+	T const &operator()(T const &x) const
+	{ return x; }
+};
+
+using View = FlatView<int, int, Id<int>, std::less<int>>;
+using SplayTreeType = SplayTree<int, int, Id<int>, std::less<int>>;
+using RBTree = BinarySearchTree<int, int, Id<int>, std::less<int>,
+			std::allocator<int>, RedBlackBalance>;
+
+char const flat_path[] = "bench.bin";
+char const stream_path[] = "bench_stream.bin";
+
+template <typename F>
+double measure(F f)
+{
+	auto const start = std::chrono::steady_clock::now();
+	f();
+	auto const stop = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double>(stop - start).count();
+}
+
+/**
+ * The way it was done before: values are written and read back one at a
+ * time and every one of them is inserted into the tree.
+ **/
+template <typename Tree>
+void stream_save(Tree const &tree)
+{
+	std::ofstream out(stream_path, std::ios::binary);
+
+	for (int const &value : tree)
+		out.write(reinterpret_cast<char const *>(&value),
+					sizeof(value));
+}
+
+template <typename Tree>
+size_t stream_load(Tree &tree)
+{
+	std::ifstream in(stream_path, std::ios::binary);
+	int value;
+
+	while (in.read(reinterpret_cast<char *>(&value), sizeof(value)))
+		tree.insert(value);
+	return tree.size();
+}
+
+void run_restart(size_t size, size_t lookups)
+{
+	std::mt19937 gen(size);
+	std::vector<int> keys(size);
+	for (size_t i = 0; i != size; ++i)
+		keys[i] = static_cast<int>(2 * i);
+	std::shuffle(keys.begin(), keys.end(), gen);
+
+	RBTree const tree(keys.begin(), keys.end());
+	size_t check = 0;
+
+	double const stream_save_time = measure([&] { stream_save(tree); });
+	double const flat_save_time = measure([&] {
+		save_flat(flat_path, tree);
+	});
+
+	double const stream_rb_time = measure([&] {
+		RBTree loaded;
+		check += stream_load(loaded);
+	});
+	double const flat_rb_time = measure([&] {
+		FlatFile<int> file(flat_path);
+
+		file.will_need();
+		RBTree loaded(sorted_input, file.begin(), file.end());
+		check += loaded.size();
+	});
+
+	double const stream_splay_time = measure([&] {
+		SplayTreeType loaded;
+		check += stream_load(loaded);
+	});
+	double const flat_splay_time = measure([&] {
+		FlatFile<int> file(flat_path);
+
+		file.will_need();
+		SplayTreeType loaded(sorted_unique, file.begin(), file.end());
+		check += loaded.size();
+	});
+
+	/* open and answer the first lookups right from the mapping */
+	std::uniform_int_distribution<int> dist(0, static_cast<int>(2 * size));
+	double const view_time = measure([&] {
+		View const view(flat_path);
+
+		for (size_t i = 0; i != lookups; ++i)
+			check += view.count(dist(gen));
+	});
+
+	if (check < 4 * size)
+		std::cout << "lost some values!" << std::endl;
+
+	std::cout << size << "\t" << stream_save_time << "\t" << flat_save_time
+		<< "\t" << stream_rb_time << "\t" << flat_rb_time
+		<< "\t" << stream_splay_time << "\t" << flat_splay_time
+		<< "\t" << view_time << std::endl;
+
+	std::remove(flat_path);
+	std::remove(stream_path);
+}
+
+int main(int argc, char **argv)
+{
+	size_t const lookups = argc > 1 ? atol(argv[1]) : 1000;
+	std::vector<size_t> sizes;
+
+	for (int i = 2; i < argc; ++i)
+		sizes.push_back(atol(argv[i]));
+	if (sizes.empty()) {
+		sizes.push_back(100000);
+		sizes.push_back(1000000);
+		sizes.push_back(10000000);
+	}
+
+	std::cout << "save and load of a tree of int, seconds, view: open and "
+		<< lookups << " lookups" << std::endl;
+	std::cout << "keys\tsave stream\tsave flat\tRB insert\tRB flat"
+		<< "\tsplay insert\tsplay flat\tview" << std::endl;
+	for (size_t size : sizes)
+		run_restart(size, lookups);
+
+	return 0;
+}
@@ -0,0 +1,216 @@
+#include "flat_file.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static void throw_errno(std::string const &what)
+{ throw std::system_error(errno, std::generic_category(), what); }
+
+static void write_all(int fd, char const *data, size_t size,
+			std::string const &path)
+{
+	while (size) {
+		ssize_t const written = ::write(fd, data, size);
+
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			throw_errno(path);
+		}
+
+		data += written;
+		size -= static_cast<size_t>(written);
+	}
+}
+
+/* rename is durable only once the directory holding the file is synced */
+static void sync_parent_dir(std::string const &path)
+{
+	std::string::size_type const slash = path.rfind('/');
+	std::string const dir = slash == std::string::npos ? "."
+		: slash == 0 ? "/" : path.substr(0, slash);
+	int const fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+
+	if (fd < 0)
+		throw_errno(dir);
+
+	if (::fsync(fd) < 0) {
+		int const error = errno;
+
+		::close(fd);
+		errno = error;
+		throw_errno(dir);
+	}
+	::close(fd);
+}
+
+FlatFileWriter::FlatFileWriter(char const *path, size_t value_size)
+: path(path)
+, tmp_path(std::string(path) + ".tmp")
+, buffer(std::max(static_cast<size_t>(1) << 16, value_size))
+, value_size(value_size)
+, used(flat_file_data_offset)
+, count(0)
+, fd(-1)
+{
+	fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		throw_errno(tmp_path);
+
+	/* the header is written on commit, when count is known */
+	std::memset(buffer.data(), 0, flat_file_data_offset);
+}
+
+FlatFileWriter::~FlatFileWriter()
+{
+	if (fd < 0)
+		return;
+
+	::close(fd);
+	::unlink(tmp_path.c_str());
+}
+
+void FlatFileWriter::flush()
+{
+	write_all(fd, buffer.data(), used, tmp_path);
+	used = 0;
+}
+
+void FlatFileWriter::append(void const *value)
+{
+	if (buffer.size() - used < value_size)
+		flush();
+
+	std::memcpy(buffer.data() + used, value, value_size);
+	used += value_size;
+	++count;
+}
+
+void FlatFileWriter::commit()
+{
+	FlatFileHeader header;
+
+	flush();
+
+	std::memset(&header, 0, sizeof(header));
+	header.magic = flat_file_magic;
+	header.version = flat_file_version;
+	header.value_size = static_cast<uint32_t>(value_size);
+	header.count = count;
+
+	if (::lseek(fd, 0, SEEK_SET) < 0)
+		throw_errno(tmp_path);
+	write_all(fd, reinterpret_cast<char const *>(&header),
+				sizeof(header), tmp_path);
+
+	if (::fsync(fd) < 0)
+		throw_errno(tmp_path);
+	if (::rename(tmp_path.c_str(), path.c_str()) < 0)
+		throw_errno(path);
+
+	::close(fd);
+	fd = -1;
+	sync_parent_dir(path);
+}
+
+MappedFlatFile::MappedFlatFile(char const *path, size_t value_size)
+: base(0), length(0), count(0)
+{
+	int const fd = ::open(path, O_RDONLY);
+	struct stat st;
+
+	if (fd < 0)
+		throw_errno(path);
+
+	if (::fstat(fd, &st) < 0) {
+		int const error = errno;
+
+		::close(fd);
+		errno = error;
+		throw_errno(path);
+	}
+
+	length = static_cast<size_t>(st.st_size);
+	if (length < flat_file_data_offset) {
+		::close(fd);
+		throw std::runtime_error(std::string(path)
+					+ ": not a flat file");
+	}
+
+	void *const addr = ::mmap(0, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	int const error = errno;
+
+	::close(fd);
+	if (addr == MAP_FAILED) {
+		errno = error;
+		throw_errno(path);
+	}
+	base = addr;
+
+	FlatFileHeader header;
+	std::memcpy(&header, base, sizeof(header));
+
+	char const *problem = 0;
+	if (header.magic != flat_file_magic)
+		problem = ": not a flat file";
+	else if (header.version != flat_file_version)
+		problem = ": unsupported flat file version";
+	else if (header.value_size != value_size)
+		problem = ": flat file holds values of another size";
+	else if (header.count > (length - flat_file_data_offset) / value_size)
+		problem = ": flat file is truncated";
+
+	if (problem) {
+		unmap();
+		throw std::runtime_error(std::string(path) + problem);
+	}
+
+	count = static_cast<size_t>(header.count);
+}
+
+MappedFlatFile::~MappedFlatFile()
+{ unmap(); }
+
+MappedFlatFile::MappedFlatFile(MappedFlatFile &&other)
+: base(other.base), length(other.length), count(other.count)
+{
+	other.base = 0;
+	other.length = 0;
+	other.count = 0;
+}
+
+MappedFlatFile &MappedFlatFile::operator=(MappedFlatFile &&other)
+{
+	if (this != &other) {
+		unmap();
+		std::swap(base, other.base);
+		std::swap(length, other.length);
+		std::swap(count, other.count);
+	}
+	return *this;
+}
+
+void MappedFlatFile::will_need() const
+{
+	if (!base)
+		return;
+
+	::madvise(base, length, MADV_SEQUENTIAL);
+	::madvise(base, length, MADV_WILLNEED);
+}
+
+void MappedFlatFile::unmap()
+{
+	if (base)
+		::munmap(base, length);
+	base = 0;
+	length = 0;
+	count = 0;
+}
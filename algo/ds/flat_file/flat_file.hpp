@@ -0,0 +1,281 @@
+#ifndef __FLAT_FILE_HPP__
+#define __FLAT_FILE_HPP__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * Flat file is a header followed by an array of trivially copyable values
+ * stored as they are in memory, so the file is only readable on machines
+ * with the same byte order and layout of the type (magic is stored in host
+ * byte order and rejects files of the other one). Values start at
+ * flat_file_data_offset, so the mapping is aligned for them.
+ **/
+struct FlatFileHeader {
+	uint64_t magic;
+	uint32_t version;
+	uint32_t value_size;
+	uint64_t count;
+};
+
+uint64_t const flat_file_magic = 0x454c4946544c4146ULL; /* "FLATFILE" */
+uint32_t const flat_file_version = 1;
+size_t const flat_file_data_offset = 64;
+
+/**
+ * Writes a flat file to path.tmp and renames it to path when all values
+ * are written and synced, so readers never see a partial file. commit
+ * syncs the directory after rename, so the file survives a crash once
+ * commit returns. If writer is destroyed without commit the temporary file
+ * is removed. All errors are reported with std::system_error.
+ **/
+class FlatFileWriter {
+public:
+	FlatFileWriter(char const *path, size_t value_size);
+	~FlatFileWriter();
+
+	FlatFileWriter(FlatFileWriter const &) = delete;
+	FlatFileWriter &operator=(FlatFileWriter const &) = delete;
+
+	void append(void const *value);
+	void commit();
+
+private:
+	void flush();
+
+	std::string path;
+	std::string tmp_path;
+	std::vector<char> buffer;
+	size_t value_size;
+	size_t used;
+	uint64_t count;
+	int fd;
+};
+
+/**
+ * Read-only private mapping of a flat file with values of value_size
+ * bytes. Header is checked on open, wrong files are reported with
+ * std::runtime_error, failures of the system calls with std::system_error.
+ **/
+class MappedFlatFile {
+public:
+	MappedFlatFile(char const *path, size_t value_size);
+	~MappedFlatFile();
+
+	MappedFlatFile(MappedFlatFile &&other);
+	MappedFlatFile &operator=(MappedFlatFile &&other);
+
+	MappedFlatFile(MappedFlatFile const &) = delete;
+	MappedFlatFile &operator=(MappedFlatFile const &) = delete;
+
+	void const *data() const
+	{ return static_cast<char const *>(base) + flat_file_data_offset; }
+
+	size_t size() const
+	{ return count; }
+
+	/**
+	 * Asks the kernel to read the whole file ahead, useful before a
+	 * sequential scan (e. g. loading into a tree).
+	 **/
+	void will_need() const;
+
+private:
+	void unmap();
+
+	void *base;
+	size_t length;
+	size_t count;
+};
+
+/**
+ * Saves [first, last) to a flat file, for a tree (or any other sorted
+ * container) the values are written in sorted order, so the file can be
+ * loaded back in linear time:
+ *
+ *	save_flat("tree.bin", tree.begin(), tree.end());
+ *	FlatFile<int> file("tree.bin");
+ *	Tree tree(sorted_input, file.begin(), file.end());
+ *	SplayTreeType splay(sorted_unique, file.begin(), file.end());
+ *
+ * or searched right in the mapping with FlatView.
+ **/
+template <typename It>
+void save_flat(char const *path, It first, It last)
+{
+	using Val = typename std::iterator_traits<It>::value_type;
+
+	static_assert(std::is_trivially_copyable<Val>::value,
+		"only trivially copyable values can be saved to a flat file");
+	static_assert(alignof(Val) <= flat_file_data_offset,
+		"values are aligned to flat_file_data_offset at most");
+
+	FlatFileWriter writer(path, sizeof(Val));
+
+	for (; first != last; ++first) {
+		Val const &value = *first;
+
+		writer.append(std::addressof(value));
+	}
+	writer.commit();
+}
+
+template <typename Container>
+void save_flat(char const *path, Container const &ct)
+{ save_flat(path, ct.begin(), ct.end()); }
+
+/**
+ * Array of values of a mapped flat file, the values stay valid while the
+ * FlatFile lives.
+ **/
+template <typename Val>
+class FlatFile {
+	static_assert(std::is_trivially_copyable<Val>::value,
+		"only trivially copyable values can be read from a flat file");
+
+public:
+	using value_type = Val;
+	using const_iterator = Val const *;
+	using iterator = const_iterator;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+	using reverse_iterator = const_reverse_iterator;
+	using reference = Val const &;
+	using const_reference = Val const &;
+	using size_type = size_t;
+
+	explicit FlatFile(char const *path)
+	: file(path, sizeof(Val))
+	{ }
+
+	void swap(FlatFile &other)
+	{ std::swap(file, other.file); }
+
+	bool empty() const
+	{ return file.size() == 0; }
+
+	size_t size() const
+	{ return file.size(); }
+
+	Val const *data() const
+	{ return static_cast<Val const *>(file.data()); }
+
+	Val const &operator[](size_t i) const
+	{ return data()[i]; }
+
+	const_iterator begin() const
+	{ return data(); }
+
+	const_iterator end() const
+	{ return data() + size(); }
+
+	const_reverse_iterator rbegin() const
+	{ return const_reverse_iterator(end()); }
+
+	const_reverse_iterator rend() const
+	{ return const_reverse_iterator(begin()); }
+
+	void will_need() const
+	{ file.will_need(); }
+
+private:
+	MappedFlatFile file;
+};
+
+/**
+ * Read-only sorted set served right from a mapped flat file saved from a
+ * tree: opening costs only the mapping and pages are read on demand, so
+ * queries can start right away instead of after a rebuild. Lookups are
+ * binary searches, the file is trusted to be sorted by KeyCmp.
+ **/
+template <typename Key, typename Val, typename KeyOf, typename KeyCmp>
+class FlatView {
+	using Self = FlatView<Key, Val, KeyOf, KeyCmp>;
+
+public:
+	using key_type = Key;
+	using value_type = Val;
+	using const_iterator = typename FlatFile<Val>::const_iterator;
+	using iterator = const_iterator;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+	using reverse_iterator = const_reverse_iterator;
+	using reference = Val const &;
+	using const_reference = Val const &;
+	using size_type = size_t;
+
+	explicit FlatView(char const *path, KeyCmp const &cmp = KeyCmp())
+	: file(path), cmp(cmp)
+	{ }
+
+	void swap(Self &other)
+	{
+		using std::swap;
+		file.swap(other.file);
+		swap(cmp, other.cmp);
+	}
+
+	bool empty() const
+	{ return file.empty(); }
+
+	size_t size() const
+	{ return file.size(); }
+
+	const_iterator begin() const
+	{ return file.begin(); }
+
+	const_iterator end() const
+	{ return file.end(); }
+
+	const_reverse_iterator rbegin() const
+	{ return file.rbegin(); }
+
+	const_reverse_iterator rend() const
+	{ return file.rend(); }
+
+	const_iterator lower_bound(Key const &key) const
+	{
+		KeyCmp const &keycmp = cmp;
+		KeyOf keyof;
+
+		return std::lower_bound(begin(), end(), key,
+			[&keycmp, &keyof](Val const &val, Key const &key)
+			{ return keycmp(keyof(val), key); });
+	}
+
+	const_iterator upper_bound(Key const &key) const
+	{
+		KeyCmp const &keycmp = cmp;
+		KeyOf keyof;
+
+		return std::upper_bound(begin(), end(), key,
+			[&keycmp, &keyof](Key const &key, Val const &val)
+			{ return keycmp(key, keyof(val)); });
+	}
+
+	std::pair<const_iterator, const_iterator>
+	equal_range(Key const &key) const
+	{ return std::make_pair(lower_bound(key), upper_bound(key)); }
+
+	const_iterator find(Key const &key) const
+	{
+		const_iterator it = lower_bound(key);
+
+		if (it == end() || cmp(key, KeyOf()(*it)))
+			return end();
+		return it;
+	}
+
+	size_t count(Key const &key) const
+	{ return std::distance(lower_bound(key), upper_bound(key)); }
+
+private:
+	FlatFile<Val> file;
+	KeyCmp cmp;
+};
+
+#endif /*__FLAT_FILE_HPP__*/
@@ -0,0 +1,234 @@
+#include "flat_file.hpp"
+
+#include "../simple-bst/bst.hpp"
+#include "../splay/splay_tree.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <set>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#include <unistd.h>
+
+template <typename Ct>
+void fill_random(Ct &ct, size_t size)
+{
+	for (size_t i = 0; i != size; ++i)
+		ct.push_back(rand() % static_cast<int>(2 * size + 1));
+}
+
+template <typename T>
+struct Id {
+	T const &operator()(T const &x) const
+	{ return x; }
+};
+
+struct Entry {
+	int key;
+	double value;
+};
+
+struct EntryKey {
+	int const &operator()(Entry const &entry) const
+	{ return entry.key; }
+};
+
+using View = FlatView<int, int, Id<int>, std::less<int>>;
+using SplayTreeType = SplayTree<int, int, Id<int>, std::less<int>>;
+using Tree = BinarySearchTree<int, int, Id<int>, std::less<int>>;
+using RBTree = BinarySearchTree<int, int, Id<int>, std::less<int>,
+			std::allocator<int>, RedBlackBalance>;
+using EntryTree = BinarySearchTree<int, Entry, EntryKey, std::less<int>,
+			std::allocator<Entry>, RedBlackBalance>;
+
+char const path[] = "test.bin";
+
+void check_view(View const &view, std::multiset<int> const &check)
+{
+	assert(view.size() == check.size());
+	assert(view.empty() == check.empty());
+	assert(std::equal(check.begin(), check.end(), view.begin()));
+	assert(std::equal(check.rbegin(), check.rend(), view.rbegin()));
+
+	int const limit = static_cast<int>(2 * check.size() + 2);
+	for (int key = -1; key <= limit; ++key) {
+		assert(std::distance(view.begin(), view.lower_bound(key)) ==
+			std::distance(check.begin(), check.lower_bound(key)));
+		assert(std::distance(view.begin(), view.upper_bound(key)) ==
+			std::distance(check.begin(), check.upper_bound(key)));
+		assert(view.count(key) == check.count(key));
+
+		if (check.count(key))
+			assert(*view.find(key) == key);
+		else
+			assert(view.find(key) == view.end());
+	}
+}
+
+void run_bst_test(size_t size)
+{
+	std::vector<int> source;
+	fill_random(source, size);
+	std::multiset<int> const check(source.begin(), source.end());
+
+	RBTree const tree(source.begin(), source.end());
+	save_flat(path, tree);
+
+	FlatFile<int> file(path);
+	assert(file.size() == size);
+	assert(std::equal(file.begin(), file.end(), check.begin()));
+
+	file.will_need();
+	RBTree loaded(sorted_input, file.begin(), file.end());
+	assert(loaded.size() == size);
+	assert(std::equal(loaded.begin(), loaded.end(), check.begin()));
+
+	Tree plain(sorted_input, file.begin(), file.end());
+	assert(std::equal(plain.begin(), plain.end(), check.begin()));
+
+	check_view(View(path), check);
+}
+
+void run_splay_test(size_t size)
+{
+	std::vector<int> source;
+	fill_random(source, size);
+	std::sort(source.begin(), source.end());
+	source.erase(std::unique(source.begin(), source.end()), source.end());
+
+	SplayTreeType tree;
+	for (size_t i = 0; i != source.size(); ++i)
+		tree.insert_unique(source[(i * 7919) % source.size()]);
+	save_flat(path, tree.begin(), tree.end());
+
+	FlatFile<int> const file(path);
+	SplayTreeType loaded(sorted_unique, file.begin(), file.end());
+	assert(loaded.size() == source.size());
+	assert(std::equal(loaded.begin(), loaded.end(), source.begin()));
+
+	for (size_t i = 0; i != source.size(); ++i)
+		assert(*loaded.find(source[i]) == source[i]);
+
+	check_view(View(path), std::multiset<int>(source.begin(),
+				source.end()));
+}
+
+void run_struct_test(size_t size)
+{
+	EntryTree tree;
+	for (size_t i = 0; i != size; ++i)
+		tree.insert(Entry{rand(), static_cast<double>(i)});
+	save_flat(path, tree);
+
+	FlatView<int, Entry, EntryKey, std::less<int>> const view(path);
+	EntryTree loaded(sorted_input, view.begin(), view.end());
+
+	assert(view.size() == size);
+	assert(loaded.size() == size);
+	for (EntryTree::const_iterator it = tree.begin(); it != tree.end();
+				++it) {
+		assert(view.find(it->key)->key == it->key);
+		assert(loaded.find(it->key)->key == it->key);
+	}
+	assert(std::equal(tree.begin(), tree.end(), view.begin(),
+		[](Entry const &l, Entry const &r)
+		{ return l.key == r.key && l.value == r.value; }));
+}
+
+template <typename Exception, typename F>
+void check_throws(F f)
+{
+	bool thrown = false;
+
+	try {
+		f();
+	} catch (Exception const &) {
+		thrown = true;
+	}
+	assert(thrown);
+}
+
+struct ThrowingIterator : public std::iterator<
+			std::input_iterator_tag, int> {
+	int value;
+
+	explicit ThrowingIterator(int value)
+	: value(value)
+	{ }
+
+	int const &operator*() const
+	{
+		if (value == 100)
+			throw std::runtime_error("broken input");
+		return value;
+	}
+
+	ThrowingIterator &operator++()
+	{
+		++value;
+		return *this;
+	}
+
+	bool operator!=(ThrowingIterator const &other) const
+	{ return value != other.value; }
+};
+
+void run_error_test()
+{
+	std::vector<int> const values = {1, 2, 3};
+	save_flat(path, values);
+
+	check_throws<std::system_error>([] { FlatFile<int> file("no.bin"); });
+	check_throws<std::runtime_error>([] { FlatFile<long> file(path); });
+
+	/* the old file survives a failed save and no garbage is left */
+	check_throws<std::runtime_error>([] {
+		save_flat(path, ThrowingIterator(0),
+					ThrowingIterator(200));
+	});
+	assert(std::equal(values.begin(), values.end(),
+				FlatFile<int>(path).begin()));
+	assert(std::fopen("test.bin.tmp", "r") == 0);
+
+	FILE *file = std::fopen(path, "r+");
+	std::fseek(file, 0, SEEK_END);
+	long const size = std::ftell(file);
+	std::fclose(file);
+
+	/* truncated */
+	int const truncated = truncate(path, size - 1);
+	assert(truncated == 0);
+	check_throws<std::runtime_error>([] { FlatFile<int> file(path); });
+
+	/* not a flat file at all */
+	file = std::fopen(path, "w");
+	std::fputs("definitely not a flat file, but long enough to have "
+		"the whole header", file);
+	std::fclose(file);
+	check_throws<std::runtime_error>([] { FlatFile<int> file(path); });
+
+	std::remove(path);
+}
+
+int main()
+{
+	size_t const sizes[] = {0, 1, 2, 3, 10, 100, 1000, 10000};
+
+	for (size_t size : sizes) {
+		run_bst_test(size);
+		run_splay_test(size);
+		run_struct_test(size);
+	}
+	run_error_test();
+	std::remove(path);
+
+	std::cout << "test is successfully passed" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,104 @@
+#include "frozen_tree.hpp"
+
+#include "../splay/splay_tree.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+template <typename T>
+struct Id {
+	T const &operator()(T const &x) const
+	{ return x; }
+};
+
+using Frozen = FrozenTree<int, int, Id<int>, std::less<int>>;
+using SplayTreeType = SplayTree<int, int, Id<int>, std::less<int>>;
+
+template <typename F>
+double measure(F f)
+{
+	auto const start = std::chrono::steady_clock::now();
+	f();
+	auto const stop = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double>(stop - start).count();
+}
+
+/**
+ * Uniformly random lower_bound queries over keys 0, 2, 4, ..., so half of
+ * them miss. SplayTree is queried through its const (non-splaying)
+ * lower_bound, i. e. the plain pointer chasing loop.
+ **/
+void run_lookups(size_t size, size_t lookups)
+{
+	std::vector<int> keys(size);
+	for (size_t i = 0; i != size; ++i)
+		keys[i] = static_cast<int>(2 * i);
+
+	std::mt19937 gen(size);
+	std::uniform_int_distribution<int> dist(0, static_cast<int>(2 * size));
+	std::vector<int> probes(lookups);
+	for (size_t i = 0; i != lookups; ++i)
+		probes[i] = dist(gen);
+
+	SplayTreeType const splay(sorted_unique, keys.begin(), keys.end());
+	Frozen const frozen(splay.begin(), splay.end());
+
+	long splay_sum = 0;
+	long frozen_sum = 0;
+	long vector_sum = 0;
+
+	double const splay_time = measure([&] {
+		for (size_t i = 0; i != lookups; ++i) {
+			auto it = splay.lower_bound(probes[i]);
+			splay_sum += it == splay.end() ? -1 : *it;
+		}
+	});
+
+	double const frozen_time = measure([&] {
+		for (size_t i = 0; i != lookups; ++i) {
+			auto it = frozen.lower_bound(probes[i]);
+			frozen_sum += it == frozen.end() ? -1 : *it;
+		}
+	});
+
+	double const vector_time = measure([&] {
+		for (size_t i = 0; i != lookups; ++i) {
+			auto it = std::lower_bound(keys.begin(), keys.end(),
+						probes[i]);
+			vector_sum += it == keys.end() ? -1 : *it;
+		}
+	});
+
+	if (splay_sum != frozen_sum || frozen_sum != vector_sum)
+		std::cout << "results differ!" << std::endl;
+
+	std::cout << size << "\t" << splay_time << "\t" << frozen_time
+		<< "\t" << vector_time << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+	size_t const lookups = argc > 1 ? atol(argv[1]) : 1000000;
+	std::vector<size_t> sizes;
+
+	for (int i = 2; i < argc; ++i)
+		sizes.push_back(atol(argv[i]));
+	if (sizes.empty()) {
+		sizes.push_back(1000000);
+		sizes.push_back(10000000);
+	}
+
+	std::cout << lookups << " random lower_bound queries, seconds"
+		<< std::endl;
+	std::cout << "keys\tSplayTree\tFrozenTree\tsorted vector"
+		<< std::endl;
+	for (size_t size : sizes)
+		run_lookups(size, lookups);
+
+	return 0;
+}
@@ -0,0 +1,309 @@
+#ifndef __FROZEN_TREE_HPP__
+#define __FROZEN_TREE_HPP__
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/**
+ * Navigation in implicit complete binary tree stored in Eytzinger (BFS)
+ * order: node k (starting from 1) has children 2k and 2k + 1, 0 is used as
+ * end position. Nodes are stored in array as k - 1.
+ **/
+inline size_t eytzinger_left_most(size_t k, size_t size)
+{
+	if (k > size)
+		return 0;
+
+	while (2 * k <= size)
+		k = 2 * k;
+	return k;
+}
+
+inline size_t eytzinger_right_most(size_t k, size_t size)
+{
+	if (k > size)
+		return 0;
+
+	while (2 * k + 1 <= size)
+		k = 2 * k + 1;
+	return k;
+}
+
+inline size_t eytzinger_next(size_t k, size_t size)
+{
+	if (2 * k + 1 <= size)
+		return eytzinger_left_most(2 * k + 1, size);
+
+	while (k & 1)
+		k >>= 1;
+	return k >> 1;
+}
+
+inline size_t eytzinger_prev(size_t k, size_t size)
+{
+	if (!k)
+		return eytzinger_right_most(1, size);
+
+	if (2 * k <= size)
+		return eytzinger_right_most(2 * k, size);
+
+	while (k && !(k & 1))
+		k >>= 1;
+	return k >> 1;
+}
+
+/**
+ * Search descent ends below a leaf, position of the last node where it
+ * went left is encoded in k: shifting out trailing ones (right turns) and
+ * one zero (that left turn) gives it back.
+ **/
+inline size_t eytzinger_last_left(size_t k)
+{
+#if defined(__GNUC__)
+	return k >> __builtin_ffsll(~static_cast<unsigned long long>(k));
+#else
+	while (k & 1)
+		k >>= 1;
+	return k >> 1;
+#endif
+}
+
+inline void eytzinger_prefetch(void const *base, size_t offset)
+{
+#if defined(__GNUC__)
+	/* address arithmetic on integers: the address may be past the end */
+	__builtin_prefetch(reinterpret_cast<void const *>(
+			reinterpret_cast<uintptr_t>(base) + offset));
+#else
+	(void)base;
+	(void)offset;
+#endif
+}
+
+template <typename T>
+struct FrozenTreeIterator : public std::iterator<
+			std::bidirectional_iterator_tag, T,
+			ptrdiff_t, T const *, T const &> {
+	using Self = FrozenTreeIterator<T>;
+	using Trait = std::iterator_traits<Self>;
+	using Ref = typename Trait::reference;
+	using Ptr = typename Trait::pointer;
+
+	T const *data;
+	size_t node;
+	size_t size;
+
+	FrozenTreeIterator()
+	: data(), node(), size()
+	{ }
+
+	FrozenTreeIterator(T const *data, size_t node, size_t size)
+	: data(data), node(node), size(size)
+	{ }
+
+	Ref operator*() const
+	{ return data[node - 1]; }
+
+	Ptr operator->() const
+	{ return std::addressof(data[node - 1]); }
+
+	Self &operator++()
+	{
+		node = eytzinger_next(node, size);
+		return *this;
+	}
+
+	Self operator++(int)
+	{
+		Self tmp = *this;
+		node = eytzinger_next(node, size);
+		return tmp;
+	}
+
+	Self &operator--()
+	{
+		node = eytzinger_prev(node, size);
+		return *this;
+	}
+
+	Self operator--(int)
+	{
+		Self tmp = *this;
+		node = eytzinger_prev(node, size);
+		return tmp;
+	}
+
+	bool operator==(Self const &other) const
+	{ return node == other.node && data == other.data; }
+
+	bool operator!=(Self const &other) const
+	{ return !(*this == other); }
+};
+
+/**
+ * Immutable search tree for read-only phases: sorted values (e. g. content
+ * of a SplayTree or a BinarySearchTree) are laid out in one array in
+ * Eytzinger order, so the top levels of the tree share a few cache lines
+ * and the search needs no pointers at all. lower_bound and upper_bound are
+ * branchless (the comparison result is added to the node index) and
+ * prefetch the cache line holding the descendants a few levels down, so
+ * memory latency of the next levels overlaps with the current comparison.
+ *
+ * Iterators walk the implicit tree in order, so it looks like any other
+ * tree to the user. Only const_iterator is provided.
+ **/
+template <typename Key, typename Val, typename KeyOf, typename KeyCmp,
+	typename Allocator = std::allocator<Val>>
+class FrozenTree {
+	using Self = FrozenTree<Key, Val, KeyOf, KeyCmp, Allocator>;
+	using Storage = std::vector<Val, Allocator>;
+
+	/* descendants that many levels down share a cache line */
+	static size_t const prefetch_block = sizeof(Val) >= 64 ? 1
+				: sizeof(Val) >= 32 ? 2
+				: sizeof(Val) >= 16 ? 4
+				: sizeof(Val) >= 8 ? 8 : 16;
+
+public:
+	using key_type = Key;
+	using value_type = Val;
+	using const_iterator = FrozenTreeIterator<Val>;
+	using iterator = const_iterator;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+	using reverse_iterator = const_reverse_iterator;
+	using reference = Val const &;
+	using const_reference = Val const &;
+	using size_type = size_t;
+
+	explicit FrozenTree(KeyCmp const &cmp = KeyCmp(),
+				Allocator const &a = Allocator())
+	: data(a), cmp(cmp)
+	{ }
+
+	/**
+	 * [first, last) must be sorted by key, e. g. begin() and end() of
+	 * another tree.
+	 **/
+	template <typename It>
+	FrozenTree(It first, It last, KeyCmp const &cmp = KeyCmp(),
+				Allocator const &a = Allocator())
+	: data(a), cmp(cmp)
+	{ assign(first, last); }
+
+	template <typename It>
+	void assign(It first, It last)
+	{
+		Storage sorted(first, last, data.get_allocator());
+		size_t const size = sorted.size();
+		std::vector<size_t> order(size);
+
+		assert(std::is_sorted(sorted.begin(), sorted.end(),
+			[this](Val const &l, Val const &r)
+			{ return cmp(KeyOf()(l), KeyOf()(r)); }));
+
+		size_t node = eytzinger_left_most(1, size);
+		for (size_t i = 0; i != size; ++i) {
+			order[node - 1] = i;
+			node = eytzinger_next(node, size);
+		}
+
+		Storage tmp(data.get_allocator());
+		tmp.reserve(size);
+		for (size_t i = 0; i != size; ++i)
+			tmp.push_back(std::move(sorted[order[i]]));
+		data.swap(tmp);
+	}
+
+	void swap(Self &other)
+	{
+		using std::swap;
+		data.swap(other.data);
+		swap(cmp, other.cmp);
+	}
+
+	void clear()
+	{ data.clear(); }
+
+	bool empty() const
+	{ return data.empty(); }
+
+	size_t size() const
+	{ return data.size(); }
+
+	const_iterator begin() const
+	{ return make_iterator(eytzinger_left_most(1, size())); }
+
+	const_iterator end() const
+	{ return make_iterator(0); }
+
+	const_reverse_iterator rbegin() const
+	{ return const_reverse_iterator(end()); }
+
+	const_reverse_iterator rend() const
+	{ return const_reverse_iterator(begin()); }
+
+	const_iterator lower_bound(Key const &key) const
+	{
+		Val const *const values = data.data();
+		size_t const size = data.size();
+		KeyOf keyof;
+		size_t node = 1;
+
+		while (node <= size) {
+			eytzinger_prefetch(values,
+				(node * prefetch_block - 1) * sizeof(Val));
+			node = 2 * node + static_cast<size_t>(
+				cmp(keyof(values[node - 1]), key));
+		}
+
+		return make_iterator(eytzinger_last_left(node));
+	}
+
+	const_iterator upper_bound(Key const &key) const
+	{
+		Val const *const values = data.data();
+		size_t const size = data.size();
+		KeyOf keyof;
+		size_t node = 1;
+
+		while (node <= size) {
+			eytzinger_prefetch(values,
+				(node * prefetch_block - 1) * sizeof(Val));
+			node = 2 * node + static_cast<size_t>(
+				!cmp(key, keyof(values[node - 1])));
+		}
+
+		return make_iterator(eytzinger_last_left(node));
+	}
+
+	std::pair<const_iterator, const_iterator>
+	equal_range(Key const &key) const
+	{ return std::make_pair(lower_bound(key), upper_bound(key)); }
+
+	const_iterator find(Key const &key) const
+	{
+		const_iterator it = lower_bound(key);
+
+		if (it == end() || cmp(key, KeyOf()(*it)))
+			return end();
+		return it;
+	}
+
+	size_t count(Key const &key) const
+	{ return std::distance(lower_bound(key), upper_bound(key)); }
+
+private:
+	const_iterator make_iterator(size_t node) const
+	{ return const_iterator(data.data(), node, data.size()); }
+
+	Storage data;
+	KeyCmp cmp;
+};
+
+#endif /*__FROZEN_TREE_HPP__*/
@@ -0,0 +1,96 @@
+#include "frozen_tree.hpp"
+
+#include "../simple-bst/bst.hpp"
+#include "../splay/splay_tree.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <set>
+#include <vector>
+
+template <typename Ct>
+void fill_random(Ct &ct, size_t size)
+{
+	for (size_t i = 0; i != size; ++i)
+		ct.push_back(rand() % static_cast<int>(2 * size + 1));
+}
+
+template <typename T>
+struct Id {
+	T const &operator()(T const &x) const
+	{ return x; }
+};
+
+using Frozen = FrozenTree<int, int, Id<int>, std::less<int>>;
+using SplayTreeType = SplayTree<int, int, Id<int>, std::less<int>>;
+using Tree = BinarySearchTree<int, int, Id<int>, std::less<int>>;
+
+void check_frozen(Frozen const &frozen, std::multiset<int> const &check)
+{
+	assert(frozen.size() == check.size());
+	assert(frozen.empty() == check.empty());
+	assert(std::equal(check.begin(), check.end(), frozen.begin()));
+	assert(std::equal(check.rbegin(), check.rend(), frozen.rbegin()));
+
+	int const limit = static_cast<int>(2 * check.size() + 2);
+	for (int key = -1; key <= limit; ++key) {
+		Frozen::const_iterator lower = frozen.lower_bound(key);
+		Frozen::const_iterator upper = frozen.upper_bound(key);
+
+		assert(std::distance(frozen.begin(), lower) == std::distance(
+				check.begin(), check.lower_bound(key)));
+		assert(std::distance(frozen.begin(), upper) == std::distance(
+				check.begin(), check.upper_bound(key)));
+		assert(frozen.count(key) == check.count(key));
+
+		if (check.count(key))
+			assert(*frozen.find(key) == key);
+		else
+			assert(frozen.find(key) == frozen.end());
+	}
+}
+
+void run_freeze_splay_test(size_t size)
+{
+	std::vector<int> source;
+	fill_random(source, size);
+
+	SplayTreeType splay(source.begin(), source.end());
+	Frozen frozen(splay.begin(), splay.end());
+
+	check_frozen(frozen, std::multiset<int>(source.begin(), source.end()));
+}
+
+void run_freeze_bst_test(size_t size)
+{
+	std::vector<int> source;
+	fill_random(source, size);
+
+	Tree tree(source.begin(), source.end());
+	Frozen frozen(tree.begin(), tree.end());
+
+	check_frozen(frozen, std::multiset<int>(source.begin(), source.end()));
+
+	Frozen other;
+	other.swap(frozen);
+	assert(frozen.empty());
+	assert(frozen.begin() == frozen.end());
+	assert(other.size() == source.size());
+}
+
+int main()
+{
+	size_t const sizes[] = {0, 1, 2, 3, 10, 100, 1000, 10000};
+
+	for (size_t size : sizes) {
+		run_freeze_splay_test(size);
+		run_freeze_bst_test(size);
+	}
+
+	std::cout << "test is successfully passed" << std::endl;
+
+	return 0;
+}
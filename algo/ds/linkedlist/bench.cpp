@@ -0,0 +1,224 @@
+#include "linkedlist.hpp"
+#include "unrolledlist.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+template <typename F>
+double measure(F f)
+{
+	auto const start = std::chrono::steady_clock::now();
+	f();
+	auto const stop = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double, std::nano>(stop - start).count();
+}
+
+/* a record a bit larger than a pointer */
+struct Item {
+	long key;
+	long payload[3];
+
+	Item(long key = 0)
+	: key(key), payload{key, key, key}
+	{ }
+};
+
+long value_of(int x)
+{ return x; }
+
+long value_of(Item const &x)
+{ return x.key; }
+
+struct Timings {
+	double scan;
+	double insert;
+	double rescan;
+	long check;
+};
+
+/**
+ * Fills size elements with push_back, scans them, inserts inserts more
+ * in the middle through an iterator kept from insert to insert and scans
+ * again: the second scan walks nodes allocated out of order. Returns
+ * nanoseconds per scanned element and per insert.
+ **/
+template <typename Seq>
+Timings run_seq(size_t size, size_t inserts)
+{
+	using T = typename Seq::value_type;
+
+	Timings timings;
+	Seq seq;
+	long check = 0;
+
+	for (size_t i = 0; i != size; ++i)
+		seq.push_back(T(static_cast<int>(i)));
+
+	timings.scan = measure([&] {
+		for (T const &x : seq)
+			check += value_of(x);
+	}) / size;
+
+	typename Seq::iterator it = std::next(seq.begin(), size / 2);
+	timings.insert = measure([&] {
+		for (size_t i = 0; i != inserts; ++i)
+			it = seq.insert(it, T(static_cast<int>(i)));
+	}) / inserts;
+
+	timings.rescan = measure([&] {
+		for (T const &x : seq)
+			check += value_of(x);
+	}) / (size + inserts);
+
+	timings.check = check;
+	return timings;
+}
+
+void print_row(size_t size, char const *op, double list, double unrolled,
+			double vector)
+{
+	std::cout << size << "\t" << op << "\t" << list << "\t" << unrolled
+		<< "\t" << vector << std::endl;
+}
+
+template <typename T>
+void run_size(char const *name, size_t size, size_t inserts)
+{
+	Timings const list = run_seq<LinkedList<T>>(size, inserts);
+	Timings const unrolled = run_seq<UnrolledList<T>>(size, inserts);
+	Timings const vector = run_seq<std::vector<T>>(size, inserts);
+
+	if (list.check != unrolled.check || unrolled.check != vector.check)
+		std::cout << "results differ!" << std::endl;
+
+	std::cout << name << ", " << UnrolledList<T>::capacity
+		<< " per UnrolledList node" << std::endl;
+	print_row(size, "scan", list.scan, unrolled.scan, vector.scan);
+	print_row(size, "insert", list.insert, unrolled.insert,
+				vector.insert);
+	print_row(size, "rescan", list.rescan, unrolled.rescan,
+				vector.rescan);
+}
+
+/**
+ * Moves batches of batch elements from the front of one list to the back
+ * of another until all size elements moved, by copying and erasing them
+ * and by splice. Returns nanoseconds per moved element.
+ **/
+void run_batches(size_t size, size_t batch)
+{
+	LinkedList<int> from, to;
+	size_t check = 0;
+
+	for (size_t i = 0; i != size; ++i)
+		from.push_back(static_cast<int>(i));
+
+	double const copy = measure([&] {
+		while (!from.empty()) {
+			LinkedList<int>::iterator last = from.begin();
+
+			for (size_t i = 0; i != batch && last != from.end();
+						++i)
+				++last;
+			to.insert(to.end(), from.begin(), last);
+			from.erase(from.begin(), last);
+		}
+	}) / size;
+
+	double const splice = measure([&] {
+		while (!to.empty()) {
+			LinkedList<int>::iterator last = to.begin();
+
+			for (size_t i = 0; i != batch && last != to.end();
+						++i)
+				++last;
+			from.splice(from.end(), to, to.begin(), last);
+		}
+	}) / size;
+
+	for (int x : from)
+		check += x;
+	if (check != size * (size - 1) / 2)
+		std::cout << "results differ!" << std::endl;
+
+	std::cout << size << "\t" << batch << "\t" << copy
+		<< "\t" << splice << std::endl;
+}
+
+/**
+ * FIFO churn of a dispatch loop: keeps depth messages queued and pushes
+ * and pops burst of them at a time, ops times. Returns nanoseconds per
+ * push and pop pair.
+ **/
+double run_churn(size_t depth, size_t burst, size_t ops, size_t limit)
+{
+	LinkedList<Item> fifo;
+	long check = 0;
+
+	fifo.set_node_cache_limit(limit);
+	for (size_t i = 0; i != depth; ++i)
+		fifo.push_back(Item(static_cast<long>(i)));
+
+	double const time = measure([&] {
+		for (size_t i = 0; i < ops; i += burst) {
+			for (size_t j = 0; j != burst; ++j)
+				fifo.push_back(Item(static_cast<long>(j)));
+			for (size_t j = 0; j != burst; ++j) {
+				check += fifo.begin()->key;
+				fifo.pop_front();
+			}
+		}
+	}) / ops;
+
+	if (check < 0)
+		std::cout << "results differ!" << std::endl;
+	return time;
+}
+
+int main(int argc, char **argv)
+{
+	size_t const inserts = argc > 1 ? atol(argv[1]) : 10000;
+	std::vector<size_t> sizes;
+
+	for (int i = 2; i < argc; ++i)
+		sizes.push_back(atol(argv[i]));
+	if (sizes.empty()) {
+		sizes.push_back(1000);
+		sizes.push_back(100000);
+		sizes.push_back(1000000);
+	}
+
+	std::cout << "scan, " << inserts << " inserts in the middle and "
+		<< "scan again, nanoseconds per element" << std::endl;
+	std::cout << "size\top\tLinkedList\tUnrolledList\tstd::vector"
+		<< std::endl;
+	for (size_t size : sizes) {
+		run_size<int>("int", size, inserts);
+		run_size<Item>("Item", size, inserts);
+	}
+
+	std::cout << "LinkedList batch move, nanoseconds per element"
+		<< std::endl;
+	std::cout << "size\tbatch\tcopy and erase\tsplice" << std::endl;
+	for (size_t size : sizes)
+		run_batches(size, 1000);
+
+	size_t const ops = 10000000;
+	std::cout << "LinkedList FIFO churn, " << ops << " pushes and pops, "
+		<< "nanoseconds per pair" << std::endl;
+	std::cout << "depth\tburst\tno cache\tcache of 64" << std::endl;
+	for (size_t depth : {size_t(100), size_t(100000)}) {
+		for (size_t burst : {size_t(1), size_t(64)}) {
+			std::cout << depth << "\t" << burst << "\t"
+				<< run_churn(depth, burst, ops, 0) << "\t"
+				<< run_churn(depth, burst, ops, 64)
+				<< std::endl;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,488 @@
+#ifndef __INTRUSIVE_LIST_HPP__
+#define __INTRUSIVE_LIST_HPP__
+
+#include "listhead.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+/**
+ * How a hook checks that it's used right:
+ *  - normal hook is just a ListHead, nothing is checked or reset;
+ *  - safe_unlink hook is reset when it's unlinked, linking a linked hook
+ *    and destroying a linked hook fail an assert;
+ *  - auto_unlink hook is reset too, and unlinks itself when destroyed.
+ *    List can't count elements that leave it on their own, so size() of a
+ *    list of auto_unlink hooks is O(n).
+ * Asserts are compiled out with NDEBUG, resets are not.
+ **/
+enum class IntrusiveLinkMode { normal, safe_unlink, auto_unlink };
+
+/**
+ * Link embedded into user objects, as a base or as a member. Tag tells
+ * apart several base hooks of one class. Copy of an object is not in the
+ * lists of the original, so hooks aren't copied.
+ **/
+template <IntrusiveLinkMode Mode = IntrusiveLinkMode::normal,
+	typename Tag = void>
+struct IntrusiveListHook : public ListHead {
+	static IntrusiveLinkMode const mode = Mode;
+	static bool const checked = Mode != IntrusiveLinkMode::normal;
+
+	IntrusiveListHook()
+	: ListHead()
+	{ }
+
+	IntrusiveListHook(IntrusiveListHook const &)
+	: ListHead()
+	{ }
+
+	IntrusiveListHook &operator=(IntrusiveListHook const &)
+	{ return *this; }
+
+	~IntrusiveListHook()
+	{
+		if (Mode == IntrusiveLinkMode::auto_unlink && linked())
+			unlink();
+		assert(Mode != IntrusiveLinkMode::safe_unlink || !linked());
+	}
+
+	/**
+	 * Only a checked hook is reset when unlinked, a normal hook looks
+	 * linked from the first insert on.
+	 **/
+	bool linked() const
+	{ return next != nullptr; }
+
+	void unlink()
+	{
+		remove_from_list(this);
+		if (checked)
+			next = prev = nullptr;
+	}
+};
+
+/**
+ * Accessors map values to hooks and back. IntrusiveBaseHook is for T
+ * derived from Hook. Hooks of other containers (see MpscQueueHook) aren't
+ * ListHeads, for them only the Hook overloads work.
+ **/
+template <typename T, typename Hook = IntrusiveListHook<>>
+struct IntrusiveBaseHook {
+	using value_type = T;
+	using hook_type = Hook;
+
+	static Hook *to_hook(T *value)
+	{ return static_cast<Hook *>(value); }
+
+	static T *to_value(Hook *hook)
+	{ return static_cast<T *>(hook); }
+
+	static T *to_value(ListHead *hook)
+	{ return static_cast<T *>(static_cast<Hook *>(hook)); }
+
+	static T const *to_value(ListHead const *hook)
+	{ return static_cast<T const *>(static_cast<Hook const *>(hook)); }
+};
+
+/**
+ * IntrusiveMemberHook is for T with a Hook member. Value is found from the
+ * hook by the member offset, like container_of does in C.
+ **/
+template <typename T, typename Hook, Hook T::*Member>
+struct IntrusiveMemberHook {
+	using value_type = T;
+	using hook_type = Hook;
+
+	static Hook *to_hook(T *value)
+	{ return std::addressof(value->*Member); }
+
+	static T *to_value(Hook *hook)
+	{
+		char *const at = reinterpret_cast<char *>(hook);
+
+		return reinterpret_cast<T *>(at - offset());
+	}
+
+	static T *to_value(ListHead *hook)
+	{ return to_value(static_cast<Hook *>(hook)); }
+
+	static T const *to_value(ListHead const *hook)
+	{ return to_value(const_cast<ListHead *>(hook)); }
+
+	static ptrdiff_t offset()
+	{
+		using Storage = typename std::aligned_storage<
+					sizeof(T), alignof(T)>::type;
+		Storage storage;
+		T *const value = reinterpret_cast<T *>(&storage);
+
+		return reinterpret_cast<char *>(std::addressof(value->*Member))
+			- reinterpret_cast<char *>(value);
+	}
+};
+
+template <typename Accessor>
+struct IntrusiveListIterator : public std::iterator<
+			std::bidirectional_iterator_tag,
+			typename Accessor::value_type> {
+	using Self = IntrusiveListIterator<Accessor>;
+	using Trait = std::iterator_traits<Self>;
+	using Ref = typename Trait::reference;
+	using Ptr = typename Trait::pointer;
+
+	ListHead *node;
+
+	IntrusiveListIterator()
+	: node()
+	{ }
+
+	explicit IntrusiveListIterator(ListHead *node)
+	: node(node)
+	{ }
+
+	Ref operator*() const
+	{ return *Accessor::to_value(node); }
+
+	Ptr operator->() const
+	{ return Accessor::to_value(node); }
+
+	Self &operator++()
+	{
+		node = node->next;
+		return *this;
+	}
+
+	Self operator++(int)
+	{
+		Self tmp = *this;
+		node = node->next;
+		return tmp;
+	}
+
+	Self &operator--()
+	{
+		node = node->prev;
+		return *this;
+	}
+
+	Self operator--(int)
+	{
+		Self tmp = *this;
+		node = node->prev;
+		return tmp;
+	}
+
+	bool operator==(Self const &other) const
+	{ return node == other.node; }
+
+	bool operator!=(Self const &other) const
+	{ return node != other.node; }
+};
+
+template <typename Accessor>
+struct IntrusiveListConstIterator : public std::iterator<
+			std::bidirectional_iterator_tag,
+			typename Accessor::value_type, ptrdiff_t,
+			typename Accessor::value_type const *,
+			typename Accessor::value_type const &> {
+	using Self = IntrusiveListConstIterator<Accessor>;
+	using Iter = IntrusiveListIterator<Accessor>;
+	using Trait = std::iterator_traits<Self>;
+	using Ref = typename Trait::reference;
+	using Ptr = typename Trait::pointer;
+
+	ListHead const *node;
+
+	IntrusiveListConstIterator()
+	: node()
+	{ }
+
+	explicit IntrusiveListConstIterator(ListHead const *node)
+	: node(node)
+	{ }
+
+	IntrusiveListConstIterator(Iter it)
+	: node(it.node)
+	{ }
+
+	Ref operator*() const
+	{ return *Accessor::to_value(node); }
+
+	Ptr operator->() const
+	{ return Accessor::to_value(node); }
+
+	Self &operator++()
+	{
+		node = node->next;
+		return *this;
+	}
+
+	Self operator++(int)
+	{
+		Self tmp = *this;
+		node = node->next;
+		return tmp;
+	}
+
+	Self &operator--()
+	{
+		node = node->prev;
+		return *this;
+	}
+
+	Self operator--(int)
+	{
+		Self tmp = *this;
+		node = node->prev;
+		return tmp;
+	}
+
+	bool operator==(Self const &other) const
+	{ return node == other.node; }
+
+	bool operator!=(Self const &other) const
+	{ return node != other.node; }
+};
+
+/**
+ * See the comment to the same operators for LinkedListIterator.
+ **/
+template <typename Accessor>
+inline bool operator==(IntrusiveListIterator<Accessor> const &lhs,
+			IntrusiveListConstIterator<Accessor> const &rhs)
+{ return lhs.node == rhs.node; }
+
+template <typename Accessor>
+inline bool operator!=(IntrusiveListIterator<Accessor> const &lhs,
+			IntrusiveListConstIterator<Accessor> const &rhs)
+{ return lhs.node != rhs.node; }
+
+/**
+ * List of objects it doesn't own: values embed hooks (one per list they
+ * can be in at once) and insert and erase only relink them, so they never
+ * allocate or copy. Values must outlive their membership, list doesn't
+ * destroy them, and a value in the list can be turned back into an
+ * iterator with iterator_to, so it can be erased or moved to another list
+ * in O(1).
+ *
+ * The list can be moved, but not copied: a value is in one list per hook.
+ **/
+template <typename T, typename Accessor = IntrusiveBaseHook<T>>
+class IntrusiveList {
+	using Self = IntrusiveList<T, Accessor>;
+	using Hook = typename Accessor::hook_type;
+
+	static bool const counted = Hook::mode
+		!= IntrusiveLinkMode::auto_unlink;
+
+public:
+	using iterator = IntrusiveListIterator<Accessor>;
+	using const_iterator = IntrusiveListConstIterator<Accessor>;
+	using value_type = T;
+	using reference = T &;
+	using const_reference = T const &;
+
+	IntrusiveList()
+	: count(0)
+	{ init_list_head(&head); }
+
+	template <typename It>
+	IntrusiveList(It first, It last)
+	: count(0)
+	{
+		init_list_head(&head);
+		for (; first != last; ++first)
+			push_back(*first);
+	}
+
+	IntrusiveList(Self const &) = delete;
+	Self &operator=(Self const &) = delete;
+
+	IntrusiveList(Self &&other) noexcept
+	: count(other.count)
+	{
+		move_list(&head, &other.head);
+		other.count = 0;
+	}
+
+	Self &operator=(Self &&other) noexcept
+	{
+		clear();
+		swap(other);
+		return *this;
+	}
+
+	/* values stay, but checked hooks are reset */
+	~IntrusiveList()
+	{ clear(); }
+
+	void swap(Self &other) noexcept
+	{
+		using std::swap;
+		ListHead tmp;
+
+		move_list(&tmp, &head);
+		move_list(&head, &other.head);
+		move_list(&other.head, &tmp);
+		swap(count, other.count);
+	}
+
+	void clear()
+	{
+		if (Hook::checked) {
+			while (!empty())
+				pop_front();
+			return;
+		}
+		init_list_head(&head);
+		count = 0;
+	}
+
+	bool empty() const
+	{ return head.next == &head; }
+
+	size_t size() const
+	{
+		if (counted)
+			return count;
+		return static_cast<size_t>(std::distance(begin(), end()));
+	}
+
+	iterator begin()
+	{ return iterator(head.next); }
+
+	const_iterator begin() const
+	{ return const_iterator(head.next); }
+
+	iterator end()
+	{ return iterator(&head); }
+
+	const_iterator end() const
+	{ return const_iterator(&head); }
+
+	T &front()
+	{ return *begin(); }
+
+	T const &front() const
+	{ return *begin(); }
+
+	T &back()
+	{ return *std::prev(end()); }
+
+	T const &back() const
+	{ return *std::prev(end()); }
+
+	/**
+	 * Value must be in a list of this type, for member hooks it must be
+	 * a list over the same member.
+	 **/
+	iterator iterator_to(T &value)
+	{ return iterator(Accessor::to_hook(std::addressof(value))); }
+
+	const_iterator iterator_to(T const &value) const
+	{
+		return const_iterator(Accessor::to_hook(
+				const_cast<T *>(std::addressof(value))));
+	}
+
+	void push_back(T &value)
+	{ insert(end(), value); }
+
+	void push_front(T &value)
+	{ insert(begin(), value); }
+
+	void pop_back()
+	{ erase(std::prev(end())); }
+
+	void pop_front()
+	{ erase(begin()); }
+
+	iterator insert(const_iterator pos, T &value)
+	{
+		Hook *hook = Accessor::to_hook(std::addressof(value));
+
+		assert(!Hook::checked || !hook->linked());
+		insert_before(hook, const_cast<ListHead *>(pos.node));
+		++count;
+		return iterator(hook);
+	}
+
+	iterator erase(const_iterator pos)
+	{
+		ListHead *node = const_cast<ListHead *>(pos.node);
+		ListHead *next = node->next;
+
+		static_cast<Hook *>(node)->unlink();
+		--count;
+		return iterator(next);
+	}
+
+	iterator erase(const_iterator first, const_iterator last)
+	{
+		while (first != last)
+			first = erase(first);
+		return iterator(const_cast<ListHead *>(last.node));
+	}
+
+	/* value must be in this list */
+	void erase(T &value)
+	{ erase(iterator_to(value)); }
+
+	/**
+	 * Same as LinkedList::splice, moving a range between different
+	 * lists is linear in its length to count it.
+	 **/
+	void splice(const_iterator pos, Self &other)
+	{
+		if (&other == this)
+			return;
+
+		splice_list(other.head.next, &other.head,
+				const_cast<ListHead *>(pos.node));
+		count += other.count;
+		other.count = 0;
+	}
+
+	void splice(const_iterator pos, Self &other, const_iterator it)
+	{
+		ListHead *node = const_cast<ListHead *>(it.node);
+		ListHead *at = const_cast<ListHead *>(pos.node);
+
+		if (node == at || node->next == at)
+			return;
+
+		remove_from_list(node);
+		insert_before(node, at);
+		--other.count;
+		++count;
+	}
+
+	void splice(const_iterator pos, Self &other,
+			const_iterator first, const_iterator last)
+	{
+		if (counted && &other != this) {
+			size_t const moved = static_cast<size_t>(
+					std::distance(first, last));
+
+			other.count -= moved;
+			count += moved;
+		}
+		splice_list(const_cast<ListHead *>(first.node),
+				const_cast<ListHead *>(last.node),
+				const_cast<ListHead *>(pos.node));
+	}
+
+	void reverse()
+	{ reverse_list(&head); }
+
+private:
+	ListHead head;
+	size_t count;
+};
+
+#endif /*__INTRUSIVE_LIST_HPP__*/
@@ -3,6 +3,8 @@
 
 #include "linkedlistnode.hpp"
 
+#include <algorithm>
+#include <functional>
 #include <memory>
 
 /**
@@ -20,17 +22,22 @@ namespace detail
 	template <typename T, typename Allocator>
 	struct LinkedListImpl : public Allocator {
 		ListHead head;
+		size_t size;
+		ListHead *cache;
+		size_t cached;
+		size_t cache_limit;
 
 		LinkedListImpl()
-		: Allocator()
+		: Allocator(), size(0), cache(), cached(0), cache_limit(0)
 		{ init_list_head(&head); }
 
 		LinkedListImpl(Allocator const &a)
-		: Allocator(a)
+		: Allocator(a), size(0), cache(), cached(0), cache_limit(0)
 		{ init_list_head(&head); }
 
 		LinkedListImpl(Allocator &&a)
-		: Allocator(std::move(a))
+		: Allocator(std::move(a)), size(0), cache(), cached(0),
+			cache_limit(0)
 		{ init_list_head(&head); }
 	};
 
@@ -46,11 +53,53 @@ namespace detail
 
 		Impl impl;
 
+		/**
+		 * Storage of destroyed nodes is kept in a singly linked cache
+		 * (linked through a ListHead placed into it) up to cache_limit
+		 * nodes, so a list that erases and inserts all the time goes
+		 * to the allocator only when it grows past its previous size
+		 * plus the limit.
+		 **/
 		Node *get_node()
-		{ return NodeAllocTrait::allocate(impl, 1); }
+		{
+			if (!impl.cached)
+				return NodeAllocTrait::allocate(impl, 1);
+
+			ListHead *link = impl.cache;
+
+			impl.cache = link->next;
+			--impl.cached;
+			link->~ListHead();
+			return reinterpret_cast<Node *>(link);
+		}
 
 		void put_node(Node *node)
-		{ NodeAllocTrait::deallocate(impl, node, 1); }
+		{
+			if (impl.cached == impl.cache_limit) {
+				NodeAllocTrait::deallocate(impl, node, 1);
+				return;
+			}
+
+			ListHead *link = ::new (static_cast<void *>(node))
+						ListHead();
+
+			link->next = impl.cache;
+			impl.cache = link;
+			++impl.cached;
+		}
+
+		void trim_cache(size_t limit)
+		{
+			while (impl.cached > limit) {
+				ListHead *link = impl.cache;
+
+				impl.cache = link->next;
+				--impl.cached;
+				link->~ListHead();
+				NodeAllocTrait::deallocate(impl,
+					reinterpret_cast<Node *>(link), 1);
+			}
+		}
 
 		NodeAlloc &node_allocator()
 		{ return *static_cast<NodeAlloc *>(&impl); }
@@ -103,11 +152,35 @@ namespace detail
 
 		/**
 		 * First af all moves Allocator subobject from LinkedListBase
-		 * then swaps heads.
+		 * then takes nodes of other. Nodes point to the dummy head,
+		 * so the head is relinked, not copied.
 		 **/
 		LinkedListBase(LinkedListBase &&other) noexcept
 		: impl(std::move(other.node_allocator()))
-		{ std::swap(impl.head, other.impl.head); }
+		{
+			using std::swap;
+
+			move_list(&impl.head, &other.impl.head);
+			swap(impl.size, other.impl.size);
+			swap_cache(other);
+		}
+
+		/* nodes are destroyed by LinkedList, only the cache is left */
+		~LinkedListBase()
+		{ trim_cache(0); }
+
+		/**
+		 * Cached storage came from the allocator, so the cache goes
+		 * with it.
+		 **/
+		void swap_cache(LinkedListBase &other)
+		{
+			using std::swap;
+
+			swap(impl.cache, other.impl.cache);
+			swap(impl.cached, other.impl.cached);
+			swap(impl.cache_limit, other.impl.cache_limit);
+		}
 	};
 }
 
@@ -125,6 +198,9 @@ class LinkedList : private detail::LinkedListBase<T, Alloc> {
 	using Base::node_allocator;
 	using Base::create_node;
 	using Base::destroy_node;
+	using Base::trim_cache;
+	using Base::swap_cache;
+	using Node = typename Base::Node;
 
 public:
 	using iterator = LinkedListIterator<T>;
@@ -141,9 +217,13 @@ public:
 	: Base(NodeAlloc(a))
 	{ }
 
+	/* the copy caches up to as many nodes as the original */
 	LinkedList(LinkedList const &other)
 	: Base(other.node_allocator())
-	{ insert(begin(), other.begin(), other.end()); }
+	{
+		impl.cache_limit = other.impl.cache_limit;
+		insert(begin(), other.begin(), other.end());
+	}
 
 	LinkedList(std::initializer_list<T> other,
 			ValueAlloc const &a = ValueAlloc())
@@ -195,7 +275,13 @@ public:
 	void swap(LinkedList &other) noexcept
 	{
 		using std::swap;
-		swap(impl.head, other.impl.head);
+		ListHead tmp;
+
+		move_list(&tmp, &impl.head);
+		move_list(&impl.head, &other.impl.head);
+		move_list(&other.impl.head, &tmp);
+		swap(impl.size, other.impl.size);
+		swap_cache(other);
 		swap(node_allocator(), other.node_allocator());
 	}
 
@@ -205,11 +291,26 @@ public:
 	bool empty() const
 	{ return begin() == end(); }
 
+	size_t size() const
+	{ return impl.size; }
+
 	/**
-	 * Attention time complexity of size method is O(n)
+	 * Erased nodes are kept for reuse up to limit (the default limit 0
+	 * turns the cache off), nodes cached over a new limit are freed.
+	 * A FIFO that pushes and pops all the time with a limit as large as
+	 * its usual swing in size doesn't allocate at all.
 	 **/
-	size_t size() const
-	{ return static_cast<size_t>(std::distance(begin(), end())); }
+	void set_node_cache_limit(size_t limit)
+	{
+		impl.cache_limit = limit;
+		trim_cache(limit);
+	}
+
+	size_t node_cache_limit() const
+	{ return impl.cache_limit; }
+
+	size_t cached_nodes() const
+	{ return impl.cached; }
 
 	iterator begin()
 	{ return iterator(impl.head.next); }
@@ -234,7 +335,7 @@ public:
 	{ emplace(end(), std::forward<Args>(args)...); }
 
 	void pop_back()
-	{ erase(end()); }
+	{ erase(std::prev(end())); }
 
 	void push_front(T const &x)
 	{ insert(begin(), x); }
@@ -254,6 +355,7 @@ public:
 	{
 		ListHead *node = create_node(std::forward<Args>(args)...);
 		insert_before(node, const_cast<ListHead *>(pos.node));
+		++impl.size;
 		return iterator(node);
 	}
 
@@ -271,6 +373,7 @@ public:
 	{
 		ListHead *node = create_node(x);
 		insert_before(node, const_cast<ListHead *>(pos.node));
+		++impl.size;
 		return iterator(node);
 	}
 
@@ -278,6 +381,7 @@ public:
 	{
 		ListHead *node = create_node(std::forward<T>(x));
 		insert_before(node, const_cast<ListHead *>(pos.node));
+		++impl.size;
 		return iterator(node);
 	}
 
@@ -287,6 +391,7 @@ public:
 		ListHead *next = node->next;
 		remove_from_list(node);
 		destroy_node(static_cast<LinkedListNode<T> *>(node));
+		--impl.size;
 		return iterator(next);
 	}
 
@@ -299,6 +404,181 @@ public:
 
 	void reverse()
 	{ reverse_list(&impl.head); }
+
+	/**
+	 * splice moves nodes of other before pos: no element is copied or
+	 * allocated and iterators to moved elements stay valid, but now
+	 * point into this list. Like std::list::splice, allocators of both
+	 * lists must compare equal.
+	 **/
+	void splice(const_iterator pos, LinkedList &other)
+	{
+		if (&other == this)
+			return;
+
+		splice_list(other.impl.head.next, &other.impl.head,
+				const_cast<ListHead *>(pos.node));
+		impl.size += other.impl.size;
+		other.impl.size = 0;
+	}
+
+	void splice(const_iterator pos, LinkedList &other, const_iterator it)
+	{
+		ListHead *node = const_cast<ListHead *>(it.node);
+		ListHead *at = const_cast<ListHead *>(pos.node);
+
+		if (node == at || node->next == at)
+			return;
+
+		remove_from_list(node);
+		insert_before(node, at);
+		--other.impl.size;
+		++impl.size;
+	}
+
+	/**
+	 * Relinking is O(1), but moving a range between different lists
+	 * counts it, so it's linear in the range length.
+	 **/
+	void splice(const_iterator pos, LinkedList &other,
+			const_iterator first, const_iterator last)
+	{
+		if (&other != this) {
+			size_t const count = static_cast<size_t>(
+					std::distance(first, last));
+
+			other.impl.size -= count;
+			impl.size += count;
+		}
+		splice_list(const_cast<ListHead *>(first.node),
+				const_cast<ListHead *>(last.node),
+				const_cast<ListHead *>(pos.node));
+	}
+
+	/**
+	 * Merges sorted other into this sorted list relinking nodes, other
+	 * becomes empty. Merge is stable: of equal elements the ones of this
+	 * list go first.
+	 **/
+	template <typename Cmp>
+	void merge(LinkedList &other, Cmp cmp)
+	{
+		ListHead *const head = &impl.head;
+		ListHead *const from = &other.impl.head;
+		ListHead *pos = head->next;
+
+		if (&other == this)
+			return;
+
+		while (from->next != from) {
+			ListHead *first = from->next;
+
+			while (pos != head && !cmp(value(first), value(pos)))
+				pos = pos->next;
+			if (pos == head) {
+				impl.size += other.impl.size;
+				other.impl.size = 0;
+				splice_list(first, from, head);
+				break;
+			}
+
+			/* all the nodes that go before pos are moved at once */
+			ListHead *last = first->next;
+			size_t count = 1;
+
+			while (last != from && cmp(value(last), value(pos))) {
+				last = last->next;
+				++count;
+			}
+			impl.size += count;
+			other.impl.size -= count;
+			splice_list(first, last, pos);
+		}
+	}
+
+	void merge(LinkedList &other)
+	{ merge(other, std::less<T>()); }
+
+	/**
+	 * Stable bottom up merge sort, relinks nodes and never copies or
+	 * moves elements. Nodes are collected into sorted runs of 2^i
+	 * nodes like in a binary counter: a new node merges with the run
+	 * of 1 node, the result with the run of 2 nodes and so on. Runs are
+	 * singly linked through next while sorting, prev links are restored
+	 * at the end. cmp must not throw, otherwise nodes are lost.
+	 **/
+	template <typename Cmp>
+	void sort(Cmp cmp)
+	{
+		ListHead *const head = &impl.head;
+		ListHead *runs[64] = {};
+		ListHead *pos = head->next;
+		size_t max = 0;
+
+		if (impl.size < 2)
+			return;
+
+		head->prev->next = nullptr;
+		while (pos) {
+			ListHead *run = pos;
+			size_t i = 0;
+
+			pos = pos->next;
+			run->next = nullptr;
+			for (; runs[i]; ++i) {
+				run = merge_runs(runs[i], run, cmp);
+				runs[i] = nullptr;
+			}
+			runs[i] = run;
+			max = std::max(max, i);
+		}
+
+		/* older elements are in the longer runs */
+		ListHead *sorted = nullptr;
+		for (size_t i = 0; i <= max; ++i) {
+			if (runs[i])
+				sorted = merge_runs(runs[i], sorted, cmp);
+		}
+
+		ListHead *prev = head;
+		for (pos = sorted; pos; prev = pos, pos = pos->next)
+			pos->prev = prev;
+		head->next = sorted;
+		head->prev = prev;
+		prev->next = head;
+	}
+
+	void sort()
+	{ sort(std::less<T>()); }
+
+private:
+	static T const &value(ListHead const *node)
+	{ return static_cast<Node const *>(node)->data; }
+
+	/**
+	 * Merges two null terminated runs, of equal elements the ones of
+	 * first go first.
+	 **/
+	template <typename Cmp>
+	static ListHead *merge_runs(ListHead *first, ListHead *second,
+				Cmp &cmp)
+	{
+		ListHead merged;
+		ListHead *tail = &merged;
+
+		while (first && second) {
+			if (cmp(value(second), value(first))) {
+				tail->next = second;
+				second = second->next;
+			} else {
+				tail->next = first;
+				first = first->next;
+			}
+			tail = tail->next;
+		}
+		tail->next = first ? first : second;
+		return merged.next;
+	}
 };
 
 #endif /*__LINKED_LIST_BASE_HPP__`*/
@@ -32,6 +32,37 @@ void remove_from_list(struct ListHead *node)
 { remove_between(node->prev, node->next); }
 
 
+void splice_list(struct ListHead *first, struct ListHead *last,
+			struct ListHead *pos)
+{
+	struct ListHead *tail = last->prev;
+
+	if (first == last)
+		return;
+
+	remove_between(first->prev, last);
+	pos->prev->next = first;
+	first->prev = pos->prev;
+	tail->next = pos;
+	pos->prev = tail;
+}
+
+
+void move_list(struct ListHead *to, struct ListHead *from)
+{
+	if (from->next == from) {
+		init_list_head(to);
+		return;
+	}
+
+	to->next = from->next;
+	to->prev = from->prev;
+	to->next->prev = to;
+	to->prev->next = to;
+	init_list_head(from);
+}
+
+
 void reverse_list(struct ListHead *head)
 {
 	struct ListHead *pos = head;
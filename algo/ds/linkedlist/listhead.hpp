@@ -28,6 +28,20 @@ void insert_before(struct ListHead *new_node, struct ListHead *pos);
  **/
 void remove_from_list(struct ListHead *node);
 
+/**
+ * Moves nodes from first up to but not including last before pos. They may
+ * belong to the same list as pos, but pos must not be among them.
+ **/
+void splice_list(struct ListHead *first, struct ListHead *last,
+			struct ListHead *pos);
+
+/**
+ * Moves all nodes of list with dummy head from to list with dummy head to,
+ * from becomes empty. Old contents of to are lost, so it must be empty or
+ * uninitialized.
+ **/
+void move_list(struct ListHead *to, struct ListHead *from);
+
 /**
  * Reverses linked list with specified node as a dummy head element.
  **/
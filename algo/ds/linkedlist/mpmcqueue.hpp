@@ -0,0 +1,160 @@
+#ifndef __MPMC_QUEUE_HPP__
+#define __MPMC_QUEUE_HPP__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Vyukov's bounded multiple producer multiple consumer queue. Values are
+ * kept in a ring of cells, so unlike MpscQueue it owns copies of them and
+ * needs no hooks, but the ring is allocated up front and try_push fails
+ * when it's full.
+ *
+ * Every cell has a sequence number that tells whose turn it is: a cell at
+ * position pos is free for the producer of pos when its sequence is pos,
+ * and full for the consumer of pos when it's pos + 1. Producers and
+ * consumers claim positions with a compare and swap of their counter, and
+ * then pass the cell on storing its sequence, so operations on different
+ * cells don't wait for each other.
+ *
+ * Moves of T must not throw.
+ **/
+template <typename T>
+class MpmcQueue {
+public:
+	/* capacity is rounded up to a power of 2 */
+	explicit MpmcQueue(size_t capacity)
+	: mask(round_up(capacity) - 1), cells(new Cell[mask + 1]),
+		enqueue_pos(0), dequeue_pos(0)
+	{
+		for (size_t pos = 0; pos <= mask; ++pos)
+			cells[pos].seq.store(pos, std::memory_order_relaxed);
+	}
+
+	MpmcQueue(MpmcQueue const &) = delete;
+	MpmcQueue &operator=(MpmcQueue const &) = delete;
+
+	/* there must be no concurrent operations */
+	~MpmcQueue()
+	{
+		size_t const last = enqueue_pos.load(std::memory_order_relaxed);
+
+		for (size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+					pos != last; ++pos)
+			cells[pos & mask].data()->~T();
+	}
+
+	size_t capacity() const
+	{ return mask + 1; }
+
+	bool try_push(T const &x)
+	{ return try_emplace(x); }
+
+	bool try_push(T &&x)
+	{ return try_emplace(std::move(x)); }
+
+	/**
+	 * The value is constructed before a cell is claimed, so if its
+	 * constructor throws the queue stays as it was.
+	 **/
+	template <typename ... Args>
+	bool try_emplace(Args && ... args)
+	{
+		T value(std::forward<Args>(args)...);
+		size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+		Cell *cell;
+
+		for (;;) {
+			cell = &cells[pos & mask];
+
+			size_t const seq = cell->seq.load(
+						std::memory_order_acquire);
+			intptr_t const diff = static_cast<intptr_t>(seq)
+					- static_cast<intptr_t>(pos);
+
+			/* the cell is still full from the previous round */
+			if (diff < 0)
+				return false;
+			if (diff > 0) {
+				pos = enqueue_pos.load(
+						std::memory_order_relaxed);
+				continue;
+			}
+			if (enqueue_pos.compare_exchange_weak(pos, pos + 1,
+						std::memory_order_relaxed))
+				break;
+		}
+
+		::new (static_cast<void *>(cell->data())) T(std::move(value));
+		cell->seq.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool try_pop(T &x)
+	{
+		size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+		Cell *cell;
+
+		for (;;) {
+			cell = &cells[pos & mask];
+
+			size_t const seq = cell->seq.load(
+						std::memory_order_acquire);
+			intptr_t const diff = static_cast<intptr_t>(seq)
+					- static_cast<intptr_t>(pos + 1);
+
+			/* the cell is not filled yet */
+			if (diff < 0)
+				return false;
+			if (diff > 0) {
+				pos = dequeue_pos.load(
+						std::memory_order_relaxed);
+				continue;
+			}
+			if (dequeue_pos.compare_exchange_weak(pos, pos + 1,
+						std::memory_order_relaxed))
+				break;
+		}
+
+		x = std::move(*cell->data());
+		cell->data()->~T();
+		cell->seq.store(pos + mask + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	struct Cell {
+		using Storage = typename std::aligned_storage<sizeof(T),
+						alignof(T)>::type;
+
+		std::atomic<size_t> seq;
+		Storage storage;
+
+		T *data()
+		{ return reinterpret_cast<T *>(&storage); }
+	};
+
+	static size_t round_up(size_t capacity)
+	{
+		size_t size = 2;
+
+		while (size < capacity)
+			size *= 2;
+		return size;
+	}
+
+	/* producers and consumers write their counters only */
+	size_t const mask;
+	std::unique_ptr<Cell[]> const cells;
+	char pad0[64 - sizeof(size_t) - sizeof(std::unique_ptr<Cell[]>)];
+	std::atomic<size_t> enqueue_pos;
+	char pad1[64 - sizeof(std::atomic<size_t>)];
+	std::atomic<size_t> dequeue_pos;
+	char pad2[64 - sizeof(std::atomic<size_t>)];
+};
+
+#endif /*__MPMC_QUEUE_HPP__*/
@@ -0,0 +1,115 @@
+#ifndef __MPSC_QUEUE_HPP__
+#define __MPSC_QUEUE_HPP__
+
+#include "intrusivelist.hpp"
+
+#include <atomic>
+#include <memory>
+
+/**
+ * Link of a value in MpscQueue. Producers write the link concurrently, so
+ * unlike ListHead it's a single atomic pointer. Like IntrusiveListHook it's
+ * not copied with the value.
+ **/
+struct MpscQueueHook {
+	std::atomic<MpscQueueHook *> next;
+
+	MpscQueueHook()
+	: next(nullptr)
+	{ }
+
+	MpscQueueHook(MpscQueueHook const &)
+	: next(nullptr)
+	{ }
+
+	MpscQueueHook &operator=(MpscQueueHook const &)
+	{ return *this; }
+};
+
+/**
+ * Vyukov's intrusive multiple producer single consumer queue. Values embed
+ * MpscQueueHook (Accessor works as for IntrusiveList), the queue doesn't
+ * own or copy them and never allocates.
+ *
+ * push is wait-free: producers swap themselves into back with one
+ * exchange and then link the previous back to themselves. pop runs in the
+ * consumer thread only and doesn't wait either, but a producer preempted
+ * between the exchange and the link hides everything pushed after it:
+ * until it links, pop returns nullptr though the queue isn't empty.
+ *
+ * The queue keeps a stub hook, so back is never null: when the consumer
+ * takes the last value it pushes the stub to have something to stay on.
+ **/
+template <typename T, typename Accessor = IntrusiveBaseHook<T, MpscQueueHook>>
+class MpscQueue {
+	using Hook = MpscQueueHook;
+
+public:
+	MpscQueue()
+	: back(&stub), front(&stub)
+	{ }
+
+	MpscQueue(MpscQueue const &) = delete;
+	MpscQueue &operator=(MpscQueue const &) = delete;
+
+	/* value must stay alive until it's popped */
+	void push(T &value)
+	{ link(Accessor::to_hook(std::addressof(value))); }
+
+	/**
+	 * Consumer only. Returns nullptr if the queue is empty or the next
+	 * value isn't linked yet.
+	 **/
+	T *pop()
+	{
+		Hook *first = front;
+		Hook *next = first->next.load(std::memory_order_acquire);
+
+		if (first == &stub) {
+			if (!next)
+				return nullptr;
+			front = first = next;
+			next = next->next.load(std::memory_order_acquire);
+		}
+
+		if (next) {
+			front = next;
+			return Accessor::to_value(first);
+		}
+
+		/* first is the last linked, but a push may be going on */
+		if (first != back.load(std::memory_order_acquire))
+			return nullptr;
+
+		link(&stub);
+		next = first->next.load(std::memory_order_acquire);
+		if (next) {
+			front = next;
+			return Accessor::to_value(first);
+		}
+		return nullptr;
+	}
+
+	/* consumer only, as pop sees it */
+	bool empty() const
+	{
+		return front == &stub
+			&& !stub.next.load(std::memory_order_acquire);
+	}
+
+private:
+	void link(Hook *hook)
+	{
+		hook->next.store(nullptr, std::memory_order_relaxed);
+		Hook *prev = back.exchange(hook, std::memory_order_acq_rel);
+		prev->next.store(hook, std::memory_order_release);
+	}
+
+	/* producers and the consumer don't share a cache line */
+	std::atomic<Hook *> back;
+	char pad[64 - sizeof(std::atomic<Hook *>)];
+	Hook *front;
+	Hook stub;
+};
+
+#endif /*__MPSC_QUEUE_HPP__*/
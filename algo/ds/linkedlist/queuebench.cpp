@@ -0,0 +1,198 @@
+#include "linkedlist.hpp"
+#include "mpmcqueue.hpp"
+#include "mpscqueue.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+struct Stamp {
+	size_t producer;
+	Clock::time_point pushed;
+};
+
+struct Message : public MpscQueueHook {
+	Stamp stamp;
+};
+
+/**
+ * What the dispatch loop does today: a LinkedList under one mutex, so
+ * every push allocates a node and every pop frees one.
+ **/
+class MutexQueue {
+public:
+	void push(Stamp const &stamp)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_list.push_back(stamp);
+	}
+
+	bool pop(Stamp &stamp)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+
+		if (m_list.empty())
+			return false;
+		stamp = *m_list.begin();
+		m_list.pop_front();
+		return true;
+	}
+
+private:
+	std::mutex m_lock;
+	LinkedList<Stamp> m_list;
+};
+
+/**
+ * MpscQueue links messages that producers own, preallocated here.
+ **/
+class IntrusiveQueue {
+public:
+	IntrusiveQueue(size_t producers, size_t count)
+	: m_messages(producers, std::vector<Message>(count)),
+		m_next(producers)
+	{ }
+
+	void push(Stamp const &stamp)
+	{
+		Message &message = m_messages[stamp.producer]
+					[m_next[stamp.producer]++];
+
+		message.stamp = stamp;
+		m_queue.push(message);
+	}
+
+	bool pop(Stamp &stamp)
+	{
+		Message *message = m_queue.pop();
+
+		if (!message)
+			return false;
+		stamp = message->stamp;
+		return true;
+	}
+
+private:
+	std::vector<std::vector<Message>> m_messages;
+	std::vector<size_t> m_next;
+	MpscQueue<Message> m_queue;
+};
+
+class RingQueue {
+public:
+	explicit RingQueue(size_t capacity)
+	: m_queue(capacity)
+	{ }
+
+	void push(Stamp const &stamp)
+	{
+		while (!m_queue.try_push(stamp))
+			std::this_thread::yield();
+	}
+
+	bool pop(Stamp &stamp)
+	{ return m_queue.try_pop(stamp); }
+
+private:
+	MpmcQueue<Stamp> m_queue;
+};
+
+struct Result {
+	double ops;
+	double p50;
+	double p99;
+	double p999;
+};
+
+double percentile(std::vector<double> &latency, double p)
+{
+	size_t const at = static_cast<size_t>(p * (latency.size() - 1));
+
+	std::nth_element(latency.begin(), latency.begin() + at, latency.end());
+	return latency[at];
+}
+
+/**
+ * producers threads push count messages each, one consumer pops them all.
+ * Every message carries the time it was pushed, so the consumer measures
+ * how long it was in the queue. Returns messages per second and latency
+ * percentiles in microseconds.
+ **/
+template <typename Queue>
+Result run_queue(Queue &queue, size_t producers, size_t count)
+{
+	std::vector<double> latency;
+	std::vector<std::thread> threads;
+
+	latency.reserve(producers * count);
+	auto const start = Clock::now();
+	for (size_t p = 0; p != producers; ++p) {
+		threads.emplace_back([&queue, p, count] {
+			for (size_t i = 0; i != count; ++i)
+				queue.push(Stamp{p, Clock::now()});
+		});
+	}
+
+	Stamp stamp;
+	while (latency.size() != producers * count) {
+		if (!queue.pop(stamp)) {
+			std::this_thread::yield();
+			continue;
+		}
+		latency.push_back(std::chrono::duration<double, std::micro>(
+					Clock::now() - stamp.pushed).count());
+	}
+	auto const stop = Clock::now();
+	for (std::thread &thread : threads)
+		thread.join();
+
+	Result result;
+	result.ops = latency.size() /
+		std::chrono::duration<double>(stop - start).count();
+	result.p50 = percentile(latency, 0.5);
+	result.p99 = percentile(latency, 0.99);
+	result.p999 = percentile(latency, 0.999);
+	return result;
+}
+
+void print_row(size_t producers, char const *name, Result const &result)
+{
+	std::cout << producers << "\t" << name << "\t" << result.ops / 1e6
+		<< "\t" << result.p50 << "\t" << result.p99 << "\t"
+		<< result.p999 << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+	size_t const count = argc > 1 ? atol(argv[1]) : 1000000;
+	size_t const max = argc > 2 ? atol(argv[2])
+		: std::max(std::thread::hardware_concurrency(), 1u);
+	size_t const capacity = argc > 3 ? atol(argv[3]) : 4096;
+
+	std::cout << count << " messages per producer, one consumer, "
+		<< "Mops/s and latency in microseconds" << std::endl;
+	std::cout << "producers\tqueue\tMops/s\tp50\tp99\tp99.9"
+		<< std::endl;
+
+	for (size_t producers = 1; producers <= max; producers *= 2) {
+		MutexQueue mutex;
+		print_row(producers, "mutex LinkedList",
+				run_queue(mutex, producers, count));
+
+		IntrusiveQueue mpsc(producers, count);
+		print_row(producers, "MpscQueue",
+				run_queue(mpsc, producers, count));
+
+		RingQueue mpmc(capacity);
+		print_row(producers, "MpmcQueue",
+				run_queue(mpmc, producers, count));
+	}
+
+	return 0;
+}
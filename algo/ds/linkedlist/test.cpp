@@ -1,10 +1,18 @@
+#include "intrusivelist.hpp"
 #include "linkedlist.hpp"
+#include "mpmcqueue.hpp"
+#include "mpscqueue.hpp"
+#include "unrolledlist.hpp"
 
 #include <algorithm>
 #include <cassert>
 #include <cstdlib>
 #include <iostream>
 #include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 template <typename Ct>
@@ -115,6 +123,767 @@ void run_reverse_test(size_t size)
 		std::reverse_iterator<iterator>(end(copy))));
 }
 
+void check_list(LinkedList<int> const &list, std::vector<int> const &check)
+{
+	using reverse = std::reverse_iterator<LinkedList<int>::const_iterator>;
+
+	assert(list.size() == check.size());
+	assert(list.empty() == check.empty());
+	assert(static_cast<size_t>(std::distance(list.begin(), list.end()))
+			== check.size());
+	assert(std::equal(check.begin(), check.end(), list.begin()));
+	assert(std::equal(check.rbegin(), check.rend(), reverse(list.end())));
+}
+
+void run_move_test(size_t size)
+{
+	std::vector<int> source;
+	fill_random(source, size);
+
+	LinkedList<int> list(source.begin(), source.end());
+	LinkedList<int> moved(std::move(list));
+	check_list(moved, source);
+	check_list(list, std::vector<int>());
+
+	LinkedList<int> other = {1, 2};
+	other.swap(moved);
+	check_list(other, source);
+	check_list(moved, std::vector<int>{1, 2});
+
+	moved.pop_back();
+	list.push_back(3);
+	check_list(moved, std::vector<int>{1});
+	check_list(list, std::vector<int>{3});
+}
+
+void run_splice_test(size_t size)
+{
+	std::vector<int> first, second;
+	fill_random(first, size);
+	fill_random(second, size);
+
+	LinkedList<int> to(first.begin(), first.end());
+	LinkedList<int> from(second.begin(), second.end());
+
+	/* iterators stay valid and follow the elements */
+	LinkedList<int>::iterator const moved = from.begin();
+	size_t const at = size / 3;
+
+	to.splice(std::next(to.begin(), at), from);
+	first.insert(first.begin() + at, second.begin(), second.end());
+	second.clear();
+	check_list(to, first);
+	check_list(from, second);
+	if (size)
+		assert(std::distance(to.begin(), moved)
+				== static_cast<ptrdiff_t>(at));
+
+	/* ranges and single nodes back and forth */
+	for (size_t i = 0; i != 100 && !first.empty(); ++i) {
+		size_t const begin = rand() % first.size();
+		size_t const end = begin + rand() % (first.size() - begin + 1);
+		size_t const pos = rand() % (second.size() + 1);
+
+		from.splice(std::next(from.begin(), pos), to,
+				std::next(to.begin(), begin),
+				std::next(to.begin(), end));
+		second.insert(second.begin() + pos, first.begin() + begin,
+				first.begin() + end);
+		first.erase(first.begin() + begin, first.begin() + end);
+		check_list(to, first);
+		check_list(from, second);
+
+		if (second.empty())
+			continue;
+
+		size_t const node = rand() % second.size();
+		size_t const into = rand() % (first.size() + 1);
+
+		to.splice(std::next(to.begin(), into), from,
+				std::next(from.begin(), node));
+		first.insert(first.begin() + into, second[node]);
+		second.erase(second.begin() + node);
+		check_list(to, first);
+		check_list(from, second);
+	}
+
+	/* within one list */
+	for (size_t i = 0; i != 100 && first.size() > 1; ++i) {
+		size_t const begin = rand() % first.size();
+		size_t const end = begin + 1 + rand() % (first.size() - begin);
+		size_t const pos = rand() % (first.size() - end + begin + 1);
+		std::vector<int> range(first.begin() + begin,
+					first.begin() + end);
+
+		first.erase(first.begin() + begin, first.begin() + end);
+		LinkedList<int>::iterator it = std::next(to.begin(),
+				pos < begin ? pos : pos + end - begin);
+		to.splice(it, to, std::next(to.begin(), begin),
+				std::next(to.begin(), end));
+		first.insert(first.begin() + pos, range.begin(), range.end());
+		check_list(to, first);
+
+		size_t const node = rand() % first.size();
+		size_t const into = rand() % (first.size() + 1);
+		int const x = first[node];
+
+		to.splice(std::next(to.begin(), into), to,
+				std::next(to.begin(), node));
+		first.insert(first.begin() + into, x);
+		first.erase(first.begin() + node + (into <= node ? 1 : 0));
+		check_list(to, first);
+	}
+}
+
+/**
+ * Keys repeat a lot, so stability shows up: the order of equal keys is
+ * given by the second member.
+ **/
+using Tagged = std::pair<int, size_t>;
+
+struct KeyLess {
+	bool operator()(Tagged const &l, Tagged const &r) const
+	{ return l.first < r.first; }
+};
+
+std::vector<Tagged> make_tagged(size_t size, size_t tag)
+{
+	std::vector<Tagged> tagged;
+
+	for (size_t i = 0; i != size; ++i)
+		tagged.push_back(Tagged(rand() % 16, tag + i));
+	return tagged;
+}
+
+void run_sort_test(size_t size)
+{
+	std::vector<Tagged> check = make_tagged(size, 0);
+	LinkedList<Tagged> list(check.begin(), check.end());
+	LinkedList<Tagged>::iterator const first = list.begin();
+
+	list.sort(KeyLess());
+	std::stable_sort(check.begin(), check.end(), KeyLess());
+	assert(list.size() == check.size());
+	assert(std::equal(check.begin(), check.end(), list.begin()));
+	assert(std::equal(check.rbegin(), check.rend(),
+		std::reverse_iterator<LinkedList<Tagged>::iterator>(
+			list.end())));
+	if (size)
+		assert(first->second == 0);
+
+	std::vector<int> ints;
+	fill_random(ints, size);
+	LinkedList<int> sorted(ints.begin(), ints.end());
+	sorted.sort();
+	std::sort(ints.begin(), ints.end());
+	check_list(sorted, ints);
+}
+
+void run_merge_test(size_t size)
+{
+	std::vector<Tagged> first = make_tagged(size, 0);
+	std::vector<Tagged> second = make_tagged(size / 2 + 1, size);
+
+	std::sort(first.begin(), first.end(), KeyLess());
+	std::sort(second.begin(), second.end(), KeyLess());
+
+	LinkedList<Tagged> to(first.begin(), first.end());
+	LinkedList<Tagged> from(second.begin(), second.end());
+	std::vector<Tagged> check;
+
+	to.merge(from, KeyLess());
+	std::merge(first.begin(), first.end(), second.begin(), second.end(),
+			std::back_inserter(check), KeyLess());
+	assert(from.empty() && from.size() == 0);
+	assert(to.size() == check.size());
+	assert(std::equal(check.begin(), check.end(), to.begin()));
+	assert(std::equal(check.rbegin(), check.rend(),
+		std::reverse_iterator<LinkedList<Tagged>::iterator>(
+			to.end())));
+
+	LinkedList<int> ints = {1, 3, 5};
+	LinkedList<int> empty;
+	ints.merge(empty);
+	empty.merge(ints);
+	check_list(ints, std::vector<int>());
+	check_list(empty, std::vector<int>{1, 3, 5});
+}
+
+/**
+ * Counts live allocations of all CountingAllocators.
+ **/
+long allocated = 0;
+
+template <typename T>
+struct CountingAllocator {
+	using value_type = T;
+
+	CountingAllocator() = default;
+
+	template <typename U>
+	CountingAllocator(CountingAllocator<U> const &)
+	{ }
+
+	T *allocate(size_t n)
+	{
+		++allocated;
+		return std::allocator<T>().allocate(n);
+	}
+
+	void deallocate(T *ptr, size_t n)
+	{
+		--allocated;
+		std::allocator<T>().deallocate(ptr, n);
+	}
+};
+
+template <typename T, typename U>
+bool operator==(CountingAllocator<T> const &, CountingAllocator<U> const &)
+{ return true; }
+
+template <typename T, typename U>
+bool operator!=(CountingAllocator<T> const &, CountingAllocator<U> const &)
+{ return false; }
+
+void run_node_cache_test(size_t size)
+{
+	using List = LinkedList<int, CountingAllocator<int>>;
+
+	{
+		List fifo;
+		std::vector<int> check;
+
+		fifo.set_node_cache_limit(16);
+		for (size_t i = 0; i != size; ++i) {
+			fifo.push_back(static_cast<int>(i));
+			check.push_back(static_cast<int>(i));
+		}
+		assert(allocated == static_cast<long>(size));
+
+		/* a FIFO swinging within the limit doesn't allocate */
+		for (size_t i = 0; i != 10 * size; ++i) {
+			int const x = rand();
+
+			if (i % 32 < 16) {
+				if (fifo.empty())
+					continue;
+				fifo.pop_front();
+				check.erase(check.begin());
+			} else {
+				fifo.push_back(x);
+				check.push_back(x);
+			}
+			assert(fifo.cached_nodes() <= 16);
+		}
+		assert(allocated <= static_cast<long>(size) + 16);
+		assert(allocated == static_cast<long>(fifo.size()
+						+ fifo.cached_nodes()));
+		assert(fifo.size() == check.size());
+		assert(std::equal(check.begin(), check.end(), fifo.begin()));
+
+		/* the cache goes with moves and swaps */
+		List copy(fifo);
+		assert(copy.node_cache_limit() == 16);
+		copy.clear();
+		assert(copy.cached_nodes()
+				== std::min<size_t>(check.size(), 16));
+
+		List moved(std::move(copy));
+		assert(moved.node_cache_limit() == 16);
+		assert(copy.cached_nodes() == 0);
+		moved.swap(fifo);
+		assert(fifo.empty() && moved.size() == check.size());
+		assert(std::equal(check.begin(), check.end(), moved.begin()));
+
+		fifo.set_node_cache_limit(4);
+		assert(fifo.cached_nodes() <= 4);
+		fifo.set_node_cache_limit(0);
+		assert(fifo.cached_nodes() == 0);
+		assert(allocated == static_cast<long>(moved.size()
+						+ moved.cached_nodes()));
+	}
+	assert(allocated == 0);
+}
+
+/**
+ * A connection is in the list of all connections (member hook) and in
+ * either active or idle list (two tagged base hooks).
+ **/
+struct ActiveTag;
+struct IdleTag;
+
+using SafeHook = IntrusiveListHook<IntrusiveLinkMode::safe_unlink>;
+using ActiveHook = IntrusiveListHook<IntrusiveLinkMode::safe_unlink,
+					ActiveTag>;
+using IdleHook = IntrusiveListHook<IntrusiveLinkMode::safe_unlink, IdleTag>;
+
+struct Connection : public ActiveHook, public IdleHook {
+	int id;
+	SafeHook all;
+
+	explicit Connection(int id = 0)
+	: id(id)
+	{ }
+};
+
+using ActiveList = IntrusiveList<Connection,
+			IntrusiveBaseHook<Connection, ActiveHook>>;
+using IdleList = IntrusiveList<Connection,
+			IntrusiveBaseHook<Connection, IdleHook>>;
+using AllList = IntrusiveList<Connection,
+			IntrusiveMemberHook<Connection, SafeHook,
+						&Connection::all>>;
+
+template <typename List>
+void check_ids(List const &list, std::vector<int> const &check)
+{
+	using reverse = std::reverse_iterator<typename List::const_iterator>;
+	auto const same = [](int id, Connection const &conn)
+			{ return id == conn.id; };
+
+	assert(list.size() == check.size());
+	assert(list.empty() == check.empty());
+	assert(std::equal(check.begin(), check.end(), list.begin(), same));
+	assert(std::equal(check.rbegin(), check.rend(), reverse(list.end()),
+				same));
+}
+
+void run_intrusive_test(size_t size)
+{
+	std::vector<Connection> conns;
+	for (size_t i = 0; i != size; ++i)
+		conns.push_back(Connection(static_cast<int>(i)));
+
+	AllList all(conns.begin(), conns.end());
+	ActiveList active;
+	IdleList idle;
+	std::vector<int> all_ids, active_ids, idle_ids;
+
+	for (Connection &conn : all) {
+		all_ids.push_back(conn.id);
+		idle.push_back(conn);
+		idle_ids.push_back(conn.id);
+	}
+	check_ids(all, all_ids);
+	check_ids(idle, idle_ids);
+
+	/* connections go idle and active, and hang up */
+	for (size_t i = 0; i != 2 * size; ++i) {
+		Connection &conn = conns[rand() % size];
+		std::vector<int>::iterator in_active = std::find(
+			active_ids.begin(), active_ids.end(), conn.id);
+		std::vector<int>::iterator in_idle = std::find(
+			idle_ids.begin(), idle_ids.end(), conn.id);
+
+		switch (rand() % 3) {
+		case 0:
+			if (in_idle == idle_ids.end())
+				break;
+			idle.erase(conn);
+			idle_ids.erase(in_idle);
+			assert(!static_cast<IdleHook &>(conn).linked());
+			active.push_back(conn);
+			active_ids.push_back(conn.id);
+			break;
+		case 1:
+			if (in_active == active_ids.end())
+				break;
+			active.erase(active.iterator_to(conn));
+			active_ids.erase(in_active);
+			idle.push_front(conn);
+			idle_ids.insert(idle_ids.begin(), conn.id);
+			break;
+		default:
+			if (!conn.all.linked())
+				break;
+			all.erase(conn);
+			all_ids.erase(std::find(all_ids.begin(), all_ids.end(),
+						conn.id));
+			if (in_idle != idle_ids.end()) {
+				idle.erase(conn);
+				idle_ids.erase(in_idle);
+			}
+			if (in_active != active_ids.end()) {
+				active.erase(conn);
+				active_ids.erase(in_active);
+			}
+			break;
+		}
+	}
+	check_ids(all, all_ids);
+	check_ids(active, active_ids);
+	check_ids(idle, idle_ids);
+
+	/* moving lists and nodes relinks, values stay where they are */
+	ActiveList moved(std::move(active));
+	check_ids(moved, active_ids);
+	check_ids(active, std::vector<int>());
+
+	moved.splice(moved.begin(), moved, std::prev(moved.end()));
+	if (!active_ids.empty())
+		std::rotate(active_ids.begin(), std::prev(active_ids.end()),
+				active_ids.end());
+	check_ids(moved, active_ids);
+
+	active.splice(active.end(), moved, moved.begin(),
+			std::next(moved.begin(), active_ids.size() / 2));
+	moved.swap(active);
+	active.splice(active.begin(), moved);
+	check_ids(active, active_ids);
+	check_ids(moved, std::vector<int>());
+
+	/* lists reset hooks of values they drop */
+	active.clear();
+	idle.clear();
+	all.clear();
+	for (Connection const &conn : conns) {
+		assert(!static_cast<ActiveHook const &>(conn).linked());
+		assert(!static_cast<IdleHook const &>(conn).linked());
+		assert(!conn.all.linked());
+	}
+}
+
+struct Timer : public IntrusiveListHook<IntrusiveLinkMode::auto_unlink> {
+	int id;
+
+	explicit Timer(int id)
+	: id(id)
+	{ }
+};
+
+void run_auto_unlink_test(size_t size)
+{
+	IntrusiveList<Timer, IntrusiveBaseHook<Timer,
+		IntrusiveListHook<IntrusiveLinkMode::auto_unlink>>> timers;
+	std::vector<std::unique_ptr<Timer>> owned;
+
+	for (size_t i = 0; i != size; ++i) {
+		owned.emplace_back(new Timer(static_cast<int>(i)));
+		timers.push_back(*owned.back());
+	}
+	assert(timers.size() == size);
+
+	/* values that go away leave the list on their own */
+	for (size_t i = 0; i < owned.size(); ++i)
+		owned.erase(owned.begin() + i);
+	assert(timers.size() == owned.size());
+	assert(std::equal(owned.begin(), owned.end(), timers.begin(),
+		[](std::unique_ptr<Timer> const &l, Timer const &r)
+		{ return l->id == r.id; }));
+
+	/* and the list going away leaves values unlinked */
+	{
+		decltype(timers) other;
+		other.splice(other.end(), timers);
+		assert(timers.empty() && other.size() == owned.size());
+	}
+	for (std::unique_ptr<Timer> const &timer : owned)
+		assert(!timer->linked());
+}
+
+/**
+ * Small nodes split and merge all the time, strings aren't trivial, so
+ * lost or doubled elements show up in sanitizers.
+ **/
+using SmallUnrolled = UnrolledList<int, std::allocator<int>, 4>;
+using TextUnrolled = UnrolledList<std::string, std::allocator<std::string>, 5>;
+
+template <typename T>
+T make_value(int x)
+{ return static_cast<T>(x); }
+
+template <>
+std::string make_value<std::string>(int x)
+{ return std::to_string(x) + std::string(20, '.'); }
+
+template <typename List>
+void check_unrolled(List const &list,
+		std::vector<typename List::value_type> const &check)
+{
+	using reverse = std::reverse_iterator<typename List::const_iterator>;
+
+	assert(list.size() == check.size());
+	assert(list.empty() == check.empty());
+	assert(static_cast<size_t>(std::distance(list.begin(), list.end()))
+			== check.size());
+	assert(std::equal(check.begin(), check.end(), list.begin()));
+	assert(std::equal(check.rbegin(), check.rend(), reverse(list.end())));
+}
+
+/* every node but the last is at least half full */
+template <typename List>
+void check_unrolled_fill(List const &list)
+{
+	typename List::const_iterator it = list.begin();
+
+	while (it != list.end()) {
+		ListHead const *const node = it.node;
+		size_t count = 0;
+
+		for (; it != list.end() && it.node == node; ++it)
+			++count;
+		assert(it == list.end() || count >= List::capacity / 2);
+	}
+}
+
+template <typename List>
+void run_unrolled_test(size_t size)
+{
+	using T = typename List::value_type;
+
+	List list;
+	std::vector<T> check;
+
+	for (size_t i = 0; i != size; ++i) {
+		T const x = make_value<T>(rand());
+		size_t const at = check.empty() ? 0 : rand() % check.size();
+
+		switch (rand() % 4) {
+		case 0:
+			list.push_back(x);
+			check.push_back(x);
+			break;
+		case 1:
+			list.push_front(x);
+			check.insert(check.begin(), x);
+			break;
+		default: {
+			typename List::iterator it = list.insert(
+				std::next(list.begin(), at), x);
+
+			check.insert(check.begin() + at, x);
+			assert(*it == x);
+			assert(std::distance(list.begin(), it)
+				== static_cast<ptrdiff_t>(at));
+			break;
+		}
+		}
+	}
+	check_unrolled(list, check);
+
+	List copy(list);
+	check_unrolled(copy, check);
+
+	std::vector<T> reversed(check.rbegin(), check.rend());
+	copy.reverse();
+	check_unrolled(copy, reversed);
+
+	/* erase returns the position of the next element */
+	while (check.size() > size / 2) {
+		size_t const at = rand() % check.size();
+		typename List::iterator it = list.erase(
+				std::next(list.begin(), at));
+
+		check.erase(check.begin() + at);
+		assert(std::distance(list.begin(), it)
+				== static_cast<ptrdiff_t>(at));
+		if (at != check.size())
+			assert(*it == check[at]);
+	}
+	check_unrolled(list, check);
+
+	/* ranges within a node and over many nodes */
+	while (!check.empty()) {
+		size_t const first = rand() % check.size();
+		size_t const last = first + rand() %
+			(std::min<size_t>(check.size() - first, 20) + 1);
+		typename List::iterator it = list.erase(
+				std::next(list.begin(), first),
+				std::next(list.begin(), last));
+
+		check.erase(check.begin() + first, check.begin() + last);
+		assert(std::distance(list.begin(), it)
+				== static_cast<ptrdiff_t>(first));
+		check_unrolled(list, check);
+		check_unrolled_fill(list);
+
+		if (!check.empty() && rand() % 4 == 0) {
+			T const x = make_value<T>(rand());
+
+			list.pop_front();
+			check.erase(check.begin());
+			list.push_back(x);
+			check.push_back(x);
+		}
+	}
+	check_unrolled(list, check);
+
+	std::vector<T> source;
+	for (size_t i = 0; i != size; ++i)
+		source.push_back(make_value<T>(static_cast<int>(i)));
+
+	List ranged(source.begin(), source.end());
+	check_unrolled(ranged, source);
+
+	/* a range in the middle */
+	size_t const middle = size / 2;
+	typename List::iterator it = ranged.insert(
+			std::next(ranged.begin(), middle),
+			source.begin(), source.end());
+	std::vector<T> const twice(source);
+	source.insert(source.begin() + middle, twice.begin(), twice.end());
+	check_unrolled(ranged, source);
+	assert(std::distance(ranged.begin(), it)
+			== static_cast<ptrdiff_t>(middle));
+
+	ranged.erase(ranged.begin(), ranged.end());
+	check_unrolled(ranged, std::vector<T>());
+}
+
+template <typename List>
+void run_unrolled_move_test(size_t size)
+{
+	using T = typename List::value_type;
+
+	std::vector<T> source;
+	for (size_t i = 0; i != size; ++i)
+		source.push_back(make_value<T>(rand()));
+
+	List list(source.begin(), source.end());
+	List moved(std::move(list));
+	check_unrolled(moved, source);
+	check_unrolled(list, std::vector<T>());
+
+	List other = {make_value<T>(1), make_value<T>(2)};
+	other.swap(moved);
+	check_unrolled(other, source);
+	check_unrolled(moved, std::vector<T>{make_value<T>(1),
+					make_value<T>(2)});
+
+	moved = other;
+	check_unrolled(moved, source);
+	moved = List();
+	check_unrolled(moved, std::vector<T>());
+
+	/* moved from and swapped lists are usable */
+	list.push_back(make_value<T>(3));
+	moved.push_front(make_value<T>(4));
+	assert(*list.begin() == make_value<T>(3));
+	assert(*moved.begin() == make_value<T>(4));
+	list.pop_back();
+	assert(list.empty());
+}
+
+struct Message : public MpscQueueHook {
+	size_t producer;
+	size_t seq;
+	IntrusiveListHook<> hook;
+	MpscQueueHook queued;
+};
+
+/**
+ * Every producer pushes its own messages in order, the consumer must see
+ * them in that order and every one of them exactly once.
+ **/
+void run_mpsc_test(size_t producers, size_t count)
+{
+	std::vector<std::vector<Message>> messages(producers,
+				std::vector<Message>(count));
+	std::vector<std::thread> threads;
+	MpscQueue<Message> queue;
+
+	assert(queue.empty() && !queue.pop());
+	for (size_t p = 0; p != producers; ++p) {
+		threads.emplace_back([&messages, &queue, p, count] {
+			for (size_t i = 0; i != count; ++i) {
+				Message &message = messages[p][i];
+
+				message.producer = p;
+				message.seq = i;
+				queue.push(message);
+			}
+		});
+	}
+
+	std::vector<size_t> next(producers);
+	for (size_t popped = 0; popped != producers * count; ) {
+		Message *message = queue.pop();
+
+		if (!message) {
+			std::this_thread::yield();
+			continue;
+		}
+		assert(message->seq == next[message->producer]);
+		++next[message->producer];
+		++popped;
+	}
+	for (std::thread &thread : threads)
+		thread.join();
+	assert(queue.empty() && !queue.pop());
+
+	/* member hooks, values are reused after they were popped */
+	MpscQueue<Message, IntrusiveMemberHook<Message, MpscQueueHook,
+					&Message::queued>> members;
+	for (size_t round = 0; round != 3; ++round) {
+		for (Message &message : messages[0])
+			members.push(message);
+		for (Message &message : messages[0])
+			assert(members.pop() == &message);
+		assert(members.empty() && !members.pop());
+	}
+}
+
+/**
+ * Producers and consumers race for the same cells of a small ring, every
+ * consumer must see messages of every producer in order.
+ **/
+void run_mpmc_test(size_t producers, size_t consumers, size_t count,
+			size_t capacity)
+{
+	using Item = std::pair<size_t, size_t>;
+
+	MpmcQueue<Item> queue(capacity);
+	std::vector<std::thread> threads;
+	std::atomic<size_t> popped(0);
+	std::vector<size_t> sums(consumers);
+
+	assert(queue.capacity() >= capacity);
+	for (size_t p = 0; p != producers; ++p) {
+		threads.emplace_back([&queue, p, count] {
+			for (size_t i = 0; i != count; ++i) {
+				while (!queue.try_push(Item(p, i)))
+					std::this_thread::yield();
+			}
+		});
+	}
+	for (size_t c = 0; c != consumers; ++c) {
+		threads.emplace_back([&, c] {
+			std::vector<size_t> next(producers);
+			Item item;
+
+			while (popped.load() != producers * count) {
+				if (!queue.try_pop(item)) {
+					std::this_thread::yield();
+					continue;
+				}
+				assert(item.second >= next[item.first]);
+				next[item.first] = item.second + 1;
+				sums[c] += item.second;
+				++popped;
+			}
+		});
+	}
+	for (std::thread &thread : threads)
+		thread.join();
+
+	size_t sum = 0;
+	for (size_t x : sums)
+		sum += x;
+	assert(sum == producers * count * (count - 1) / 2);
+
+	/* the ring is full and the leftovers are destroyed with the queue */
+	MpmcQueue<std::string> strings(5);
+	size_t pushed = 0;
+	while (strings.try_push(make_value<std::string>(pushed)))
+		++pushed;
+	assert(pushed == strings.capacity() && pushed == 8);
+
+	std::string text;
+	assert(strings.try_pop(text) && text == make_value<std::string>(0));
+	assert(strings.try_emplace(text));
+	assert(!strings.try_push(text));
+}
+
 int main(void)
 {
 	for (size_t size : {0, 1, 10, 100, 1000, 10000}) {
@@ -123,7 +892,26 @@ int main(void)
 		run_copy_test(size);
 		run_reverse_simple_test(size);
 		run_reverse_test(size);
+		run_move_test(size);
+		run_splice_test(size);
+		run_sort_test(size);
+		run_merge_test(size);
+		run_node_cache_test(size);
+		run_intrusive_test(size);
+		run_auto_unlink_test(size);
+
+		run_unrolled_test<SmallUnrolled>(size);
+		run_unrolled_test<TextUnrolled>(size);
+		run_unrolled_test<UnrolledList<int>>(size);
+		run_unrolled_move_test<SmallUnrolled>(size);
+		run_unrolled_move_test<TextUnrolled>(size);
 	}
 
+	run_mpsc_test(1, 100000);
+	run_mpsc_test(4, 100000);
+	run_mpmc_test(1, 1, 100000, 4);
+	run_mpmc_test(4, 4, 100000, 16);
+	run_mpmc_test(8, 2, 50000, 1024);
+
 	return 0;
 }
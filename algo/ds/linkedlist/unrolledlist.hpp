@@ -0,0 +1,617 @@
+#ifndef __UNROLLED_LIST_HPP__
+#define __UNROLLED_LIST_HPP__
+
+#include "listhead.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Unrolled linked list node keeps up to Capacity elements next to each
+ * other, so a scan pays a pointer chase (and likely a cache miss) per node
+ * instead of per element. Default Capacity fills about unrolled_node_size
+ * bytes, but at least 4 elements.
+ **/
+size_t const unrolled_node_size = 256;
+
+template <typename T>
+struct UnrolledListCapacity {
+	static size_t const header = sizeof(ListHead) + sizeof(size_t);
+	static size_t const fit = sizeof(T) < unrolled_node_size - header
+		? (unrolled_node_size - header) / sizeof(T) : 0;
+	static size_t const value = fit < 4 ? 4 : fit;
+};
+
+/**
+ * Elements are kept in raw storage: only the first count slots hold
+ * constructed elements.
+ **/
+template <typename T, size_t Capacity>
+struct UnrolledListNode : public ListHead {
+	using Slot = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+	size_t count;
+	Slot slots[Capacity];
+
+	UnrolledListNode()
+	: ListHead(), count(0)
+	{ }
+
+	T *data()
+	{ return reinterpret_cast<T *>(slots); }
+
+	T const *data() const
+	{ return reinterpret_cast<T const *>(slots); }
+};
+
+/**
+ * Iterator is a node and an index in it, end() is the dummy head with
+ * index 0 (the head is a plain ListHead, so its count is never read).
+ **/
+template <typename T, size_t Capacity>
+struct UnrolledListIterator : public std::iterator<
+				std::bidirectional_iterator_tag, T> {
+	using Self = UnrolledListIterator<T, Capacity>;
+	using Node = UnrolledListNode<T, Capacity>;
+	using Trait = std::iterator_traits<Self>;
+	using Ref = typename Trait::reference;
+	using Ptr = typename Trait::pointer;
+
+	ListHead *node;
+	size_t index;
+
+	UnrolledListIterator()
+	: node(), index()
+	{ }
+
+	explicit UnrolledListIterator(ListHead *node, size_t index = 0)
+	: node(node), index(index)
+	{ }
+
+	Ref operator*() const
+	{ return static_cast<Node *>(node)->data()[index]; }
+
+	Ptr operator->() const
+	{ return std::addressof(static_cast<Node *>(node)->data()[index]); }
+
+	Self &operator++()
+	{
+		if (++index == static_cast<Node *>(node)->count) {
+			node = node->next;
+			index = 0;
+		}
+		return *this;
+	}
+
+	Self operator++(int)
+	{
+		Self tmp = *this;
+		++*this;
+		return tmp;
+	}
+
+	Self &operator--()
+	{
+		if (!index) {
+			node = node->prev;
+			index = static_cast<Node *>(node)->count;
+		}
+		--index;
+		return *this;
+	}
+
+	Self operator--(int)
+	{
+		Self tmp = *this;
+		--*this;
+		return tmp;
+	}
+
+	bool operator==(Self const &other) const
+	{ return node == other.node && index == other.index; }
+
+	bool operator!=(Self const &other) const
+	{ return !(*this == other); }
+};
+
+template <typename T, size_t Capacity>
+struct UnrolledListConstIterator : public std::iterator<
+				std::bidirectional_iterator_tag, T,
+				ptrdiff_t, T const *, T const &> {
+	using Self = UnrolledListConstIterator<T, Capacity>;
+	using Iter = UnrolledListIterator<T, Capacity>;
+	using Node = UnrolledListNode<T, Capacity> const;
+	using Trait = std::iterator_traits<Self>;
+	using Ref = typename Trait::reference;
+	using Ptr = typename Trait::pointer;
+
+	ListHead const *node;
+	size_t index;
+
+	UnrolledListConstIterator()
+	: node(), index()
+	{ }
+
+	explicit UnrolledListConstIterator(ListHead const *node,
+				size_t index = 0)
+	: node(node), index(index)
+	{ }
+
+	UnrolledListConstIterator(Iter it)
+	: node(it.node), index(it.index)
+	{ }
+
+	Ref operator*() const
+	{ return static_cast<Node *>(node)->data()[index]; }
+
+	Ptr operator->() const
+	{ return std::addressof(static_cast<Node *>(node)->data()[index]); }
+
+	Self &operator++()
+	{
+		if (++index == static_cast<Node *>(node)->count) {
+			node = node->next;
+			index = 0;
+		}
+		return *this;
+	}
+
+	Self operator++(int)
+	{
+		Self tmp = *this;
+		++*this;
+		return tmp;
+	}
+
+	Self &operator--()
+	{
+		if (!index) {
+			node = node->prev;
+			index = static_cast<Node *>(node)->count;
+		}
+		--index;
+		return *this;
+	}
+
+	Self operator--(int)
+	{
+		Self tmp = *this;
+		--*this;
+		return tmp;
+	}
+
+	bool operator==(Self const &other) const
+	{ return node == other.node && index == other.index; }
+
+	bool operator!=(Self const &other) const
+	{ return !(*this == other); }
+};
+
+/**
+ * See the comment to the same operators for LinkedListIterator.
+ **/
+template <typename T, size_t Capacity>
+inline bool operator==(UnrolledListIterator<T, Capacity> const &lhs,
+			UnrolledListConstIterator<T, Capacity> const &rhs)
+{ return lhs.node == rhs.node && lhs.index == rhs.index; }
+
+template <typename T, size_t Capacity>
+inline bool operator!=(UnrolledListIterator<T, Capacity> const &lhs,
+			UnrolledListConstIterator<T, Capacity> const &rhs)
+{ return !(lhs == rhs); }
+
+/**
+ * Sequence with the interface of LinkedList, but nodes hold up to Capacity
+ * elements. Insert into a full node splits it in halves, erase merges a
+ * node less than half full with the next one or borrows from it, so nodes
+ * (but the last) stay at least about a quarter full. There is no splice,
+ * merge and sort: they are cheap in LinkedList only because elements never
+ * move.
+ *
+ * Unlike LinkedList, insert and erase move elements within and between
+ * nodes, so they invalidate iterators. Moves of elements must not throw,
+ * insert is strongly exception safe otherwise.
+ **/
+template <typename T, typename Alloc = std::allocator<T>,
+	size_t Capacity = UnrolledListCapacity<T>::value>
+class UnrolledList {
+	static_assert(Capacity >= 2, "nodes must hold at least 2 elements");
+
+	using Self = UnrolledList<T, Alloc, Capacity>;
+	using Node = UnrolledListNode<T, Capacity>;
+	using ValueAllocTrait = std::allocator_traits<Alloc>;
+	using NodeAlloc = typename
+		ValueAllocTrait::template rebind_alloc<Node>;
+	using NodeAllocTrait = std::allocator_traits<NodeAlloc>;
+
+	struct Impl : public NodeAlloc {
+		ListHead head;
+		size_t size;
+
+		Impl(NodeAlloc const &a)
+		: NodeAlloc(a), size(0)
+		{ init_list_head(&head); }
+
+		Impl(NodeAlloc &&a)
+		: NodeAlloc(std::move(a)), size(0)
+		{ init_list_head(&head); }
+	};
+
+public:
+	using iterator = UnrolledListIterator<T, Capacity>;
+	using const_iterator = UnrolledListConstIterator<T, Capacity>;
+	using value_type = typename iterator::value_type;
+	using reference = typename iterator::reference;
+	using const_reference = typename const_iterator::reference;
+	using size_type = size_t;
+
+	static size_t const capacity = Capacity;
+
+	UnrolledList()
+	: impl(NodeAlloc())
+	{ }
+
+	explicit UnrolledList(Alloc const &a)
+	: impl(NodeAlloc(a))
+	{ }
+
+	UnrolledList(Self const &other)
+	: impl(NodeAllocTrait::select_on_container_copy_construction(
+		other.node_allocator()))
+	{ insert(end(), other.begin(), other.end()); }
+
+	UnrolledList(std::initializer_list<T> other, Alloc const &a = Alloc())
+	: impl(NodeAlloc(a))
+	{ insert(end(), other.begin(), other.end()); }
+
+	template <typename It>
+	UnrolledList(It first, It last, Alloc const &a = Alloc())
+	: impl(NodeAlloc(a))
+	{ insert(end(), first, last); }
+
+	UnrolledList(Self &&other) noexcept
+	: impl(std::move(other.node_allocator()))
+	{
+		move_list(&impl.head, &other.impl.head);
+		impl.size = other.impl.size;
+		other.impl.size = 0;
+	}
+
+	~UnrolledList()
+	{ clear(); }
+
+	/* copy and swap, see LinkedList */
+	Self &operator=(Self other)
+	{
+		swap(other);
+		return *this;
+	}
+
+	/**
+	 * Nodes point to the dummy heads, so heads are relinked rather than
+	 * swapped.
+	 **/
+	void swap(Self &other) noexcept
+	{
+		using std::swap;
+		ListHead tmp;
+
+		move_list(&tmp, &impl.head);
+		move_list(&impl.head, &other.impl.head);
+		move_list(&other.impl.head, &tmp);
+		swap(impl.size, other.impl.size);
+		swap(node_allocator(), other.node_allocator());
+	}
+
+	void clear()
+	{
+		ListHead *pos = impl.head.next;
+
+		while (pos != &impl.head) {
+			ListHead *next = pos->next;
+			Node *node = static_cast<Node *>(pos);
+
+			destroy_range(node->data(), node->data() + node->count);
+			free_node(node);
+			pos = next;
+		}
+		init_list_head(&impl.head);
+		impl.size = 0;
+	}
+
+	bool empty() const
+	{ return !impl.size; }
+
+	size_t size() const
+	{ return impl.size; }
+
+	iterator begin()
+	{ return iterator(impl.head.next); }
+
+	const_iterator begin() const
+	{ return const_iterator(impl.head.next); }
+
+	iterator end()
+	{ return iterator(&impl.head); }
+
+	const_iterator end() const
+	{ return const_iterator(&impl.head); }
+
+	void push_back(T const &x)
+	{ insert(end(), x); }
+
+	void push_back(T &&x)
+	{ insert(end(), std::forward<T>(x)); }
+
+	template <typename ... Args>
+	void emplace_back(Args && ... args)
+	{ emplace(end(), std::forward<Args>(args)...); }
+
+	void pop_back()
+	{ erase(std::prev(end())); }
+
+	void push_front(T const &x)
+	{ insert(begin(), x); }
+
+	void push_front(T &&x)
+	{ insert(begin(), std::forward<T>(x)); }
+
+	template <typename ... Args>
+	void emplace_front(Args && ... args)
+	{ emplace(begin(), std::forward<Args>(args)...); }
+
+	void pop_front()
+	{ erase(begin()); }
+
+	/**
+	 * The new element is constructed before anything is moved, so if
+	 * its constructor (or a node allocation) throws the list stays as
+	 * it was.
+	 **/
+	template <typename ... Args>
+	iterator emplace(const_iterator pos, Args && ... args)
+	{
+		T value(std::forward<Args>(args)...);
+		ListHead *at = const_cast<ListHead *>(pos.node);
+		size_t index = pos.index;
+
+		/* the end of the previous node is the same position and
+		 * appending there moves nothing */
+		if (!index && at->prev != &impl.head
+				&& static_cast<Node *>(at->prev)->count
+					< Capacity) {
+			at = at->prev;
+			index = static_cast<Node *>(at)->count;
+		}
+
+		if (at == &impl.head) {
+			Node *node = create_node();
+
+			insert_before(node, &impl.head);
+			return place(node, 0, std::move(value));
+		}
+
+		Node *node = static_cast<Node *>(at);
+		if (node->count == Capacity) {
+			Node *next = create_node();
+			size_t const half = Capacity / 2;
+
+			move_range(node->data() + half,
+				node->data() + Capacity, next->data());
+			next->count = Capacity - half;
+			node->count = half;
+			insert_before(next, node->next);
+
+			if (index > half) {
+				node = next;
+				index -= half;
+			}
+		}
+		return place(node, index, std::move(value));
+	}
+
+	iterator insert(const_iterator pos, T const &x)
+	{ return emplace(pos, x); }
+
+	iterator insert(const_iterator pos, T &&x)
+	{ return emplace(pos, std::forward<T>(x)); }
+
+	/**
+	 * Inserts in order, so inserting at the end appends to the last
+	 * node. Returns iterator to the first inserted element.
+	 **/
+	template <typename It>
+	iterator insert(const_iterator pos, It first, It last)
+	{
+		iterator it = make_iterator(pos);
+		ptrdiff_t count = 0;
+
+		for (; first != last; ++first, ++count)
+			it = std::next(emplace(it, *first));
+		return std::prev(it, count);
+	}
+
+	iterator erase(const_iterator pos)
+	{
+		Node *node = static_cast<Node *>(const_cast<ListHead *>(
+					pos.node));
+
+		erase_in_node(node, pos.index, pos.index + 1);
+		return rebalance(node, pos.index);
+	}
+
+	/**
+	 * Elements are erased a node at a time, nodes in the middle of the
+	 * range are freed as a whole. Both ends are rebalanced, the last
+	 * node first, so the first one can take elements from it.
+	 **/
+	iterator erase(const_iterator first, const_iterator last)
+	{
+		if (first == last)
+			return make_iterator(first);
+
+		Node *node = static_cast<Node *>(const_cast<ListHead *>(
+					first.node));
+		ListHead *const stop = const_cast<ListHead *>(last.node);
+
+		if (first.node == last.node) {
+			erase_in_node(node, first.index, last.index);
+			return rebalance(node, first.index);
+		}
+
+		erase_in_node(node, first.index, node->count);
+		for (ListHead *pos = node->next; pos != stop; ) {
+			Node *middle = static_cast<Node *>(pos);
+
+			pos = pos->next;
+			erase_in_node(middle, 0, middle->count);
+			remove_from_list(middle);
+			free_node(middle);
+		}
+		if (stop != &impl.head) {
+			Node *tail = static_cast<Node *>(stop);
+
+			erase_in_node(tail, 0, last.index);
+			rebalance(tail, 0);
+		}
+		return rebalance(node, first.index);
+	}
+
+	/**
+	 * Reverses the order of nodes and then elements of every node.
+	 **/
+	void reverse()
+	{
+		reverse_list(&impl.head);
+		for (ListHead *pos = impl.head.next; pos != &impl.head;
+					pos = pos->next) {
+			Node *node = static_cast<Node *>(pos);
+
+			std::reverse(node->data(), node->data() + node->count);
+		}
+	}
+
+private:
+	NodeAlloc &node_allocator()
+	{ return *static_cast<NodeAlloc *>(&impl); }
+
+	NodeAlloc const &node_allocator() const
+	{ return *static_cast<NodeAlloc const *>(&impl); }
+
+	iterator make_iterator(const_iterator it)
+	{ return iterator(const_cast<ListHead *>(it.node), it.index); }
+
+	Node *create_node()
+	{
+		Node *node = NodeAllocTrait::allocate(impl, 1);
+
+		::new (static_cast<void *>(node)) Node();
+		return node;
+	}
+
+	void free_node(Node *node)
+	{
+		node->~Node();
+		NodeAllocTrait::deallocate(impl, node, 1);
+	}
+
+	void destroy_range(T *first, T *last)
+	{
+		for (; first != last; ++first)
+			NodeAllocTrait::destroy(impl, first);
+	}
+
+	/* to is raw storage */
+	void move_range(T *first, T *last, T *to)
+	{
+		for (; first != last; ++first, ++to) {
+			NodeAllocTrait::construct(impl, to, std::move(*first));
+			NodeAllocTrait::destroy(impl, first);
+		}
+	}
+
+	iterator place(Node *node, size_t index, T &&value)
+	{
+		T *const data = node->data();
+		size_t const count = node->count;
+
+		if (index == count) {
+			NodeAllocTrait::construct(impl, data + count,
+						std::move(value));
+		} else {
+			NodeAllocTrait::construct(impl, data + count,
+						std::move(data[count - 1]));
+			std::move_backward(data + index, data + count - 1,
+						data + count);
+			data[index] = std::move(value);
+		}
+		++node->count;
+		++impl.size;
+		return iterator(node, index);
+	}
+
+	void erase_in_node(Node *node, size_t first, size_t last)
+	{
+		T *const data = node->data();
+		size_t const count = last - first;
+
+		/* moving elements onto themselves may empty them */
+		if (!count)
+			return;
+		std::move(data + last, data + node->count, data + first);
+		destroy_range(data + node->count - count, data + node->count);
+		node->count -= count;
+		impl.size -= count;
+	}
+
+	/**
+	 * Fixes node after elements were erased from it at index and
+	 * returns the position after the erased elements. An empty node is
+	 * freed, a node less than half full takes elements of the next one:
+	 * all if they fit, otherwise as many as to even them out. Taken
+	 * elements go to the end, so the position stays at index.
+	 **/
+	iterator rebalance(Node *node, size_t index)
+	{
+		ListHead *const next = node->next;
+
+		if (!node->count) {
+			remove_from_list(node);
+			free_node(node);
+			return iterator(next);
+		}
+
+		if (next != &impl.head && node->count < Capacity / 2) {
+			Node *other = static_cast<Node *>(next);
+			size_t const total = node->count + other->count;
+			size_t const take = total <= Capacity
+				? other->count : other->count - total / 2;
+			T *const data = other->data();
+
+			move_range(data, data + take,
+					node->data() + node->count);
+			node->count += take;
+			other->count -= take;
+			if (other->count) {
+				move_range(data + take,
+					data + take + other->count, data);
+			} else {
+				remove_from_list(other);
+				free_node(other);
+			}
+		}
+
+		if (index < node->count)
+			return iterator(node, index);
+		return iterator(node->next);
+	}
+
+	Impl impl;
+};
+
+#endif /*__UNROLLED_LIST_HPP__*/
@@ -0,0 +1,273 @@
+#include "bst.hpp"
+#include "bst_multiset.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+template <typename T>
+struct Id {
+	T operator()(T x) const
+	{ return x; }
+};
+
+using Tree = BinarySearchTree<int, int, Id<int>, std::less<int>>;
+using RBTree = BinarySearchTree<int, int, Id<int>, std::less<int>,
+				std::allocator<int>, RedBlackBalance>;
+using CountedRBTree = BinarySearchTree<int, int, Id<int>, std::less<int>,
+				std::allocator<int>,
+				CountedBalance<RedBlackBalance>>;
+using Multiset = BSTMultiset<int, std::less<int>, std::allocator<KeyRun<int>>,
+				RedBlackBalance>;
+
+template <typename F>
+double measure(F f)
+{
+	auto const start = std::chrono::steady_clock::now();
+	f();
+	auto const stop = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double>(stop - start).count();
+}
+
+/**
+ * Inserts keys one by one and then looks every one of them up.
+ **/
+template <typename Tree>
+double run_inserts(std::vector<int> const &keys)
+{
+	Tree tree;
+	size_t found = 0;
+
+	double const time = measure([&] {
+		for (int key : keys)
+			tree.insert(key);
+		for (int key : keys)
+			found += tree.find(key) != tree.end();
+	});
+
+	return found == keys.size() ? time : -1.0;
+}
+
+/**
+ * size() is called once per tick by metrics code, compare it to the walk
+ * it used to be.
+ **/
+double run_size_calls(std::vector<int> const &keys, size_t calls, bool walk)
+{
+	RBTree tree(keys.begin(), keys.end());
+	size_t total = 0;
+
+	double const time = measure([&] {
+		for (size_t i = 0; i != calls; ++i)
+			total += walk ? std::distance(tree.begin(), tree.end())
+				: tree.size();
+	});
+
+	return total == calls * keys.size() ? time : -1.0;
+}
+
+/**
+ * Histogram-like input: every key is repeated dups times, count() of every
+ * key is measured.
+ **/
+template <typename Tree>
+double run_counts(std::vector<int> const &keys, size_t dups)
+{
+	Tree tree;
+	size_t total = 0;
+
+	for (int key : keys)
+		tree.insert(key);
+
+	double const time = measure([&] {
+		for (size_t key = 0; key != keys.size() / dups; ++key)
+			total += tree.count(static_cast<int>(key));
+	});
+
+	return total == keys.size() ? time : -1.0;
+}
+
+/**
+ * Builds a tree and tears it down either with clear() or one erase per
+ * element, the way clear() used to work.
+ **/
+template <typename Tree>
+std::pair<double, double> run_teardown(std::vector<int> const &keys,
+			bool by_erase)
+{
+	Tree tree;
+
+	double const build = measure([&] {
+		for (int key : keys)
+			tree.insert(key);
+	});
+	double const teardown = measure([&] {
+		if (!by_erase) {
+			tree.clear();
+			return;
+		}
+
+		while (!tree.empty())
+			tree.erase(tree.begin());
+	});
+
+	return std::make_pair(build, teardown);
+}
+
+/**
+ * Two replicas that share most of the keys: each has every key with
+ * probability 0.9. They are combined with insert (with find first for
+ * union) or with merge and set_union.
+ **/
+double run_reconcile(std::vector<int> const &keys, int mode)
+{
+	std::mt19937 gen;
+	RBTree left;
+	RBTree right;
+
+	for (int key : keys) {
+		if (gen() % 10)
+			left.insert(key);
+		if (gen() % 10)
+			right.insert(key);
+	}
+
+	return measure([&] {
+		switch (mode) {
+		case 0:
+			left.insert(right.begin(), right.end());
+			break;
+		case 1:
+			left.merge(right);
+			break;
+		case 2:
+			for (int key : right)
+				if (left.find(key) == left.end())
+					left.insert(key);
+			right.clear();
+			break;
+		default:
+			left.set_union(right);
+		}
+	});
+}
+
+/**
+ * Bulk build of a red-black tree and a sum over all of its elements, with
+ * one thread and in parallel.
+ **/
+void run_bulk(std::vector<int> const &keys)
+{
+	size_t const cores = Parallel().threads;
+	long long sum = 0;
+
+	std::cout << "red-black bulk build of " << keys.size()
+		<< " random keys, seconds" << std::endl;
+	std::cout << "insert one by one: " << measure([&] {
+		RBTree tree(keys.begin(), keys.end());
+	}) << std::endl;
+
+	for (size_t threads = 1; threads <= cores; threads *= 2) {
+		std::cout << "Parallel(" << threads << "): " << measure([&] {
+			RBTree tree(Parallel(threads), keys.begin(),
+						keys.end());
+		}) << std::endl;
+	}
+
+	RBTree tree(Parallel(), keys.begin(), keys.end());
+
+	std::cout << "sum of " << keys.size() << " elements, seconds"
+		<< std::endl;
+	std::cout << "iterators: " << measure([&] {
+		for (int key : tree)
+			sum += key;
+	}) << std::endl;
+
+	for (size_t threads = 1; threads <= cores; threads *= 2) {
+		std::atomic<long long> total(0);
+
+		std::cout << "parallel_for_each(" << threads << "): "
+			<< measure([&] {
+				tree.parallel_for_each([&total](int key) {
+					total += key;
+				}, Parallel(threads));
+			}) << std::endl;
+		if (total != sum)
+			std::cout << "wrong sum" << std::endl;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	size_t const size = argc > 1 ? atol(argv[1]) : 1000000;
+	/* sorted input is quadratic for the unbalanced tree */
+	size_t const unbalanced_size = std::min(size, static_cast<size_t>(
+				argc > 2 ? atol(argv[2]) : 5000));
+
+	std::vector<int> sorted(size);
+	for (size_t i = 0; i != size; ++i)
+		sorted[i] = static_cast<int>(i);
+
+	std::vector<int> random(sorted);
+	std::shuffle(random.begin(), random.end(), std::mt19937());
+
+	std::vector<int> const sorted_prefix(sorted.begin(),
+				sorted.begin() + unbalanced_size);
+
+	std::cout << "insert and find, seconds" << std::endl;
+	std::cout << "unbalanced, " << size << " random: "
+		<< run_inserts<Tree>(random) << std::endl;
+	std::cout << "unbalanced, " << unbalanced_size << " sorted: "
+		<< run_inserts<Tree>(sorted_prefix) << std::endl;
+	std::cout << "red-black, " << size << " random: "
+		<< run_inserts<RBTree>(random) << std::endl;
+	std::cout << "red-black, " << size << " sorted: "
+		<< run_inserts<RBTree>(sorted) << std::endl;
+
+	size_t const dups = 1000;
+	std::vector<int> histogram(random);
+	for (int &key : histogram)
+		key /= static_cast<int>(dups);
+
+	std::cout << "count() of " << size / dups << " keys with " << dups
+		<< " duplicates each, seconds" << std::endl;
+	std::cout << "red-black: " << run_counts<RBTree>(histogram, dups)
+		<< std::endl;
+	std::cout << "red-black, order statistics: "
+		<< run_counts<CountedRBTree>(histogram, dups) << std::endl;
+	std::cout << "multiset of runs: "
+		<< run_counts<Multiset>(histogram, dups) << std::endl;
+
+	auto const erased = run_teardown<RBTree>(random, true);
+	auto const cleared = run_teardown<RBTree>(random, false);
+
+	std::cout << "red-black, " << size << " random, seconds" << std::endl;
+	std::cout << "build: " << cleared.first << std::endl;
+	std::cout << "erase one by one: " << erased.second << std::endl;
+	std::cout << "clear: " << cleared.second << std::endl;
+
+	std::cout << "two red-black replicas of " << size
+		<< " random keys, seconds" << std::endl;
+	std::cout << "insert(first, last): " << run_reconcile(random, 0)
+		<< std::endl;
+	std::cout << "merge: " << run_reconcile(random, 1) << std::endl;
+	std::cout << "find and insert missing: " << run_reconcile(random, 2)
+		<< std::endl;
+	std::cout << "set_union: " << run_reconcile(random, 3) << std::endl;
+
+	run_bulk(random);
+
+	std::cout << "10 size() calls on " << size << " elements, seconds"
+		<< std::endl;
+	std::cout << "in-order walk: " << run_size_calls(random, 10, true)
+		<< std::endl;
+	std::cout << "counter: " << run_size_calls(random, 10, false)
+		<< std::endl;
+
+	return 0;
+}
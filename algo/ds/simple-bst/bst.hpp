@@ -2,34 +2,130 @@
 #define __BST_HPP__
 
 #include "bstnode.hpp"
+#include "parallel.hpp"
+#include "rbtreenode.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <memory>
 #include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * Balancing policies for BinarySearchTree: NoBalance is a plain unbalanced
+ * tree, so sorted input makes a list of it, RedBlackBalance keeps height of
+ * the tree within 2 log(n + 1) whatever the insertion order is.
+ **/
+struct NoBalance {
+	using NodeBase = TreeNode;
+};
+
+struct RedBlackBalance {
+	using NodeBase = RBTreeNode;
+};
+
+/**
+ * Tag for constructors that take input already sorted by key.
+ **/
+struct SortedInput { };
+SortedInput const sorted_input = SortedInput();
+
+/**
+ * Node that also keeps total weight of its subtree (number of nodes for
+ * UnitWeight).
+ **/
+template <typename Base>
+struct CountedTreeNode : public Base {
+	size_t count;
+};
+
+struct UnitWeight {
+	template <typename T>
+	size_t operator()(T const &) const
+	{ return 1; }
+};
+
+/**
+ * CountedBalance<Balance> balances the tree the same way as Balance, but
+ * nodes also keep total weight of their subtrees, so count, rank and nth
+ * take O(height) instead of walking over elements. Weight tells how many
+ * elements a value stands for, e. g. a run of equal keys stored in one
+ * node (see BSTMultiset). The price is one more word per node and updates
+ * along the path on every insert and erase.
+ **/
+template <typename Balance = NoBalance, typename Weight = UnitWeight>
+struct CountedBalance : public Balance {
+	using NodeBase = CountedTreeNode<typename Balance::NodeBase>;
+};
+
+template <typename Balance>
+struct BalanceTraits {
+	static bool const counted = false;
+};
+
+template <typename Balance, typename Weight>
+struct BalanceTraits<CountedBalance<Balance, Weight>> {
+	using WeightOf = Weight;
+	static bool const counted = true;
+};
+
+/**
+ * Node allocators that can preallocate nodes (e. g. SlabAllocator) provide
+ * reserve(n), for the rest reserve_nodes does nothing.
+ **/
+template <typename Alloc>
+auto reserve_nodes(Alloc &a, size_t n, int) -> decltype(a.reserve(n), void())
+{ a.reserve(n); }
+
+template <typename Alloc>
+void reserve_nodes(Alloc &, size_t, long)
+{ }
 
 template <typename KeyCmp, typename Allocator>
 struct BSTImpl : public Allocator {
+	/**
+	 * head.left is the root and head.right is the leftmost node,
+	 * rightmost is cached here since head.parent must point to head.
+	 * In an empty tree all of them point to head.
+	 **/
 	TreeNode head;
+	TreeNode *rightmost;
 	KeyCmp cmp;
+	size_t size;
 
 	BSTImpl()
 	: Allocator()
 	, head()
+	, rightmost(&head)
 	, cmp()
+	, size(0)
 	{ wrap_node(&head); }
 
 	BSTImpl(KeyCmp const &cmp, Allocator const &a)
-	: Allocator(a), head(), cmp(cmp)
+	: Allocator(a), head(), rightmost(&head), cmp(cmp), size(0)
 	{ wrap_node(&head); }
 
 	BSTImpl(KeyCmp const &cmp, Allocator &&a)
-	: Allocator(std::move(a)), head(), cmp(cmp)
+	: Allocator(std::move(a)), head(), rightmost(&head), cmp(cmp), size(0)
 	{ wrap_node(&head); }
+
+	void reset()
+	{
+		wrap_node(&head);
+		rightmost = &head;
+		size = 0;
+	}
 };
 
-template <typename Val, typename Cmp, typename Allocator>
+template <typename Val, typename Cmp, typename Allocator,
+	typename Balance = NoBalance>
 struct BinarySearchTreeBase {
-	using Node = BSTNode<Val>;
+	using Node = BSTNode<Val, typename Balance::NodeBase>;
+	using Traits = BalanceTraits<Balance>;
+	using Counted = std::integral_constant<bool, Traits::counted>;
 	using ValueAlloc = Allocator;
 	using ValueAllocTrait = std::allocator_traits<ValueAlloc>;
 	using NodeAlloc = typename
@@ -123,6 +219,217 @@ struct BinarySearchTreeBase {
 			add_right(prev, node->parent);
 	}
 
+	static size_t subtree_count(TreeNode const *parent,
+				TreeNode const *child)
+	{
+		return child != parent
+			? static_cast<Node const *>(child)->count : 0;
+	}
+
+	static void update_count(TreeNode *node)
+	{
+		Node *n = static_cast<Node *>(node);
+		typename Traits::WeightOf weight;
+
+		n->count = weight(n->data) + subtree_count(node, node->left)
+					+ subtree_count(node, node->right);
+	}
+
+	static tree_update_t updater(std::false_type)
+	{ return 0; }
+
+	static tree_update_t updater(std::true_type)
+	{ return &update_count; }
+
+	/**
+	 * Lowest node whose subtree changes when detach_node removes node.
+	 **/
+	static TreeNode *detach_start(TreeNode *node)
+	{
+		if (node->left == node || node->right == node)
+			return node->parent;
+
+		TreeNode *prev = const_cast<TreeNode *>(right_most(node->left));
+		return prev->parent == node ? prev : prev->parent;
+	}
+
+	void detach(TreeNode *node, NoBalance)
+	{
+		if (!Traits::counted) {
+			detach_node(node);
+			return;
+		}
+
+		TreeNode *start = detach_start(node);
+
+		detach_node(node);
+		update_path(start, &impl.head, updater(Counted()));
+	}
+
+	void detach(TreeNode *node, RedBlackBalance)
+	{ rb_erase(node, &impl.head, updater(Counted())); }
+
+	void rebalance_after_insert(TreeNode *node, NoBalance)
+	{ update_path(node, &impl.head, updater(Counted())); }
+
+	void rebalance_after_insert(TreeNode *node, RedBlackBalance)
+	{
+		update_path(node, &impl.head, updater(Counted()));
+		rb_insert_fixup(node, &impl.head, updater(Counted()));
+	}
+
+	void rebalance_after_build(NoBalance)
+	{ }
+
+	void rebalance_after_build(RedBlackBalance)
+	{ rb_color_balanced(&impl.head, impl.size); }
+
+	/**
+	 * Replaces the (empty) tree with a balanced one built of size nodes
+	 * of the list linked through right.
+	 **/
+	void build_from_list(TreeNode *list, size_t size)
+	{
+		impl.rightmost = tree_from_list(&impl.head, list, size,
+					updater(Counted()));
+		impl.size = size;
+		rebalance_after_build(Balance());
+	}
+
+	static void color_node(TreeNode *, bool, NoBalance)
+	{ }
+
+	static void color_node(TreeNode *node, bool red, RedBlackBalance)
+	{ static_cast<RBTreeNode *>(node)->red = red; }
+
+	/**
+	 * Links a tree of the minimal height from size nodes sorted in the
+	 * array, the same shape as tree_from_list builds. Top spawn levels
+	 * of recursion build the left subtree in a new thread. Nodes deeper
+	 * than red_depth are red (see rb_color_balanced).
+	 **/
+	static TreeNode *link_sorted(Node **nodes, size_t size, size_t depth,
+				size_t red_depth, size_t spawn)
+	{
+		if (!size)
+			return 0;
+
+		size_t const mid = (size - 1) / 2;
+		TreeNode *const root = nodes[mid];
+		TreeNode *left;
+		TreeNode *right;
+
+		if (spawn && size > 4096) {
+			run_parallel(2, [&](size_t i) {
+				if (i)
+					left = link_sorted(nodes, mid,
+						depth + 1, red_depth,
+						spawn - 1);
+				else
+					right = link_sorted(nodes + mid + 1,
+						size - mid - 1, depth + 1,
+						red_depth, spawn - 1);
+			});
+		} else {
+			left = link_sorted(nodes, mid, depth + 1, red_depth, 0);
+			right = link_sorted(nodes + mid + 1, size - mid - 1,
+						depth + 1, red_depth, 0);
+		}
+
+		root->left = root;
+		root->right = root;
+		if (left)
+			add_left(left, root);
+		if (right)
+			add_right(right, root);
+
+		color_node(root, depth >= red_depth, Balance());
+		if (tree_update_t update = updater(Counted()))
+			update(root);
+		return root;
+	}
+
+	/**
+	 * Replaces the (empty) tree with a balanced tree of size sorted
+	 * values starting at values. Nodes are allocated (and freed on
+	 * failure) in the calling thread, values are copied (or moved with
+	 * move iterators) into them and the tree is linked in parallel.
+	 **/
+	template <typename It>
+	void build_from_sorted(It values, size_t size, size_t threads)
+	{
+		size_t const tasks = std::min(threads, size / 4096 + 1);
+		std::vector<Node *> nodes;
+		std::vector<char> constructed(tasks);
+
+		nodes.reserve(size);
+		try {
+			for (size_t i = 0; i != size; ++i)
+				nodes.push_back(get_node());
+
+			run_parallel(tasks, [&](size_t t) {
+				size_t const first = size * t / tasks;
+				size_t const last = size * (t + 1) / tasks;
+				size_t i = first;
+				It value = std::next(values, first);
+
+				try {
+					for (; i != last; ++i, ++value) {
+						NodeAllocTrait::construct(impl,
+							nodes[i], *value);
+						wrap_node(nodes[i]);
+					}
+				} catch (...) {
+					while (i-- != first)
+						NodeAllocTrait::destroy(impl,
+								nodes[i]);
+					throw;
+				}
+				constructed[t] = 1;
+			});
+		} catch (...) {
+			for (size_t t = 0; t != tasks; ++t) {
+				if (!constructed[t])
+					continue;
+				size_t const first = size * t / tasks;
+				size_t const last = size * (t + 1) / tasks;
+
+				for (size_t i = first; i != last; ++i)
+					NodeAllocTrait::destroy(impl, nodes[i]);
+			}
+			for (Node *node : nodes)
+				put_node(node);
+			throw;
+		}
+
+		if (!size)
+			return;
+
+		size_t levels = 0;
+		size_t spawn = 0;
+
+		while ((size + 1) >> (levels + 1))
+			++levels;
+		while ((static_cast<size_t>(1) << spawn) < threads)
+			++spawn;
+
+		add_left(link_sorted(nodes.data(), size, 0, levels, spawn),
+					&impl.head);
+		impl.head.right = nodes.front();
+		impl.rightmost = nodes.back();
+		impl.size = size;
+	}
+
+	void destroy_list(TreeNode *list)
+	{
+		while (list) {
+			TreeNode *next = list->right;
+
+			destroy_node(static_cast<Node *>(list));
+			list = next;
+		}
+	}
+
 	void detach_node(TreeNode *node)
 	{
 		bool const has_left = node->left != node;
@@ -157,43 +464,80 @@ struct BinarySearchTreeBase {
 	BinarySearchTreeBase(BinarySearchTreeBase &&other)
 	: impl(std::move(other.key_comparator()),
 		std::move(other.node_allocator()))
-	{ std::swap(impl.head, other.impl.head); }
+	{ swap_trees(other); }
+
+	/**
+	 * Exchanges nodes, but not allocators and comparators.
+	 **/
+	void swap_trees(BinarySearchTreeBase &other)
+	{
+		swap_heads(&impl.head, &other.impl.head);
+		std::swap(impl.rightmost, other.impl.rightmost);
+		std::swap(impl.size, other.impl.size);
+
+		if (impl.rightmost == &other.impl.head)
+			impl.rightmost = &impl.head;
+		if (other.impl.rightmost == &impl.head)
+			other.impl.rightmost = &other.impl.head;
+	}
+
+	/**
+	 * Destroys all nodes without detach and rebalancing, see
+	 * tree_unlink_next.
+	 **/
+	void destroy_tree()
+	{
+		TreeNode *cursor = impl.head.left;
+
+		while (TreeNode *node = tree_unlink_next(&cursor, &impl.head))
+			destroy_node(static_cast<Node *>(node));
+
+		impl.reset();
+	}
 };
 
 template <typename Key, typename Val, typename KeyOf, typename KeyCmp,
-	typename Allocator = std::allocator<Val>>
-class BinarySearchTree : private BinarySearchTreeBase<Val, KeyCmp, Allocator> {
-	using Base = BinarySearchTreeBase<Val, KeyCmp, Allocator>;
+	typename Allocator = std::allocator<Val>, typename Balance = NoBalance>
+class BinarySearchTree
+	: private BinarySearchTreeBase<Val, KeyCmp, Allocator, Balance> {
+	using Base = BinarySearchTreeBase<Val, KeyCmp, Allocator, Balance>;
 	using ValueAlloc = typename Base::ValueAlloc;
 	using NodeAlloc = typename Base::NodeAlloc;
 	using Node = typename Base::Node;
-	using Self = BinarySearchTree<Key, Val, KeyOf, KeyCmp, Allocator>;
+	using Traits = typename Base::Traits;
+	using Counted = typename Base::Counted;
+	using Self = BinarySearchTree<Key, Val, KeyOf, KeyCmp, Allocator,
+				Balance>;
 
 	using Base::impl;
 	using Base::node_allocator;
 	using Base::create_node;
 	using Base::destroy_node;
 	using Base::key_comparator;
-	using Base::detach_node;
+	using Base::detach;
+	using Base::rebalance_after_insert;
+	using Base::subtree_count;
+	using Base::updater;
+	using Base::swap_trees;
+	using Base::destroy_tree;
+	using Base::build_from_list;
+	using Base::destroy_list;
+	using Base::build_from_sorted;
 
 public:
-	using iterator = TreeIterator<Val>;
-	using const_iterator = TreeConstIterator<Val>;
+	using iterator = TreeIterator<Val, Node>;
+	using const_iterator = TreeConstIterator<Val, Node>;
 	using value_type = typename iterator::value_type;
 	using reference = typename iterator::reference;
 	using const_reference = typename const_iterator::reference;
 
-	BinarySearchTree()
-	: Base()
-	{ }
-
 	explicit BinarySearchTree(KeyCmp const &cmp = KeyCmp(),
 					Allocator const &a = Allocator())
 	: Base(cmp, NodeAlloc(a))
 	{ }
 
 	explicit BinarySearchTree(Allocator const &a)
-	: Base(NodeAlloc(a))
+	: Base(KeyCmp(), NodeAlloc(a))
 	{ }
 
 	template <typename It>
@@ -202,6 +546,44 @@ public:
 	: Base(cmp, NodeAlloc(a))
 	{ insert(first, last); }
 
+	/**
+	 * Bulk build for big inputs: values are sorted with parallel_sort
+	 * and linked into a balanced tree (for any Balance) in parallel, see
+	 * build_from_sorted. Equal keys keep no particular order.
+	 **/
+	template <typename It>
+	BinarySearchTree(Parallel parallel, It first, It last,
+				KeyCmp const &cmp = KeyCmp(),
+				Allocator const &a = Allocator())
+	: Base(cmp, NodeAlloc(a))
+	{
+		std::vector<Val> values(first, last);
+		KeyCmp const &keycmp = key_comparator();
+		KeyOf keyof;
+
+		parallel_sort(values.begin(), values.end(),
+			[&keycmp, &keyof](Val const &l, Val const &r)
+			{ return keycmp(keyof(l), keyof(r)); },
+			parallel.threads);
+		build_from_sorted(std::make_move_iterator(values.begin()),
+					values.size(), parallel.threads);
+	}
+
+	/**
+	 * [first, last) must be sorted by key, the tree is built in linear
+	 * time without any checks (see build_from_sorted), e. g. to load a
+	 * tree saved in sorted order.
+	 **/
+	template <typename It>
+	BinarySearchTree(SortedInput, It first, It last,
+				KeyCmp const &cmp = KeyCmp(),
+				Allocator const &a = Allocator())
+	: Base(cmp, NodeAlloc(a))
+	{
+		build_from_sorted(first,
+			static_cast<size_t>(std::distance(first, last)), 1);
+	}
+
 	BinarySearchTree(Self &&other)
 	: Base(std::move(other))
 	{ }
@@ -209,12 +591,6 @@ public:
 	~BinarySearchTree()
 	{ clear(); }
 
-	BinarySearchTree &operator=(Self other)
-	{
-		swap(other);
-		return *this;
-	}
-
 	BinarySearchTree &operator=(Self &&other)
 	{
 		clear();
@@ -225,19 +601,30 @@ public:
 	void swap(Self &other)
 	{
 		using std::swap;
-		swap(impl.head, other.impl.head);
+		swap_trees(other);
 		swap(node_allocator(), other.node_allocator());
 		swap(key_comparator(), other.key_comparator());
 	}
 
 	void clear()
-	{ erase(begin(), end()); }
+	{ destroy_tree(); }
 
 	bool empty() const
-	{ return begin() == end(); }
+	{ return impl.size == 0; }
 
 	size_t size() const
-	{ return static_cast<size_t>(std::distance(begin(), end())); }
+	{ return impl.size; }
+
+	/**
+	 * Lets the node allocator prepare memory for the tree to grow up to
+	 * n elements, so inserts don't go to the system allocator one node
+	 * at a time.
+	 **/
+	void reserve(size_t n)
+	{
+		if (n > impl.size)
+			reserve_nodes(node_allocator(), n - impl.size, 0);
+	}
 
 	iterator begin()
 	{ return iterator(impl.head.right); }
@@ -267,17 +654,12 @@ public:
 	template <typename ... Args>
 	iterator emplace(Args && ... args)
 	{
-		BSTNode<Val> *new_node =
+		Node *new_node =
 				create_node(std::forward<Args>(args)...);
-		TreeNode *node = lower_bound(KeyOf()(new_node->data)).node;
 
-		if (node->left != node) {
-			node = const_cast<TreeNode *>(right_most(node->left));
-			add_right(new_node, node);
-		} else {
-			add_left(new_node, node);
-			impl.head.right = impl.head.right->left;
-		}
+		link_node(new_node);
+		rebalance_after_insert(new_node, Balance());
+		++impl.size;
 		return iterator(new_node);
 	}
 
@@ -291,8 +673,7 @@ public:
 		KeyOf keyof;
 
 		while (child != parent) {
-			BSTNode<Val> const *node =
-				static_cast<BSTNode<Val> const *>(child);
+			Node const *node = static_cast<Node const *>(child);
 
 			parent = child;
 			if (!keycmp(keyof(node->data), key)) {
@@ -316,13 +697,12 @@ public:
 		KeyOf keyof;
 
 		while (child != parent) {
-			BSTNode<Val> const *node =
-				static_cast<BSTNode<Val> const *>(child);
+			Node const *node = static_cast<Node const *>(child);
 
 			parent = child;
 			if (keycmp(key, keyof(node->data))) {
 				child = node->left;
-				x = child;
+				x = node;
 			} else {
 				child = node->right;
 			}
@@ -370,29 +750,420 @@ public:
 		return iterator(const_cast<TreeNode *>(it.node));
 	}
 
+	std::pair<const_iterator, const_iterator>
+	equal_range(Key const &key) const
+	{ return std::make_pair(lower_bound(key), upper_bound(key)); }
+
+	std::pair<iterator, iterator> equal_range(Key const &key)
+	{ return std::make_pair(lower_bound(key), upper_bound(key)); }
+
+	/**
+	 * With CountedBalance it's O(height) and returns total weight of
+	 * the elements equal to key, otherwise it walks over them.
+	 **/
 	size_t count(Key const &key) const
-	{ return std::distance(lower_bound(key), upper_bound(key)); }
-	
+	{ return count(key, Counted()); }
+
+	/**
+	 * Returns total weight of elements with keys less than key, i. e.
+	 * position of lower_bound(key). Available only with CountedBalance.
+	 **/
+	size_t rank(Key const &key) const
+	{
+		static_assert(Traits::counted, "rank needs CountedBalance");
+		return weight_before<false>(key);
+	}
+
+	/**
+	 * Returns iterator to the k-th (starting from 0) element in order
+	 * or end() if there are not that many. With non unit weights that's
+	 * the element whose weight covers position k. Available only with
+	 * CountedBalance.
+	 **/
+	const_iterator nth(size_t k) const
+	{
+		static_assert(Traits::counted, "nth needs CountedBalance");
+
+		TreeNode const *parent = &impl.head;
+		TreeNode const *child = impl.head.left;
+		typename Traits::WeightOf weight;
+
+		while (child != parent) {
+			Node const *node = static_cast<Node const *>(child);
+			size_t const left = subtree_count(node, node->left);
+			size_t const self = weight(node->data);
+
+			parent = child;
+			if (k < left) {
+				child = node->left;
+			} else if (k - left < self) {
+				return const_iterator(node);
+			} else {
+				k -= left + self;
+				child = node->right;
+			}
+		}
+
+		return end();
+	}
+
+	iterator nth(size_t k)
+	{
+		Self const *self = const_cast<Self const *>(this);
+		const_iterator it = self->nth(k);
+
+		return iterator(const_cast<TreeNode *>(it.node));
+	}
+
+	/**
+	 * Must be called after the weight of *it has been changed in place,
+	 * the key must stay the same. Available only with CountedBalance.
+	 **/
+	void reweight(const_iterator it)
+	{
+		static_assert(Traits::counted, "reweight needs CountedBalance");
+		update_path(const_cast<TreeNode *>(it.node), &impl.head,
+					updater(Counted()));
+	}
+
 	iterator erase(const_iterator it)
 	{
 		Node *node = const_cast<Node *>(
 					static_cast<Node const *>(it.node));
 		TreeNode *next = const_cast<TreeNode *>(next_node(node));
 
-		detach_node(node);
+		if (impl.rightmost == node) {
+			impl.rightmost = const_cast<TreeNode *>(
+						prev_node(node));
+		}
+		detach(node, Balance());
 		if (impl.head.right == node)
 			impl.head.right = next;
 		destroy_node(node);
+		--impl.size;
 
-		return iterator(next);		
+		return iterator(next);
 	}
 
 	iterator erase(const_iterator first, const_iterator last)
 	{
+		if (first == begin() && last == end()) {
+			clear();
+			return end();
+		}
+
 		while (first != last)
 			first = erase(first);
 		return iterator(const_cast<TreeNode *>(first.node));
 	}
+
+	/**
+	 * Calls f for every element, elements are visited by parallel.threads
+	 * threads in no particular order. Top levels of the tree are cut into
+	 * a few subtrees per thread, threads take single nodes above the cut
+	 * and whole subtrees below it from a shared queue, so unbalanced
+	 * trees are split less evenly. f must not change keys. The first
+	 * exception thrown by f stops the walk and is rethrown.
+	 **/
+	template <typename F>
+	void parallel_for_each(F f, Parallel parallel = Parallel())
+	{ for_each_subtree<Val>(f, parallel.threads); }
+
+	template <typename F>
+	void parallel_for_each(F f, Parallel parallel = Parallel()) const
+	{ for_each_subtree<Val const>(f, parallel.threads); }
+
+	/**
+	 * Set operations take all elements of other (other becomes empty)
+	 * and leave the result in this tree. Both trees are unlinked into
+	 * sorted lists, zipped and the result is rebuilt as a balanced tree
+	 * in O(n + m). Nodes of other are reused if allocators are equal,
+	 * otherwise values are moved to new nodes first. Trees must be
+	 * ordered by the same comparator.
+	 *
+	 * As std::set_union and friends do for multisets, an element of
+	 * this tree and an equal element of other match one to one.
+	 **/
+
+	/**
+	 * Keeps all elements of both trees, elements of this tree go
+	 * before equal elements of other.
+	 **/
+	void merge(Self &other)
+	{ combine<SetOp::Merge>(other); }
+
+	/**
+	 * Keeps elements of this tree and unmatched elements of other.
+	 **/
+	void set_union(Self &other)
+	{ combine<SetOp::Union>(other); }
+
+	/**
+	 * Keeps only matched elements of this tree.
+	 **/
+	void set_intersection(Self &other)
+	{ combine<SetOp::Intersection>(other); }
+
+	/**
+	 * Keeps only unmatched elements of this tree.
+	 **/
+	void set_difference(Self &other)
+	{ combine<SetOp::Difference>(other); }
+
+private:
+	template <typename V, typename F>
+	void for_each_subtree(F &f, size_t threads) const
+	{
+		/* nodes above the cut are visited alone (false) */
+		std::vector<std::pair<TreeNode const *, bool>> tasks;
+		size_t cut = 0;
+
+		while ((static_cast<size_t>(1) << cut) < 4 * threads)
+			++cut;
+		collect_subtrees(impl.head.left, cut, tasks);
+
+		std::atomic<size_t> next(0);
+		std::atomic<bool> failed(false);
+
+		run_parallel(std::min(threads, tasks.size()), [&](size_t) {
+			try {
+				size_t i;
+
+				while (!failed && (i = next++) < tasks.size())
+					visit_subtree<V>(tasks[i].first,
+						tasks[i].second, f);
+			} catch (...) {
+				failed = true;
+				throw;
+			}
+		});
+	}
+
+	void collect_subtrees(TreeNode const *node, size_t depth,
+			std::vector<std::pair<TreeNode const *, bool>> &tasks)
+			const
+	{
+		if (node == &impl.head)
+			return;
+
+		tasks.push_back(std::make_pair(node, depth == 0));
+		if (depth == 0)
+			return;
+
+		if (node->left != node)
+			collect_subtrees(node->left, depth - 1, tasks);
+		if (node->right != node)
+			collect_subtrees(node->right, depth - 1, tasks);
+	}
+
+	template <typename V, typename F>
+	static void visit_subtree(TreeNode const *root, bool whole, F &f)
+	{
+		TreeNode const *node = whole ? left_most(root) : root;
+		TreeNode const *const last = whole ? right_most(root) : root;
+
+		for (;;) {
+			Node const *n = static_cast<Node const *>(node);
+
+			f(const_cast<V &>(n->data));
+			if (node == last)
+				break;
+			node = next_node(node);
+		}
+	}
+
+	enum class SetOp { Merge, Union, Intersection, Difference };
+
+	template <SetOp Op>
+	void combine(Self &other)
+	{
+		if (&other == this) {
+			if (Op == SetOp::Difference)
+				clear();
+			return;
+		}
+
+		TreeNode *const lhead = &impl.head;
+		TreeNode *const rhead = &other.impl.head;
+		TreeNode *lcursor = lhead->left;
+		TreeNode *rcursor = node_allocator() == other.node_allocator()
+					? rhead->left : copy_to_vine(other);
+		TreeNode *left = tree_unlink_next(&lcursor, lhead);
+		TreeNode *right = tree_unlink_next(&rcursor, rhead);
+		TreeNode *list = 0;
+		TreeNode **link = &list;
+		size_t size = 0;
+
+		KeyCmp const &keycmp = key_comparator();
+		KeyOf keyof;
+
+		/* both trees are taken apart and zipped in one pass */
+		while (left || right) {
+			Node *const l = static_cast<Node *>(left);
+			Node *const r = static_cast<Node *>(right);
+			int order;
+
+			if (!r)
+				order = -1;
+			else if (!l)
+				order = 1;
+			else if (keycmp(keyof(l->data), keyof(r->data)))
+				order = -1;
+			else if (keycmp(keyof(r->data), keyof(l->data)))
+				order = 1;
+			else
+				order = Op == SetOp::Merge ? -1 : 0;
+
+			if (order <= 0) {
+				if ((order < 0 && Op != SetOp::Intersection)
+						|| (order == 0
+						&& Op != SetOp::Difference)) {
+					*link = left;
+					link = &left->right;
+					++size;
+				} else {
+					destroy_node(l);
+				}
+				left = tree_unlink_next(&lcursor, lhead);
+			}
+
+			if (order >= 0) {
+				if (order > 0 && (Op == SetOp::Merge
+						|| Op == SetOp::Union)) {
+					*link = right;
+					link = &right->right;
+					++size;
+				} else {
+					destroy_node(r);
+				}
+				right = tree_unlink_next(&rcursor, rhead);
+			}
+		}
+
+		*link = 0;
+		impl.reset();
+		other.impl.reset();
+		build_from_list(list, size);
+	}
+
+	/**
+	 * Copies values of other into new nodes of this tree linked through
+	 * right into a vine, which tree_unlink_next walks as any other tree
+	 * with other's head as the end. Other is cleared, but left as is if
+	 * an allocation or a copy fails: values aren't moved, since a move
+	 * can't be undone once a later node fails.
+	 **/
+	TreeNode *copy_to_vine(Self &other)
+	{
+		TreeNode *const head = &other.impl.head;
+		TreeNode *vine = head;
+		TreeNode **link = &vine;
+
+		try {
+			for (Val const &value : other) {
+				Node *node = create_node(value);
+
+				*link = node;
+				link = &node->right;
+			}
+		} catch (...) {
+			*link = 0;
+			destroy_list(vine != head ? vine : 0);
+			throw;
+		}
+
+		other.clear();
+		return vine;
+	}
+
+	/**
+	 * Links new_node as a leaf before all elements with equal keys.
+	 * Keys greater than all others (e. g. sorted input) are appended to
+	 * the rightmost node right away without a walk from the root.
+	 **/
+	void link_node(Node *new_node)
+	{
+		TreeNode *head = &impl.head;
+		TreeNode *rightmost = impl.rightmost;
+
+		KeyCmp const &keycmp = key_comparator();
+		KeyOf keyof;
+
+		if (rightmost != head && keycmp(
+				keyof(static_cast<Node *>(rightmost)->data),
+				keyof(new_node->data))) {
+			add_right(new_node, rightmost);
+			impl.rightmost = new_node;
+			return;
+		}
+
+		TreeNode *parent = head;
+		TreeNode *child = head->left;
+		bool left = true;
+
+		while (child != parent) {
+			Node *node = static_cast<Node *>(child);
+
+			parent = child;
+			left = !keycmp(keyof(node->data),
+						keyof(new_node->data));
+			child = left ? node->left : node->right;
+		}
+
+		if (parent == head) {
+			add_left(new_node, head);
+			head->right = new_node;
+			impl.rightmost = new_node;
+		} else if (left) {
+			add_left(new_node, parent);
+			if (head->right == parent)
+				head->right = new_node;
+		} else {
+			add_right(new_node, parent);
+			if (impl.rightmost == parent)
+				impl.rightmost = new_node;
+		}
+	}
+
+	size_t count(Key const &key, std::false_type) const
+	{ return std::distance(lower_bound(key), upper_bound(key)); }
+
+	size_t count(Key const &key, std::true_type) const
+	{ return weight_before<true>(key) - weight_before<false>(key); }
+
+	/**
+	 * Total weight of elements with keys less than key (not greater
+	 * than key if Upper).
+	 **/
+	template <bool Upper>
+	size_t weight_before(Key const &key) const
+	{
+		TreeNode const *parent = &impl.head;
+		TreeNode const *child = impl.head.left;
+		size_t rank = 0;
+
+		KeyCmp const &keycmp = key_comparator();
+		KeyOf keyof;
+		typename Traits::WeightOf weight;
+
+		while (child != parent) {
+			Node const *node = static_cast<Node const *>(child);
+			bool const before = Upper
+					? !keycmp(key, keyof(node->data))
+					: keycmp(keyof(node->data), key);
+
+			parent = child;
+			if (before) {
+				rank += subtree_count(node, node->left)
+							+ weight(node->data);
+				child = node->right;
+			} else {
+				child = node->left;
+			}
+		}
+
+		return rank;
+	}
 };
 
 #endif /*__BST_HPP__*/
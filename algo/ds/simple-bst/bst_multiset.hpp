@@ -0,0 +1,175 @@
+#ifndef __BST_MULTISET_HPP__
+#define __BST_MULTISET_HPP__
+
+#include "bst.hpp"
+
+#include <functional>
+#include <memory>
+#include <cstddef>
+
+/**
+ * Run of equal keys stored in one node.
+ **/
+template <typename Key>
+struct KeyRun {
+	Key key;
+	size_t count;
+};
+
+template <typename Key>
+struct KeyRunKey {
+	Key const &operator()(KeyRun<Key> const &run) const
+	{ return run.key; }
+};
+
+template <typename Key>
+struct KeyRunWeight {
+	size_t operator()(KeyRun<Key> const &run) const
+	{ return run.count; }
+};
+
+/**
+ * Multiset for keys with lots of duplicates (e. g. histograms): every run
+ * of equal keys is a single node with a counter, so memory and height of
+ * the tree depend on the number of distinct keys only. Nodes are weighted
+ * by their counters, so count, rank and nth are O(height).
+ *
+ * Iterators walk over runs, not over individual elements: *it is a
+ * KeyRun with the key and the number of its copies.
+ **/
+template <typename Key, typename KeyCmp = std::less<Key>,
+	typename Allocator = std::allocator<KeyRun<Key>>,
+	typename Balance = NoBalance>
+class BSTMultiset {
+	using Run = KeyRun<Key>;
+	using Tree = BinarySearchTree<Key, Run, KeyRunKey<Key>, KeyCmp,
+				Allocator,
+				CountedBalance<Balance, KeyRunWeight<Key>>>;
+
+public:
+	using key_type = Key;
+	using value_type = Run;
+	using const_iterator = typename Tree::const_iterator;
+	using iterator = const_iterator;
+
+	explicit BSTMultiset(KeyCmp const &cmp = KeyCmp(),
+				Allocator const &a = Allocator())
+	: tree(cmp, a), total(0)
+	{ }
+
+	void swap(BSTMultiset &other)
+	{
+		using std::swap;
+		tree.swap(other.tree);
+		swap(total, other.total);
+	}
+
+	void clear()
+	{
+		tree.clear();
+		total = 0;
+	}
+
+	bool empty() const
+	{ return total == 0; }
+
+	/**
+	 * Number of elements counting duplicates.
+	 **/
+	size_t size() const
+	{ return total; }
+
+	/**
+	 * Number of distinct keys.
+	 **/
+	size_t runs() const
+	{ return tree.size(); }
+
+	const_iterator begin() const
+	{ return tree.begin(); }
+
+	const_iterator end() const
+	{ return tree.end(); }
+
+	/**
+	 * Adds n copies of key, returns iterator to its run or end() if
+	 * there is none (n is 0 and there were no copies).
+	 **/
+	const_iterator insert(Key const &key, size_t n = 1)
+	{
+		typename Tree::iterator it = tree.find(key);
+
+		if (n == 0)
+			return it;
+
+		total += n;
+		if (it == tree.end())
+			return tree.insert(Run{key, n});
+
+		it->count += n;
+		tree.reweight(it);
+		return it;
+	}
+
+	/**
+	 * Removes up to n copies of key, returns number of removed copies.
+	 **/
+	size_t erase(Key const &key, size_t n)
+	{
+		typename Tree::iterator it = tree.find(key);
+
+		if (it == tree.end() || n == 0)
+			return 0;
+
+		if (n >= it->count) {
+			n = it->count;
+			tree.erase(it);
+		} else {
+			it->count -= n;
+			tree.reweight(it);
+		}
+
+		total -= n;
+		return n;
+	}
+
+	/**
+	 * Removes all copies of key, returns their number.
+	 **/
+	size_t erase(Key const &key)
+	{ return erase(key, count(key)); }
+
+	size_t count(Key const &key) const
+	{
+		const_iterator it = tree.find(key);
+
+		return it == tree.end() ? 0 : it->count;
+	}
+
+	const_iterator find(Key const &key) const
+	{ return tree.find(key); }
+
+	const_iterator lower_bound(Key const &key) const
+	{ return tree.lower_bound(key); }
+
+	const_iterator upper_bound(Key const &key) const
+	{ return tree.upper_bound(key); }
+
+	/**
+	 * Number of elements less than key.
+	 **/
+	size_t rank(Key const &key) const
+	{ return tree.rank(key); }
+
+	/**
+	 * Run holding the k-th (starting from 0) element or end().
+	 **/
+	const_iterator nth(size_t k) const
+	{ return tree.nth(k); }
+
+private:
+	Tree tree;
+	size_t total;
+};
+
+#endif /*__BST_MULTISET_HPP__*/
@@ -7,25 +7,25 @@
 #include <utility>
 #include <cstddef>
 
-template <typename T>
-struct BSTNode : public TreeNode {
+template <typename T, typename Base = TreeNode>
+struct BSTNode : public Base {
 	T data;
 
 	BSTNode()
-	: TreeNode(), data()
+	: Base(), data()
 	{ }
 
 	template <typename ... Args>
 	BSTNode(Args && ... data)
-	: TreeNode(), data(std::forward<Args>(data)...)
+	: Base(), data(std::forward<Args>(data)...)
 	{ }
 };
 
-template <typename T>
+template <typename T, typename NodeType = BSTNode<T>>
 struct TreeIterator : public std::iterator<
 			std::bidirectional_iterator_tag, T> {
-	using Self = TreeIterator<T>;
-	using Node = BSTNode<T>;
+	using Self = TreeIterator<T, NodeType>;
+	using Node = NodeType;
 	using Trait = std::iterator_traits<Self>;
 	using Ref = typename Trait::reference;
 	using Ptr = typename Trait::pointer;
@@ -79,13 +79,13 @@ struct TreeIterator : public std::iterator<
 	{ return node != other.node; }
 };
 
-template <typename T>
+template <typename T, typename NodeType = BSTNode<T>>
 struct TreeConstIterator : public std::iterator<
 			std::bidirectional_iterator_tag, T,
 			ptrdiff_t, T const *, T const &> {
-	using Self = TreeConstIterator<T>;
-	using Iter = TreeIterator<T>;
-	using Node = BSTNode<T> const;
+	using Self = TreeConstIterator<T, NodeType>;
+	using Iter = TreeIterator<T, NodeType>;
+	using Node = NodeType const;
 	using Trait = std::iterator_traits<Self>;
 	using Ref = typename Trait::reference;
 	using Ptr = typename Trait::pointer;
@@ -143,14 +143,14 @@ struct TreeConstIterator : public std::iterator<
 	{ return node != other.node; }
 };
 
-template <typename T>
-inline bool operator==(TreeIterator<T> const &lhs,
-			TreeConstIterator<T> const &rhs)
+template <typename T, typename Node>
+inline bool operator==(TreeIterator<T, Node> const &lhs,
+			TreeConstIterator<T, Node> const &rhs)
 { return lhs.node == rhs.node; }
 
-template <typename T>
-inline bool operator!=(TreeIterator<T> const &lhs,
-			TreeConstIterator<T> const &rhs)
+template <typename T, typename Node>
+inline bool operator!=(TreeIterator<T, Node> const &lhs,
+			TreeConstIterator<T, Node> const &rhs)
 { return lhs.node != rhs.node; }
 
 #endif /*__BST_NODE_HPP__*/
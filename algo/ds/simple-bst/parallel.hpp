@@ -0,0 +1,104 @@
+#ifndef __PARALLEL_HPP__
+#define __PARALLEL_HPP__
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+/**
+ * Tag for parallel algorithms of BinarySearchTree, threads == 0 means as
+ * many threads as the hardware runs concurrently.
+ **/
+struct Parallel {
+	size_t threads;
+
+	explicit Parallel(size_t threads = 0)
+	: threads(threads ? threads
+		: std::max(std::thread::hardware_concurrency(), 1u))
+	{ }
+};
+
+/**
+ * Calls f(0), ..., f(tasks - 1) each in its own thread (f(0) runs in the
+ * calling thread) and waits for all of them. If some of them throw, the
+ * first exception is rethrown after all threads are joined. Tasks that
+ * can't get a thread run in the calling thread.
+ **/
+template <typename F>
+void run_parallel(size_t tasks, F f)
+{
+	std::vector<std::exception_ptr> errors(tasks);
+	std::vector<std::thread> threads;
+	size_t started = 1;
+
+	auto const task = [&f, &errors](size_t i) {
+		try {
+			f(i);
+		} catch (...) {
+			errors[i] = std::current_exception();
+		}
+	};
+
+	threads.reserve(tasks);
+	try {
+		for (; started < tasks; ++started)
+			threads.emplace_back(task, started);
+	} catch (std::system_error const &) {
+	}
+
+	for (size_t i = started; i < tasks; ++i)
+		task(i);
+	if (tasks)
+		task(0);
+
+	for (std::thread &thread : threads)
+		thread.join();
+
+	for (std::exception_ptr const &error : errors)
+		if (error)
+			std::rethrow_exception(error);
+}
+
+/**
+ * Sorts chunks of the range in parallel and merges them pairwise, merges
+ * of the same round run in parallel too.
+ **/
+template <typename It, typename Cmp>
+void parallel_sort(It first, It last, Cmp cmp, size_t threads)
+{
+	size_t const size = static_cast<size_t>(std::distance(first, last));
+	size_t const chunks = std::min(threads, size / 4096 + 1);
+
+	if (chunks < 2) {
+		std::sort(first, last, cmp);
+		return;
+	}
+
+	std::vector<It> bounds;
+	for (size_t i = 0; i != chunks; ++i)
+		bounds.push_back(std::next(first, size * i / chunks));
+	bounds.push_back(last);
+
+	run_parallel(chunks, [&bounds, &cmp](size_t i) {
+		std::sort(bounds[i], bounds[i + 1], cmp);
+	});
+
+	for (size_t width = 1; width < chunks; width *= 2) {
+		size_t const merges = (chunks + 2 * width - 1) / (2 * width);
+
+		run_parallel(merges, [&bounds, &cmp, width, chunks](size_t i) {
+			size_t const lo = 2 * width * i;
+			size_t const mid = std::min(lo + width, chunks);
+			size_t const hi = std::min(lo + 2 * width, chunks);
+
+			std::inplace_merge(bounds[lo], bounds[mid], bounds[hi],
+						cmp);
+		});
+	}
+}
+
+#endif /*__PARALLEL_HPP__*/
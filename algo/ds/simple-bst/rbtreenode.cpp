@@ -0,0 +1,295 @@
+#include "rbtreenode.hpp"
+
+static struct TreeNode *left_of(struct TreeNode *node)
+{ return node->left == node ? 0 : node->left; }
+
+static struct TreeNode *right_of(struct TreeNode *node)
+{ return node->right == node ? 0 : node->right; }
+
+static void set_left(struct TreeNode *parent, struct TreeNode *left)
+{
+	if (left)
+		add_left(left, parent);
+	else
+		parent->left = parent;
+}
+
+static void set_right(struct TreeNode *parent, struct TreeNode *right)
+{
+	if (right)
+		add_right(right, parent);
+	else
+		parent->right = parent;
+}
+
+static void replace_child(struct TreeNode *parent, struct TreeNode *old,
+			struct TreeNode *node)
+{
+	if (parent->left == old)
+		set_left(parent, node);
+	else
+		set_right(parent, node);
+}
+
+static int is_red(struct TreeNode const *node)
+{ return node && static_cast<struct RBTreeNode const *>(node)->red; }
+
+static void set_red(struct TreeNode *node, int red)
+{ static_cast<struct RBTreeNode *>(node)->red = red; }
+
+/**
+ * Rotations don't change the set of nodes in the subtree, so only augmented
+ * data of the two rotated nodes needs an update, the lower one first.
+ **/
+static void rotate_left(struct TreeNode *node, tree_update_t update)
+{
+	struct TreeNode *parent = node->parent;
+	struct TreeNode *right = node->right;
+
+	set_right(node, left_of(right));
+	replace_child(parent, node, right);
+	add_left(node, right);
+
+	if (update) {
+		update(node);
+		update(right);
+	}
+}
+
+static void rotate_right(struct TreeNode *node, tree_update_t update)
+{
+	struct TreeNode *parent = node->parent;
+	struct TreeNode *left = node->left;
+
+	set_left(node, right_of(left));
+	replace_child(parent, node, left);
+	add_right(node, left);
+
+	if (update) {
+		update(node);
+		update(left);
+	}
+}
+
+void rb_insert_fixup(struct TreeNode *node, struct TreeNode *head,
+			tree_update_t update)
+{
+	set_red(node, 1);
+
+	while (node->parent != head && is_red(node->parent)) {
+		struct TreeNode *parent = node->parent;
+		struct TreeNode *grand = parent->parent;
+
+		if (parent == grand->left) {
+			struct TreeNode *uncle = right_of(grand);
+
+			if (is_red(uncle)) {
+				set_red(parent, 0);
+				set_red(uncle, 0);
+				set_red(grand, 1);
+				node = grand;
+				continue;
+			}
+
+			if (node == parent->right) {
+				rotate_left(parent, update);
+				parent = node;
+			}
+
+			set_red(parent, 0);
+			set_red(grand, 1);
+			rotate_right(grand, update);
+			break;
+		} else {
+			struct TreeNode *uncle = left_of(grand);
+
+			if (is_red(uncle)) {
+				set_red(parent, 0);
+				set_red(uncle, 0);
+				set_red(grand, 1);
+				node = grand;
+				continue;
+			}
+
+			if (node == parent->left) {
+				rotate_right(parent, update);
+				parent = node;
+			}
+
+			set_red(parent, 0);
+			set_red(grand, 1);
+			rotate_left(grand, update);
+			break;
+		}
+	}
+
+	set_red(head->left, 0);
+}
+
+/**
+ * node (possibly missing) with parent has one black less on its paths
+ * than its sibling.
+ **/
+static void rb_erase_fixup(struct TreeNode *node, struct TreeNode *parent,
+			struct TreeNode *head, tree_update_t update)
+{
+	while (parent != head && !is_red(node)) {
+		if (node == left_of(parent)) {
+			struct TreeNode *sibling = right_of(parent);
+
+			if (is_red(sibling)) {
+				set_red(sibling, 0);
+				set_red(parent, 1);
+				rotate_left(parent, update);
+				sibling = right_of(parent);
+			}
+
+			if (!is_red(left_of(sibling))
+					&& !is_red(right_of(sibling))) {
+				set_red(sibling, 1);
+				node = parent;
+				parent = node->parent;
+				continue;
+			}
+
+			if (!is_red(right_of(sibling))) {
+				set_red(left_of(sibling), 0);
+				set_red(sibling, 1);
+				rotate_right(sibling, update);
+				sibling = right_of(parent);
+			}
+
+			set_red(sibling, is_red(parent));
+			set_red(parent, 0);
+			set_red(right_of(sibling), 0);
+			rotate_left(parent, update);
+		} else {
+			struct TreeNode *sibling = left_of(parent);
+
+			if (is_red(sibling)) {
+				set_red(sibling, 0);
+				set_red(parent, 1);
+				rotate_right(parent, update);
+				sibling = left_of(parent);
+			}
+
+			if (!is_red(left_of(sibling))
+					&& !is_red(right_of(sibling))) {
+				set_red(sibling, 1);
+				node = parent;
+				parent = node->parent;
+				continue;
+			}
+
+			if (!is_red(left_of(sibling))) {
+				set_red(right_of(sibling), 0);
+				set_red(sibling, 1);
+				rotate_left(sibling, update);
+				sibling = left_of(parent);
+			}
+
+			set_red(sibling, is_red(parent));
+			set_red(parent, 0);
+			set_red(left_of(sibling), 0);
+			rotate_right(parent, update);
+		}
+
+		node = head->left;
+		break;
+	}
+
+	if (node && node != head)
+		set_red(node, 0);
+}
+
+void rb_erase(struct TreeNode *node, struct TreeNode *head,
+			tree_update_t update)
+{
+	struct TreeNode *child;
+	struct TreeNode *parent;
+	int removed_red;
+
+	if (!left_of(node) || !right_of(node)) {
+		child = left_of(node) ? left_of(node) : right_of(node);
+		parent = node->parent;
+		removed_red = is_red(node);
+		replace_child(node->parent, node, child);
+	} else {
+		struct TreeNode *next = const_cast<struct TreeNode *>(
+					left_most(node->right));
+
+		child = right_of(next);
+		removed_red = is_red(next);
+
+		if (next->parent == node) {
+			parent = next;
+		} else {
+			parent = next->parent;
+			set_left(parent, child);
+			add_right(node->right, next);
+		}
+
+		replace_child(node->parent, node, next);
+		add_left(node->left, next);
+		set_red(next, is_red(node));
+	}
+
+	/* parent is the lowest node whose subtree has changed */
+	update_path(parent, head, update);
+
+	if (!removed_red)
+		rb_erase_fixup(child, parent, head, update);
+}
+
+static void color_balanced(struct TreeNode *node, size_t depth,
+			size_t red_depth)
+{
+	set_red(node, depth >= red_depth);
+
+	if (node->left != node)
+		color_balanced(node->left, depth + 1, red_depth);
+	if (node->right != node)
+		color_balanced(node->right, depth + 1, red_depth);
+}
+
+void rb_color_balanced(struct TreeNode *head, size_t size)
+{
+	size_t levels = 0;
+
+	if (head->left == head)
+		return;
+
+	while ((size + 1) >> (levels + 1))
+		++levels;
+
+	color_balanced(head->left, 0, levels);
+}
+
+static int black_height(struct TreeNode const *node)
+{
+	int left;
+	int right;
+
+	if (is_red(node) && (is_red(node->left != node ? node->left : 0)
+			|| is_red(node->right != node ? node->right : 0)))
+		return -1;
+
+	left = node->left != node ? black_height(node->left) : 0;
+	right = node->right != node ? black_height(node->right) : 0;
+
+	if (left < 0 || left != right)
+		return -1;
+
+	return left + !is_red(node);
+}
+
+int rb_black_height(struct TreeNode const *head)
+{
+	if (head->left == head)
+		return 0;
+
+	if (is_red(head->left) || head->left->parent != head)
+		return -1;
+
+	return black_height(head->left);
+}
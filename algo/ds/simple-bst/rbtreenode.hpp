@@ -0,0 +1,43 @@
+#ifndef __RB_TREE_NODE_HPP__
+#define __RB_TREE_NODE_HPP__
+
+#include "treenode.hpp"
+
+/**
+ * Node of a red-black tree. Same conventions as for TreeNode: missing child
+ * points to the node itself and the root is the left child of the head.
+ * The head is a plain TreeNode and has no colour.
+ **/
+struct RBTreeNode : public TreeNode {
+	int red;
+};
+
+/**
+ * Rebalances the tree after node has been linked as a leaf. Augmented data
+ * on the path from node to the root must be up to date, rotations keep it
+ * that way with update (may be null).
+ **/
+void rb_insert_fixup(struct TreeNode *node, struct TreeNode *head,
+			tree_update_t update);
+
+/**
+ * Unlinks node from the tree and rebalances it, augmented data is updated
+ * with update (may be null). Doesn't update the leftmost node pointer
+ * (head->right).
+ **/
+void rb_erase(struct TreeNode *node, struct TreeNode *head,
+			tree_update_t update);
+
+/**
+ * Colours a tree of size nodes built by tree_from_list: nodes below the
+ * last complete level are red, the rest are black.
+ **/
+void rb_color_balanced(struct TreeNode *head, size_t size);
+
+/**
+ * Returns black height of the tree or -1 if red-black properties are
+ * broken, used in tests.
+ **/
+int rb_black_height(struct TreeNode const *head);
+
+#endif /*__RB_TREE_NODE_HPP__*/
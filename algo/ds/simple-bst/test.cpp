@@ -1,10 +1,18 @@
 #include "bst.hpp"
+#include "bst_multiset.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <cassert>
+#include <cmath>
 #include <cstdlib>
 #include <iterator>
+#include <map>
+#include <numeric>
+#include <set>
+#include <string>
+#include <vector>
 
 template <typename Ct>
 void fill_random(Ct &ct, size_t size)
@@ -41,7 +49,15 @@ struct Id {
 };
 
 using Tree = BinarySearchTree<int, int, Id<int>, std::less<int>>;
+using RBTree = BinarySearchTree<int, int, Id<int>, std::less<int>,
+				std::allocator<int>, RedBlackBalance>;
+using CountedTree = BinarySearchTree<int, int, Id<int>, std::less<int>,
+				std::allocator<int>, CountedBalance<>>;
+using CountedRBTree = BinarySearchTree<int, int, Id<int>, std::less<int>,
+				std::allocator<int>,
+				CountedBalance<RedBlackBalance>>;
 
+template <typename Tree>
 void run_range_construct_test(size_t size)
 {
 	using std::begin;
@@ -61,6 +77,7 @@ void run_range_construct_test(size_t size)
 	assert(std::equal(begin(tree), end(tree), begin(source)));
 }
 
+template <typename Tree>
 void run_clear_test(size_t size)
 {
 	using std::begin;
@@ -79,11 +96,576 @@ void run_clear_test(size_t size)
 	assert(tree.size() == 0);
 }
 
+template <typename Tree>
+void check_tree(Tree &tree, std::multiset<int> const &check)
+{
+	using std::begin;
+	using std::end;
+
+	assert(tree.size() == check.size());
+	assert(tree.empty() == check.empty());
+	assert(static_cast<size_t>(std::distance(begin(tree), end(tree)))
+				== check.size());
+	assert(std::equal(begin(tree), end(tree), begin(check)));
+	for (auto it = begin(check); it != end(check);
+				it = check.upper_bound(*it)) {
+		auto const next = check.upper_bound(*it);
+		auto const upper = tree.upper_bound(*it);
+
+		assert(tree.count(*it) == check.count(*it));
+		assert(next == end(check) ? upper == end(tree)
+					: *upper == *next);
+	}
+	assert(std::equal(std::reverse_iterator<typename Tree::iterator>(
+				end(tree)),
+			std::reverse_iterator<typename Tree::iterator>(
+				begin(tree)),
+			check.rbegin()));
+}
+
+/**
+ * Sorted input goes through the rightmost node shortcut, erasing the
+ * largest elements makes the tree find the new rightmost node.
+ **/
+template <typename Tree>
+void run_sorted_test(size_t size)
+{
+	Tree tree;
+	std::multiset<int> check;
+
+	for (size_t i = 0; i != size; ++i) {
+		int const key = static_cast<int>(i / 2);
+
+		tree.insert(key);
+		check.insert(key);
+	}
+	check_tree(tree, check);
+
+	for (size_t i = 0; i != size; ++i) {
+		int const key = static_cast<int>(size + i);
+
+		for (size_t j = 0; j != i % 3 && !check.empty(); ++j) {
+			auto const last = --end(tree);
+
+			assert(*last == *check.rbegin());
+			tree.erase(last);
+			check.erase(--end(check));
+		}
+		tree.insert(key);
+		check.insert(key);
+		tree.insert(-key);
+		check.insert(-key);
+	}
+	check_tree(tree, check);
+
+	tree.erase(begin(tree), end(tree));
+	check_tree(tree, std::multiset<int>());
+	tree.insert(1);
+	tree.insert(0);
+	check_tree(tree, std::multiset<int>{0, 1});
+}
+
+template <typename Tree>
+void run_move_test(size_t size)
+{
+	using std::begin;
+	using std::end;
+
+	std::vector<int> source;
+	fill_random(source, size);
+
+	Tree tree(begin(source), end(source));
+	std::multiset<int> check(begin(source), end(source));
+	check_tree(tree, check);
+
+	Tree moved(std::move(tree));
+	check_tree(moved, check);
+	check_tree(tree, std::multiset<int>());
+
+	Tree other;
+	other.reserve(size);
+	other.insert(42);
+	other.swap(moved);
+	check_tree(other, check);
+	check_tree(moved, std::multiset<int>{42});
+
+	moved = std::move(other);
+	check_tree(moved, check);
+	check_tree(other, std::multiset<int>());
+
+	/* trees are still usable after a move: heads are linked properly */
+	for (size_t i = 0; i != size / 2; ++i) {
+		int const key = source[i];
+
+		moved.erase(moved.find(key));
+		check.erase(check.find(key));
+		other.insert(key);
+		tree.insert(key);
+	}
+	check_tree(moved, check);
+	check_tree(other, std::multiset<int>(begin(source),
+				begin(source) + size / 2));
+
+	tree.clear();
+	moved.clear();
+	check_tree(tree, std::multiset<int>());
+	check_tree(moved, std::multiset<int>());
+}
+
+template <typename Tree>
+void check_order(Tree const &tree, std::multiset<int> const &check)
+{
+	using std::begin;
+	using std::end;
+
+	size_t k = 0;
+	for (auto it = begin(check); it != end(check); ++it, ++k) {
+		assert(*tree.nth(k) == *it);
+		assert(tree.rank(*it) == static_cast<size_t>(std::distance(
+					begin(check), check.lower_bound(*it))));
+		assert(tree.count(*it) == check.count(*it));
+	}
+	assert(tree.nth(k) == end(tree));
+	assert(tree.count(-1) == 0);
+	assert(tree.rank(-1) == 0);
+	assert(tree.rank(RAND_MAX) == check.size() - check.count(RAND_MAX));
+}
+
+/**
+ * Lots of duplicates, so count has something to count.
+ **/
+template <typename Tree>
+void run_order_test(size_t size)
+{
+	int const keys = static_cast<int>(size / 8 + 1);
+	Tree tree;
+	std::multiset<int> check;
+
+	for (size_t i = 0; i != size; ++i) {
+		int const key = rand() % keys;
+
+		tree.insert(key);
+		check.insert(key);
+	}
+	check_order(tree, check);
+
+	for (size_t i = 0; i != size; ++i) {
+		int const key = rand() % keys;
+
+		if (rand() % 2) {
+			tree.insert(key);
+			check.insert(key);
+		} else if (tree.find(key) != end(tree)) {
+			tree.erase(tree.find(key));
+			check.erase(check.find(key));
+		}
+
+		if (size <= 100)
+			check_order(tree, check);
+	}
+	check_order(tree, check);
+
+	auto const range = tree.equal_range(keys / 2);
+	tree.erase(range.first, range.second);
+	check.erase(keys / 2);
+	check_order(tree, check);
+}
+
+template <typename Multiset>
+void run_multiset_test(size_t size)
+{
+	using std::begin;
+	using std::end;
+
+	int const keys = static_cast<int>(size / 8 + 1);
+	Multiset set;
+	std::multiset<int> check;
+
+	for (size_t i = 0; i != size; ++i) {
+		int const key = rand() % keys;
+		size_t const n = static_cast<size_t>(rand() % 4);
+
+		auto it = set.insert(key, n);
+		assert(it == end(set) ? !n && !set.count(key) : it->key == key);
+		for (size_t j = 0; j != n; ++j)
+			check.insert(key);
+	}
+
+	for (size_t i = 0; i != size / 2; ++i) {
+		int const key = rand() % keys;
+		size_t const n = static_cast<size_t>(rand() % 4);
+		size_t const removed = std::min(n, check.count(key));
+
+		assert(set.erase(key, n) == removed);
+		for (size_t j = 0; j != removed; ++j)
+			check.erase(check.find(key));
+	}
+
+	assert(set.erase(keys / 2) == check.erase(keys / 2));
+
+	std::map<int, size_t> runs;
+	for (int key : check)
+		++runs[key];
+
+	assert(set.size() == check.size());
+	assert(set.runs() == runs.size());
+	assert(std::equal(begin(runs), end(runs), begin(set),
+		[](std::pair<int const, size_t> const &l,
+				KeyRun<int> const &r)
+		{ return l.first == r.key && l.second == r.count; }));
+
+	size_t k = 0;
+	for (auto it = begin(check); it != end(check); ++it, ++k) {
+		assert(set.nth(k)->key == *it);
+		assert(set.count(*it) == runs[*it]);
+		assert(set.rank(*it) == static_cast<size_t>(std::distance(
+					begin(check), check.lower_bound(*it))));
+	}
+	assert(set.nth(k) == end(set));
+
+	set.clear();
+	assert(set.empty() && set.runs() == 0);
+}
+
+template <typename Tree, typename Op, typename Check>
+void check_set_op(std::vector<int> const &l, std::vector<int> const &r,
+			Op op, Check check)
+{
+	using std::begin;
+	using std::end;
+
+	Tree left(begin(l), end(l));
+	Tree right(begin(r), end(r));
+	std::vector<int> expected;
+
+	check(begin(l), end(l), begin(r), end(r),
+				std::back_inserter(expected));
+	op(left, right);
+
+	assert(right.empty());
+	check_tree(left, std::multiset<int>(begin(expected), end(expected)));
+
+	/* the result is a valid tree that works as usual */
+	left.insert(0);
+	right.insert(0);
+	expected.insert(std::lower_bound(begin(expected), end(expected), 0), 0);
+	assert(std::equal(begin(left), end(left), begin(expected)));
+}
+
+template <typename Tree>
+void run_set_test(size_t size)
+{
+	using std::begin;
+	using std::end;
+
+	int const keys = static_cast<int>(size / 2 + 1);
+	std::vector<int> l;
+	std::vector<int> r;
+
+	for (size_t i = 0; i != size; ++i) {
+		l.push_back(rand() % keys);
+		if (i % 3)
+			r.push_back(rand() % keys);
+	}
+	std::sort(begin(l), end(l));
+	std::sort(begin(r), end(r));
+
+	using It = std::vector<int>::const_iterator;
+	using Out = std::back_insert_iterator<std::vector<int>>;
+
+	check_set_op<Tree>(l, r, [](Tree &x, Tree &y) { x.merge(y); },
+				std::merge<It, It, Out>);
+	check_set_op<Tree>(r, l, [](Tree &x, Tree &y) { x.merge(y); },
+				std::merge<It, It, Out>);
+	check_set_op<Tree>(l, r, [](Tree &x, Tree &y) { x.set_union(y); },
+				std::set_union<It, It, Out>);
+	check_set_op<Tree>(l, r,
+				[](Tree &x, Tree &y) { x.set_intersection(y); },
+				std::set_intersection<It, It, Out>);
+	check_set_op<Tree>(l, r, [](Tree &x, Tree &y) { x.set_difference(y); },
+				std::set_difference<It, It, Out>);
+	check_set_op<Tree>(r, l, [](Tree &x, Tree &y) { x.set_difference(y); },
+				std::set_difference<It, It, Out>);
+
+	Tree self(begin(l), end(l));
+	self.merge(self);
+	self.set_union(self);
+	self.set_intersection(self);
+	check_tree(self, std::multiset<int>(begin(l), end(l)));
+	self.set_difference(self);
+	assert(self.empty());
+}
+
+/* allocations left before Budgeted throws, none if negative */
+long allocations_left = -1;
+
+/**
+ * Allocator of arena id, which compares unequal to allocators of other
+ * arenas so that set operations copy nodes between them.
+ **/
+template <typename T>
+struct Budgeted {
+	using value_type = T;
+
+	int arena;
+
+	explicit Budgeted(int arena = 0) : arena(arena) {}
+
+	template <typename U>
+	Budgeted(Budgeted<U> const &other) : arena(other.arena) {}
+
+	T *allocate(size_t n)
+	{
+		if (allocations_left == 0)
+			throw std::bad_alloc();
+		if (allocations_left > 0)
+			--allocations_left;
+		return static_cast<T *>(::operator new(n * sizeof(T)));
+	}
+
+	void deallocate(T *ptr, size_t)
+	{ ::operator delete(ptr); }
+};
+
+template <typename T, typename U>
+bool operator==(Budgeted<T> const &lhs, Budgeted<U> const &rhs)
+{ return lhs.arena == rhs.arena; }
+
+template <typename T, typename U>
+bool operator!=(Budgeted<T> const &lhs, Budgeted<U> const &rhs)
+{ return lhs.arena != rhs.arena; }
+
+void run_set_copy_test(size_t size)
+{
+	using StringTree = BinarySearchTree<std::string, std::string,
+		Id<std::string>, std::less<std::string>,
+		Budgeted<std::string>>;
+
+	std::vector<std::string> values;
+	for (size_t i = 0; i != size; ++i)
+		values.push_back(std::to_string(rand()) + " padded past SSO");
+
+	StringTree left{Budgeted<std::string>(1)};
+	StringTree right(begin(values), end(values), std::less<std::string>(),
+				Budgeted<std::string>(2));
+
+	/* merge fails half way through copying right, which stays intact */
+	allocations_left = static_cast<long>(size / 2);
+	try {
+		left.merge(right);
+		assert(size == 0);
+	} catch (std::bad_alloc const &) {
+		assert(size != 0);
+	}
+	allocations_left = -1;
+
+	std::sort(begin(values), end(values));
+	assert(left.empty());
+	assert(right.size() == size);
+	assert(std::equal(begin(right), end(right), begin(values)));
+
+	left.merge(right);
+	assert(right.empty());
+	assert(std::equal(begin(left), end(left), begin(values)));
+}
+
+template <typename Tree>
+size_t tree_height(Tree const &tree)
+{
+	TreeNode const *head = tree.end().node;
+	size_t height = 0;
+
+	for (auto it = tree.begin(); it != tree.end(); ++it) {
+		size_t depth = 0;
+
+		for (TreeNode const *node = it.node; node != head;
+					node = node->parent)
+			++depth;
+		height = std::max(height, depth);
+	}
+
+	return height;
+}
+
+void check_balance(RBTree const &tree, size_t size)
+{
+	assert(rb_black_height(tree.end().node) >= 0);
+	assert(tree_height(tree) <= 2 * std::log2(size + 1));
+}
+
+void run_build_balance_test(size_t size)
+{
+	using std::begin;
+	using std::end;
+
+	std::vector<int> source;
+	fill_random(source, size);
+
+	RBTree tree;
+	RBTree other(begin(source), end(source));
+	tree.merge(other);
+	check_balance(tree, size);
+
+	CountedRBTree counted;
+	CountedRBTree counted_other(begin(source), end(source));
+	counted.set_union(counted_other);
+	check_order(counted, std::multiset<int>(begin(source), end(source)));
+
+	std::multiset<int> const sorted(begin(source), end(source));
+	RBTree from_sorted(sorted_input, begin(sorted), end(sorted));
+	check_balance(from_sorted, size);
+	assert(std::equal(begin(sorted), end(sorted), begin(from_sorted)));
+
+	CountedRBTree counted_sorted(sorted_input, begin(sorted), end(sorted));
+	check_order(counted_sorted, sorted);
+
+	for (size_t i = 0; i != size; ++i) {
+		tree.insert(rand());
+		if (size <= 100)
+			check_balance(tree, tree.size());
+	}
+	check_balance(tree, tree.size());
+}
+
+template <typename Tree>
+void run_parallel_test(size_t size, size_t threads)
+{
+	using std::begin;
+	using std::end;
+
+	int const keys = static_cast<int>(size / 4 + 1);
+	std::vector<int> source;
+	for (size_t i = 0; i != size; ++i)
+		source.push_back(rand() % keys);
+
+	Tree tree(Parallel(threads), begin(source), end(source));
+	std::multiset<int> check(begin(source), end(source));
+	check_tree(tree, check);
+
+	std::atomic<size_t> visited(0);
+	std::atomic<long long> sum(0);
+	tree.parallel_for_each([&visited, &sum](int const &x) {
+		++visited;
+		sum += x;
+	}, Parallel(threads));
+	assert(visited == size);
+	assert(sum == std::accumulate(begin(source), end(source), 0LL));
+
+	bool thrown = false;
+	try {
+		Tree const &ctree = tree;
+		ctree.parallel_for_each([](int const &x) {
+			if (x == 0)
+				throw x;
+		}, Parallel(threads));
+	} catch (int x) {
+		thrown = true;
+		assert(x == 0);
+	}
+	assert(thrown == (check.count(0) != 0));
+
+	/* the result is a valid tree that works as usual */
+	for (size_t i = 0; i != size; ++i) {
+		int const key = rand() % keys;
+
+		tree.insert(key);
+		check.insert(key);
+	}
+	check_tree(tree, check);
+}
+
+void run_parallel_balance_test(size_t size, size_t threads)
+{
+	using std::begin;
+	using std::end;
+
+	std::vector<int> source;
+	fill_random(source, size);
+
+	RBTree tree(Parallel(threads), begin(source), end(source));
+	check_balance(tree, size);
+
+	CountedRBTree counted(Parallel(threads), begin(source), end(source));
+	check_order(counted, std::multiset<int>(begin(source), end(source)));
+}
+
+void run_balance_test(size_t size)
+{
+	using std::begin;
+	using std::end;
+
+	std::vector<int> source;
+	for (size_t i = 0; i != size; ++i)
+		source.push_back(static_cast<int>(i));
+
+	RBTree sorted(begin(source), end(source));
+	LOG_CONTAINER(sorted);
+	check_balance(sorted, size);
+	assert(std::equal(begin(sorted), end(sorted), begin(source)));
+
+	RBTree reversed(source.rbegin(), source.rend());
+	check_balance(reversed, size);
+	assert(std::equal(begin(reversed), end(reversed), begin(source)));
+
+	std::multiset<int> check(begin(source), end(source));
+	for (size_t i = 0; i != size; ++i) {
+		int const key = rand() % static_cast<int>(size);
+
+		if (rand() % 2) {
+			sorted.insert(key);
+			check.insert(key);
+		} else if (sorted.find(key) != end(sorted)) {
+			sorted.erase(sorted.find(key));
+			check.erase(check.find(key));
+		}
+
+		if (size <= 1000)
+			check_balance(sorted, check.size());
+	}
+	check_balance(sorted, check.size());
+	assert(sorted.size() == check.size());
+	assert(std::equal(begin(sorted), end(sorted), begin(check)));
+
+	sorted.erase(sorted.lower_bound(static_cast<int>(size / 4)),
+			sorted.lower_bound(static_cast<int>(size / 2)));
+	check.erase(check.lower_bound(static_cast<int>(size / 4)),
+			check.lower_bound(static_cast<int>(size / 2)));
+	check_balance(sorted, check.size());
+	assert(std::equal(begin(sorted), end(sorted), begin(check)));
+}
+
 int main()
 {
 	for (size_t size : {0, 1, 10, 100, 1000, 10000}) {
-		run_clear_test(size);
-		run_range_construct_test(size);
+		run_clear_test<Tree>(size);
+		run_range_construct_test<Tree>(size);
+		run_clear_test<RBTree>(size);
+		run_range_construct_test<RBTree>(size);
+		run_sorted_test<Tree>(size);
+		run_sorted_test<RBTree>(size);
+		run_sorted_test<CountedRBTree>(size);
+		run_move_test<Tree>(size);
+		run_move_test<RBTree>(size);
+		run_move_test<CountedTree>(size);
+		run_move_test<CountedRBTree>(size);
+		run_order_test<CountedTree>(size);
+		run_order_test<CountedRBTree>(size);
+		run_multiset_test<BSTMultiset<int>>(size);
+		run_multiset_test<BSTMultiset<int, std::less<int>,
+			std::allocator<KeyRun<int>>, RedBlackBalance>>(size);
+		run_balance_test(size);
+		run_build_balance_test(size);
+		run_set_test<Tree>(size);
+		run_set_test<RBTree>(size);
+		run_set_test<CountedRBTree>(size);
+		run_set_copy_test(size);
+
+		for (size_t threads : {1, 3, 4}) {
+			run_parallel_test<Tree>(size, threads);
+			run_parallel_test<RBTree>(size, threads);
+			run_parallel_test<CountedRBTree>(size, threads);
+			run_parallel_balance_test(size, threads);
+		}
 	}
 
 	return 0;
@@ -60,3 +60,98 @@ struct TreeNode const *prev_node(struct TreeNode const *node)
 
 	return node->parent;
 }
+
+void update_path(struct TreeNode *node, struct TreeNode *head,
+			tree_update_t update)
+{
+	if (!update)
+		return;
+
+	for (; node != head; node = node->parent)
+		update(node);
+}
+
+static void fix_head(struct TreeNode *head, struct TreeNode *other)
+{
+	head->parent = head;
+
+	if (head->left == other) {
+		head->left = head;
+		head->right = head;
+	} else {
+		head->left->parent = head;
+	}
+}
+
+void swap_heads(struct TreeNode *lhead, struct TreeNode *rhead)
+{
+	struct TreeNode tmp = *lhead;
+
+	*lhead = *rhead;
+	*rhead = tmp;
+
+	fix_head(lhead, rhead);
+	fix_head(rhead, lhead);
+}
+
+struct TreeNode *tree_unlink_next(struct TreeNode **cursor,
+			struct TreeNode *head)
+{
+	struct TreeNode *node = *cursor;
+
+	while (node != head) {
+		struct TreeNode *left = node->left;
+
+		if (left == node) {
+			*cursor = node->right != node ? node->right : head;
+			return node;
+		}
+
+		node->left = left->right != left ? left->right : node;
+		left->right = node;
+		node = left;
+	}
+
+	*cursor = head;
+	return 0;
+}
+
+static struct TreeNode *build_tree(struct TreeNode **list, size_t size,
+			tree_update_t update)
+{
+	struct TreeNode *left;
+	struct TreeNode *right;
+	struct TreeNode *root;
+
+	if (!size)
+		return 0;
+
+	left = build_tree(list, (size - 1) / 2, update);
+	root = *list;
+	*list = root->right;
+	right = build_tree(list, size - 1 - (size - 1) / 2, update);
+
+	root->left = root;
+	root->right = root;
+	if (left)
+		add_left(left, root);
+	if (right)
+		add_right(right, root);
+
+	if (update)
+		update(root);
+	return root;
+}
+
+struct TreeNode *tree_from_list(struct TreeNode *head, struct TreeNode *list,
+			size_t size, tree_update_t update)
+{
+	struct TreeNode *root = build_tree(&list, size, update);
+
+	if (!root)
+		return head;
+
+	add_left(root, head);
+	head->right = const_cast<struct TreeNode *>(left_most(root));
+	return const_cast<struct TreeNode *>(right_most(root));
+}
@@ -1,6 +1,8 @@
 #ifndef __TREE_NODE_HPP__
 #define __TREE_NODE_HPP__
 
+#include <cstddef>
+
 struct TreeNode {
 	struct TreeNode *parent;
 	struct TreeNode *left;
@@ -25,4 +27,42 @@ struct TreeNode const *next_node(struct TreeNode const *node);
 
 struct TreeNode const *prev_node(struct TreeNode const*node);
 
+/**
+ * Augmentation callback: recomputes what a node keeps about its subtree
+ * (e. g. size of the subtree) from the node and its children. Trees without
+ * augmentation pass a null pointer.
+ **/
+typedef void (*tree_update_t)(struct TreeNode *node);
+
+/**
+ * Calls update for node and all its ancestors up to head, does nothing if
+ * update is null.
+ **/
+void update_path(struct TreeNode *node, struct TreeNode *head,
+			tree_update_t update);
+
+/**
+ * Exchanges trees hanging off two heads, links from roots back to heads
+ * and self links of empty heads are fixed up.
+ **/
+void swap_heads(struct TreeNode *lhead, struct TreeNode *rhead);
+
+/**
+ * Takes the tree apart in order, one node per call, and returns null when
+ * there are no nodes left. *cursor must start at head->left and the head
+ * must be reinitialized afterwards. Left children are rotated up, so parent
+ * links are not used and links of a returned node may be reused right away.
+ **/
+struct TreeNode *tree_unlink_next(struct TreeNode **cursor,
+			struct TreeNode *head);
+
+/**
+ * Builds a tree of the minimal height from the first size nodes of the list
+ * linked through right and hangs it off the empty head, update (may be null)
+ * is called for every node after its children. Returns the rightmost node
+ * (or head for an empty tree).
+ **/
+struct TreeNode *tree_from_list(struct TreeNode *head, struct TreeNode *list,
+			size_t size, tree_update_t update);
+
 #endif /*__TREE_NODE_HPP__*/
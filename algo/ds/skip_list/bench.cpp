@@ -0,0 +1,133 @@
+#include "skip_list.hpp"
+
+#include "../simple-bst/bst.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+template <typename T>
+struct Id {
+	T const &operator()(T const &x) const
+	{ return x; }
+};
+
+using List = SkipList<int, int, Id<int>, std::less<int>>;
+using RBTree = BinarySearchTree<int, int, Id<int>, std::less<int>,
+			std::allocator<int>, RedBlackBalance>;
+
+/**
+ * What the ingest path does today: a BinarySearchTree under one mutex,
+ * with the interface of SkipList.
+ **/
+class MutexTree {
+public:
+	bool contains(int key)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		return m_tree.find(key) != m_tree.end();
+	}
+
+	bool emplace(int key)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		if (m_tree.find(key) != m_tree.end())
+			return false;
+		m_tree.emplace(key);
+		return true;
+	}
+
+	size_t erase(int key)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		RBTree::iterator it = m_tree.find(key);
+
+		if (it == m_tree.end())
+			return 0;
+		m_tree.erase(it);
+		return 1;
+	}
+
+private:
+	std::mutex m_lock;
+	RBTree m_tree;
+};
+
+/**
+ * Returns operations per second of threads running ops random operations
+ * each over keys keys (half of them inserted up front), writes percent of
+ * them are inserts and erases half and half, the rest are lookups.
+ **/
+template <typename Map>
+double run_threads(size_t keys, size_t ops, size_t threads, unsigned writes)
+{
+	Map map;
+	std::vector<int> input;
+
+	for (size_t i = 0; i < keys; i += 2)
+		input.push_back(static_cast<int>(i));
+	std::shuffle(input.begin(), input.end(), std::mt19937());
+	for (int key : input)
+		map.emplace(key);
+
+	std::vector<std::thread> workers;
+	std::vector<size_t> hits(threads);
+
+	auto const start = std::chrono::steady_clock::now();
+	for (size_t t = 0; t != threads; ++t) {
+		workers.emplace_back([&map, &hits, t, keys, ops, writes] {
+			std::mt19937 gen(static_cast<unsigned>(t));
+			size_t hit = 0;
+
+			for (size_t i = 0; i != ops; ++i) {
+				int const key = static_cast<int>(gen() % keys);
+				unsigned const op = gen() % 200;
+
+				if (op < writes)
+					hit += map.emplace(key);
+				else if (op < 2 * writes)
+					hit += map.erase(key);
+				else
+					hit += map.contains(key);
+			}
+			hits[t] = hit;
+		});
+	}
+	for (std::thread &worker : workers)
+		worker.join();
+	auto const stop = std::chrono::steady_clock::now();
+
+	return threads * ops /
+		std::chrono::duration<double>(stop - start).count();
+}
+
+int main(int argc, char **argv)
+{
+	size_t const keys = argc > 1 ? atol(argv[1]) : 1000000;
+	size_t const ops = argc > 2 ? atol(argv[2]) : 1000000;
+	size_t const cores = argc > 3 ? atol(argv[3])
+		: std::max(std::thread::hardware_concurrency(), 1u);
+	unsigned const mixes[] = {10, 50, 100};
+
+	std::cout << keys << " keys, " << ops
+		<< " operations per thread, Mops/s" << std::endl;
+	std::cout << "writes\tthreads\tmutex RB tree\tSkipList" << std::endl;
+
+	for (unsigned writes : mixes) {
+		for (size_t threads = 1; threads <= cores; threads *= 2) {
+			std::cout << writes << "%\t" << threads << "\t"
+				<< run_threads<MutexTree>(keys, ops, threads,
+					writes) / 1e6 << "\t"
+				<< run_threads<List>(keys, ops, threads,
+					writes) / 1e6 << std::endl;
+		}
+	}
+
+	return 0;
+}
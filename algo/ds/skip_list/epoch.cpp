@@ -0,0 +1,132 @@
+#include "epoch.hpp"
+
+#include <thread>
+
+namespace
+{
+	/* slot a thread starts looking from, neighbours get neighbours */
+	size_t thread_slot()
+	{
+		static std::atomic<size_t> next(0);
+		static thread_local size_t const slot =
+			next.fetch_add(1, std::memory_order_relaxed);
+
+		return slot;
+	}
+}
+
+/* epoch 0 in a slot means the slot isn't inside an operation */
+EpochDomain::EpochDomain(EpochReclaim reclaim, void *ctx)
+: global_epoch(1)
+, reclaim(reclaim)
+, ctx(ctx)
+{
+	for (size_t i = 0; i != slot_count; ++i) {
+		slots[i].busy.store(false, std::memory_order_relaxed);
+		slots[i].epoch.store(0, std::memory_order_relaxed);
+		slots[i].retired = 0;
+		slots[i].count = 0;
+		slots[i].collect_at = collect_threshold;
+	}
+}
+
+EpochDomain::~EpochDomain()
+{
+	for (size_t i = 0; i != slot_count; ++i)
+		reclaim_list(slots[i].retired);
+}
+
+size_t EpochDomain::retired() const
+{
+	size_t count = 0;
+
+	for (size_t i = 0; i != slot_count; ++i)
+		count += slots[i].count;
+	return count;
+}
+
+EpochDomain::Slot *EpochDomain::enter()
+{
+	size_t const first = thread_slot();
+
+	for (size_t i = 0; ; ++i) {
+		Slot *slot = &slots[(first + i) % slot_count];
+
+		if (!slot->busy.load(std::memory_order_relaxed)
+				&& !slot->busy.exchange(true,
+					std::memory_order_acquire)) {
+			/* announce before the first read of shared data */
+			slot->epoch.store(global_epoch.load());
+			return slot;
+		}
+
+		if (i && i % slot_count == 0)
+			std::this_thread::yield();
+	}
+}
+
+void EpochDomain::leave(Slot *slot)
+{
+	slot->epoch.store(0, std::memory_order_release);
+	if (slot->count >= slot->collect_at)
+		collect(slot);
+	slot->busy.store(false, std::memory_order_release);
+}
+
+void EpochDomain::retire(Slot *slot, EpochNode *node)
+{
+	node->epoch = global_epoch.load();
+	node->next = slot->retired;
+	slot->retired = node;
+	++slot->count;
+}
+
+void EpochDomain::try_advance()
+{
+	uint64_t epoch = global_epoch.load();
+
+	for (size_t i = 0; i != slot_count; ++i) {
+		uint64_t const announced = slots[i].epoch.load();
+
+		if (announced && announced != epoch)
+			return;
+	}
+	global_epoch.compare_exchange_strong(epoch, epoch + 1);
+}
+
+/**
+ * Retired list is ordered from the newest to the oldest, so once an
+ * object is old enough the rest of the list is too.
+ **/
+void EpochDomain::collect(Slot *slot)
+{
+	try_advance();
+
+	uint64_t const epoch = global_epoch.load();
+	EpochNode **link = &slot->retired;
+
+	while (*link && (*link)->epoch + 2 > epoch)
+		link = &(*link)->next;
+
+	EpochNode *old = *link;
+
+	*link = 0;
+	slot->count -= reclaim_list(old);
+
+	/* a stalled guard holds the epoch back, don't rescan every time */
+	slot->collect_at = slot->count + collect_threshold;
+}
+
+size_t EpochDomain::reclaim_list(EpochNode *list)
+{
+	size_t count = 0;
+
+	while (list) {
+		EpochNode *next = list->next;
+
+		reclaim(list, ctx);
+		list = next;
+		++count;
+	}
+	return count;
+}
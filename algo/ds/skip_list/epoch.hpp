@@ -0,0 +1,110 @@
+#ifndef __EPOCH_HPP__
+#define __EPOCH_HPP__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Header of an object retired to an EpochDomain, objects embed it.
+ **/
+struct EpochNode {
+	EpochNode *next;
+	uint64_t epoch;
+};
+
+typedef void (*EpochReclaim)(EpochNode *node, void *ctx);
+
+/**
+ * Epoch based memory reclamation. Lock-free readers may still look at an
+ * object after it was unlinked, so it can't be freed right away: it's
+ * retired instead and freed once every reader that could have seen it is
+ * gone.
+ *
+ * Every operation runs under an EpochGuard, which takes a slot and
+ * announces the global epoch it started in. An object retired in epoch e
+ * was unlinked before the global epoch moved past e, and the epoch moves
+ * only when all announced epochs are equal to it, so when the global epoch
+ * reaches e + 2 nobody can reach the object any more.
+ *
+ * A guard owns its slot for the duration of an operation (threads prefer
+ * the same slot every time), so there is no registration of threads and
+ * retired objects live in the slot they were retired in. A thread stalled
+ * inside a guard keeps the epoch from moving: memory isn't freed until it
+ * leaves, but other threads aren't blocked.
+ **/
+class EpochDomain {
+public:
+	EpochDomain(EpochReclaim reclaim, void *ctx);
+
+	/**
+	 * Reclaims all retired objects, there must be no guards.
+	 **/
+	~EpochDomain();
+
+	uint64_t epoch() const
+	{ return global_epoch.load(std::memory_order_relaxed); }
+
+	/**
+	 * Number of retired but not yet reclaimed objects, there must be no
+	 * guards.
+	 **/
+	size_t retired() const;
+
+private:
+	friend class EpochGuard;
+
+	EpochDomain(EpochDomain const &);
+	EpochDomain &operator=(EpochDomain const &);
+
+	static size_t const slot_count = 64;
+	static size_t const collect_threshold = 64;
+
+	/* padded to a cache line, slots are written on every operation */
+	struct Slot {
+		std::atomic<bool> busy;
+		std::atomic<uint64_t> epoch;
+		EpochNode *retired;
+		size_t count;
+		size_t collect_at;
+		char pad[64 - 2 * sizeof(uint64_t) - 3 * sizeof(void *)];
+	};
+
+	Slot *enter();
+	void leave(Slot *slot);
+	void retire(Slot *slot, EpochNode *node);
+	void collect(Slot *slot);
+	void try_advance();
+	size_t reclaim_list(EpochNode *list);
+
+	std::atomic<uint64_t> global_epoch;
+	EpochReclaim const reclaim;
+	void *const ctx;
+	Slot slots[slot_count];
+};
+
+class EpochGuard {
+public:
+	explicit EpochGuard(EpochDomain &domain)
+	: domain(domain), slot(domain.enter())
+	{ }
+
+	~EpochGuard()
+	{ domain.leave(slot); }
+
+	/**
+	 * Object must be unlinked already, it's reclaimed when no guard can
+	 * see it.
+	 **/
+	void retire(EpochNode *node)
+	{ domain.retire(slot, node); }
+
+private:
+	EpochGuard(EpochGuard const &);
+	EpochGuard &operator=(EpochGuard const &);
+
+	EpochDomain &domain;
+	EpochDomain::Slot *const slot;
+};
+
+#endif /*__EPOCH_HPP__*/
@@ -0,0 +1,502 @@
+#ifndef __SKIP_LIST_HPP__
+#define __SKIP_LIST_HPP__
+
+#include "epoch.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * A node gets one more level with probability 1/4: fewer links per node
+ * than with 1/2 for about the same number of steps, and max height levels
+ * are enough for 4^max_height elements.
+ **/
+size_t const skip_list_max_height = 20;
+
+/**
+ * Links keep the deletion mark in the lowest bit: links of a node being
+ * erased are marked and a marked link can't be changed, so nothing gets
+ * linked after an erased node while it's unlinked.
+ **/
+typedef std::atomic<uintptr_t> SkipListLink;
+
+/**
+ * Links (height of them) follow the node in the same allocation. Both the
+ * inserter building the upper levels and the eraser unlinking the node
+ * may touch its links after the node was erased, owners counts them and
+ * the last one retires the node.
+ **/
+template <typename Val>
+struct SkipListNode : public EpochNode {
+	typename std::aligned_storage<sizeof(Val), alignof(Val)>::type storage;
+	std::atomic<unsigned> owners;
+	unsigned height;
+
+	SkipListNode(unsigned height)
+	: EpochNode(), owners(2), height(height)
+	{ }
+
+	Val &value()
+	{ return *reinterpret_cast<Val *>(&storage); }
+
+	Val const &value() const
+	{ return *reinterpret_cast<Val const *>(&storage); }
+
+	SkipListLink *links()
+	{ return reinterpret_cast<SkipListLink *>(this + 1); }
+
+	SkipListLink const *links() const
+	{ return reinterpret_cast<SkipListLink const *>(this + 1); }
+};
+
+/**
+ * Lock-free ordered map: a skip list with Harris style marked links, so
+ * insert, erase and lookups never wait for each other. Unlinked nodes are
+ * reclaimed through an EpochDomain, so readers never look at freed memory.
+ *
+ * Template parameters are the ones of BinarySearchTree (no Balance: a skip
+ * list is balanced by random heights), but keys are unique and there are
+ * no iterators: concurrent erase would invalidate them. Lookups copy the
+ * value out or call a function on it (values must not be changed), emplace
+ * returns false if the key is already there. for_each and size are weakly
+ * consistent: they may or may not see concurrent changes.
+ *
+ * The allocator must be thread safe: nodes are allocated and freed by
+ * whatever thread inserts or reclaims them.
+ **/
+template <typename Key, typename Val, typename KeyOf, typename KeyCmp,
+	typename Allocator = std::allocator<Val>>
+class SkipList {
+	using Self = SkipList<Key, Val, KeyOf, KeyCmp, Allocator>;
+	using Node = SkipListNode<Val>;
+	using Unit = typename std::aligned_storage<alignof(Node),
+				alignof(Node)>::type;
+	using ValueAllocTrait = std::allocator_traits<Allocator>;
+	using UnitAlloc = typename
+		ValueAllocTrait::template rebind_alloc<Unit>;
+	using UnitAllocTrait = std::allocator_traits<UnitAlloc>;
+
+	static size_t const max_height = skip_list_max_height;
+
+	static_assert(sizeof(Node) % alignof(SkipListLink) == 0,
+			"links must be aligned");
+
+	struct Impl : public UnitAlloc {
+		SkipListLink head[max_height];
+		std::atomic<ptrdiff_t> size;
+		KeyCmp cmp;
+
+		Impl(KeyCmp const &cmp, UnitAlloc const &a)
+		: UnitAlloc(a), size(0), cmp(cmp)
+		{
+			for (size_t level = 0; level != max_height; ++level)
+				head[level].store(0, std::memory_order_relaxed);
+		}
+	};
+
+	/**
+	 * preds[level] is the link to change to insert before succs[level].
+	 **/
+	struct Position {
+		SkipListLink *preds[max_height];
+		Node *succs[max_height];
+	};
+
+public:
+	using key_type = Key;
+	using value_type = Val;
+	using size_type = size_t;
+
+	explicit SkipList(KeyCmp const &cmp = KeyCmp(),
+				Allocator const &a = Allocator())
+	: impl(cmp, UnitAlloc(a)), domain(&reclaim, this)
+	{ }
+
+	explicit SkipList(Allocator const &a)
+	: impl(KeyCmp(), UnitAlloc(a)), domain(&reclaim, this)
+	{ }
+
+	SkipList(Self const &) = delete;
+	Self &operator=(Self const &) = delete;
+
+	/* there must be no concurrent operations */
+	~SkipList()
+	{
+		Node *node = node_of(impl.head[0].load());
+
+		while (node) {
+			Node *next = node_of(node->links()[0].load());
+
+			destroy_node(node);
+			node = next;
+		}
+	}
+
+	/* erase of a new element may count before its insert does */
+	size_t size() const
+	{
+		ptrdiff_t const size =
+			impl.size.load(std::memory_order_relaxed);
+
+		return size < 0 ? 0 : static_cast<size_t>(size);
+	}
+
+	bool empty() const
+	{ return !size(); }
+
+	/**
+	 * Calls f(value) for the element with key, returns false if there is
+	 * no such element.
+	 **/
+	template <typename F>
+	bool visit(Key const &key, F f) const
+	{
+		EpochGuard guard(domain);
+		Node const *node = search(key);
+
+		if (!node || impl.cmp(key, key_of(node->value())))
+			return false;
+		f(node->value());
+		return true;
+	}
+
+	bool find(Key const &key, Val &val) const
+	{ return visit(key, [&val] (Val const &v) { val = v; }); }
+
+	bool contains(Key const &key) const
+	{ return visit(key, [] (Val const &) { }); }
+
+	/**
+	 * Copies the first element with a key not less than key to val,
+	 * returns false if there is no such element.
+	 **/
+	bool lower_bound(Key const &key, Val &val) const
+	{
+		EpochGuard guard(domain);
+		Node const *node = search(key);
+
+		if (!node)
+			return false;
+		val = node->value();
+		return true;
+	}
+
+	/**
+	 * Calls f(value) for every element in order.
+	 **/
+	template <typename F>
+	void for_each(F f) const
+	{
+		EpochGuard guard(domain);
+		Node const *node = node_of(impl.head[0].load());
+
+		while (node) {
+			uintptr_t const next = node->links()[0].load();
+
+			if (!marked(next))
+				f(node->value());
+			node = node_of(next);
+		}
+	}
+
+	bool insert(Val const &x)
+	{ return emplace(x); }
+
+	bool insert(Val &&x)
+	{ return emplace(std::move(x)); }
+
+	template <typename ... Args>
+	bool emplace(Args && ... args)
+	{
+		Node *node = create_node(random_height(),
+					std::forward<Args>(args)...);
+		Key const &key = key_of(node->value());
+		SkipListLink *const links = node->links();
+		EpochGuard guard(domain);
+		Position pos;
+
+		for (;;) {
+			if (locate(key, pos)) {
+				destroy_node(node);
+				return false;
+			}
+
+			for (size_t level = 0; level != node->height; ++level)
+				links[level].store(link_to(pos.succs[level]),
+						std::memory_order_relaxed);
+
+			uintptr_t expected = link_to(pos.succs[0]);
+			if (pos.preds[0]->compare_exchange_strong(expected,
+						link_to(node)))
+				break;
+		}
+		impl.size.fetch_add(1, std::memory_order_relaxed);
+
+		/* an eraser may have missed the levels linked after it
+		 * unlinked the node */
+		if (!build_tower(node, key, pos))
+			unlink(key);
+		release(node, guard);
+		return true;
+	}
+
+	/**
+	 * Erases the element with key, returns number of erased elements.
+	 **/
+	size_t erase(Key const &key)
+	{
+		EpochGuard guard(domain);
+		Position pos;
+
+		if (!locate(key, pos))
+			return 0;
+
+		Node *node = pos.succs[0];
+		SkipListLink *const links = node->links();
+
+		/* top down, so the node is the last to be seen at level 0 */
+		for (size_t level = node->height; level-- > 1; )
+			links[level].fetch_or(1);
+
+		/* the one who marks level 0 erased the element */
+		if (marked(links[0].fetch_or(1)))
+			return 0;
+		impl.size.fetch_sub(1, std::memory_order_relaxed);
+
+		unlink(key);
+		release(node, guard);
+		return 1;
+	}
+
+	EpochDomain const &epoch_domain() const
+	{ return domain; }
+
+private:
+	static Key const &key_of(Val const &x)
+	{ return KeyOf()(x); }
+
+	static bool marked(uintptr_t link)
+	{ return link & 1; }
+
+	static Node *node_of(uintptr_t link)
+	{ return reinterpret_cast<Node *>(link & ~static_cast<uintptr_t>(1)); }
+
+	static uintptr_t link_to(Node *node)
+	{ return reinterpret_cast<uintptr_t>(node); }
+
+	/* xorshift, seeded with the address of the thread local state */
+	static unsigned random_height()
+	{
+		static thread_local uint64_t state = 0;
+		unsigned height = 1;
+
+		if (!state)
+			state = (reinterpret_cast<uintptr_t>(&state) | 1)
+				* 0x9e3779b97f4a7c15ull;
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+
+		for (uint64_t bits = state; !(bits & 3) && height < max_height;
+					bits >>= 2)
+			++height;
+		return height;
+	}
+
+	static size_t node_units(unsigned height)
+	{
+		return (sizeof(Node) + height * sizeof(SkipListLink)
+			+ sizeof(Unit) - 1) / sizeof(Unit);
+	}
+
+	template <typename ... Args>
+	Node *create_node(unsigned height, Args && ... args)
+	{
+		Unit *memory = UnitAllocTrait::allocate(impl,
+					node_units(height));
+		Node *node = ::new (static_cast<void *>(memory)) Node(height);
+
+		try {
+			UnitAllocTrait::construct(impl, &node->value(),
+					std::forward<Args>(args)...);
+		} catch (...) {
+			node->~Node();
+			UnitAllocTrait::deallocate(impl, memory,
+					node_units(height));
+			throw;
+		}
+
+		for (size_t level = 0; level != height; ++level)
+			::new (static_cast<void *>(node->links() + level))
+				SkipListLink(0);
+		return node;
+	}
+
+	void destroy_node(Node *node)
+	{
+		size_t const units = node_units(node->height);
+
+		UnitAllocTrait::destroy(impl, &node->value());
+		node->~Node();
+		UnitAllocTrait::deallocate(impl, reinterpret_cast<Unit *>(node),
+					units);
+	}
+
+	static void reclaim(EpochNode *node, void *ctx)
+	{ static_cast<Self *>(ctx)->destroy_node(static_cast<Node *>(node)); }
+
+	void release(Node *node, EpochGuard &guard)
+	{
+		if (node->owners.fetch_sub(1) == 1)
+			guard.retire(node);
+	}
+
+	/**
+	 * First element with a key not less than key that isn't erased, or
+	 * null. Readers skip erased nodes but leave unlinking to writers.
+	 **/
+	Node const *search(Key const &key) const
+	{
+		SkipListLink const *pred = impl.head;
+		Node const *node = 0;
+
+		for (size_t level = max_height; level-- != 0; ) {
+			node = node_of(pred[level].load());
+
+			while (node) {
+				uintptr_t const next =
+					node->links()[level].load();
+
+				if (!marked(next) && !impl.cmp(
+						key_of(node->value()), key))
+					break;
+				if (!marked(next))
+					pred = node->links();
+				node = node_of(next);
+			}
+		}
+		return node;
+	}
+
+	/**
+	 * Fills pos for key unlinking erased nodes on the way, returns true
+	 * if there is an element with key. Starts over if a link changes
+	 * under it.
+	 **/
+	bool locate(Key const &key, Position &pos)
+	{
+		while (!try_locate<false>(key, pos))
+			;
+
+		Node const *node = pos.succs[0];
+
+		return node && !impl.cmp(key, key_of(node->value()));
+	}
+
+	/* a walk stops at the first node not before key, or after key */
+	template <bool PastEqual>
+	bool stops(Key const &key, Node const *node) const
+	{
+		Key const &other = key_of(node->value());
+
+		return PastEqual ? impl.cmp(key, other)
+				: !impl.cmp(other, key);
+	}
+
+	/**
+	 * Unlinks erased nodes with key from all levels. An insert of the
+	 * same key may have linked its node in front of the erased one at
+	 * some level (it got the position before the erased node was
+	 * marked), so unlink walks past all nodes with key, not just to the
+	 * first one.
+	 **/
+	void unlink(Key const &key)
+	{
+		Position pos;
+
+		while (!try_locate<true>(key, pos))
+			;
+	}
+
+	template <bool PastEqual>
+	bool try_locate(Key const &key, Position &pos)
+	{
+		SkipListLink *pred = impl.head;
+
+		for (size_t level = max_height; level-- != 0; ) {
+			uintptr_t link = pred[level].load();
+
+			if (marked(link))
+				return false;
+
+			Node *node = node_of(link);
+			while (node) {
+				uintptr_t const next =
+					node->links()[level].load();
+
+				if (marked(next)) {
+					SkipListLink &from = pred[level];
+
+					if (!from.compare_exchange_strong(link,
+								next - 1))
+						return false;
+					link = next - 1;
+					node = node_of(link);
+					continue;
+				}
+				if (stops<PastEqual>(key, node))
+					break;
+				pred = node->links();
+				link = next;
+				node = node_of(link);
+			}
+			pos.preds[level] = pred + level;
+			pos.succs[level] = node;
+		}
+		return true;
+	}
+
+	/**
+	 * Links the upper levels of a node already linked at level 0,
+	 * returns false if the node was erased meanwhile.
+	 **/
+	bool build_tower(Node *node, Key const &key, Position &pos)
+	{
+		SkipListLink *const links = node->links();
+
+		for (size_t level = 1; level < node->height; ++level) {
+			for (;;) {
+				uintptr_t next = links[level].load();
+				uintptr_t const succ =
+					link_to(pos.succs[level]);
+
+				/* fails only if the node was marked */
+				if (marked(next) || (next != succ
+						&& !links[level]
+						.compare_exchange_strong(
+							next, succ)))
+					return false;
+
+				uintptr_t expected = succ;
+				if (pos.preds[level]->compare_exchange_strong(
+						expected, link_to(node)))
+					break;
+
+				locate(key, pos);
+				if (pos.succs[0] != node)
+					return false;
+			}
+		}
+		return !marked(links[0].load());
+	}
+
+	Impl impl;
+	mutable EpochDomain domain;
+};
+
+#endif /*__SKIP_LIST_HPP__*/
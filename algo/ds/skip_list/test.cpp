@@ -0,0 +1,224 @@
+#include "skip_list.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+template <typename T>
+struct Id {
+	T const &operator()(T const &x) const
+	{ return x; }
+};
+
+/**
+ * Not trivial and counted: a value read after it was reclaimed doesn't
+ * match its key, and lost or doubled values show up in the count.
+ **/
+struct Entry {
+	static std::atomic<long> live;
+
+	int key;
+	std::string text;
+
+	Entry(int key = 0)
+	: key(key), text(std::to_string(key))
+	{ text.resize(40, '.'); ++live; }
+
+	Entry(Entry const &other)
+	: key(other.key), text(other.text)
+	{ ++live; }
+
+	Entry &operator=(Entry const &other)
+	{
+		key = other.key;
+		text = other.text;
+		return *this;
+	}
+
+	~Entry()
+	{ --live; }
+
+	bool valid() const
+	{ return text == Entry(key).text; }
+};
+
+std::atomic<long> Entry::live(0);
+
+struct EntryKey {
+	int const &operator()(Entry const &x) const
+	{ return x.key; }
+};
+
+using IntList = SkipList<int, int, Id<int>, std::less<int>>;
+using EntryList = SkipList<int, Entry, EntryKey, std::less<int>>;
+
+void check_list(IntList const &list, std::set<int> const &check)
+{
+	std::vector<int> values;
+
+	list.for_each([&values] (int x) { values.push_back(x); });
+	assert(list.size() == check.size());
+	assert(list.empty() == check.empty());
+	assert(values.size() == check.size());
+	assert(std::equal(check.begin(), check.end(), values.begin()));
+}
+
+void run_serial_test(size_t size)
+{
+	int const keys = static_cast<int>(size + 1);
+	IntList list;
+	std::set<int> check;
+
+	for (size_t i = 0; i != size; ++i) {
+		int const key = rand() % keys;
+
+		assert(list.insert(key) == check.insert(key).second);
+	}
+	check_list(list, check);
+
+	for (int key = -1; key <= keys; ++key) {
+		std::set<int>::iterator it = check.lower_bound(key);
+		int val = -1;
+
+		assert(list.contains(key) == (check.count(key) != 0));
+		assert(list.find(key, val) == (check.count(key) != 0));
+		assert(!check.count(key) || val == key);
+		assert(list.lower_bound(key, val) == (it != check.end()));
+		assert(it == check.end() || val == *it);
+	}
+
+	for (size_t i = 0; i != size; ++i) {
+		int const key = rand() % keys;
+
+		if (rand() % 2)
+			assert(list.erase(key) == check.erase(key));
+		else
+			assert(list.emplace(key) == check.insert(key).second);
+	}
+	check_list(list, check);
+
+	while (!check.empty()) {
+		assert(list.erase(*check.begin()) == 1);
+		check.erase(check.begin());
+	}
+	check_list(list, check);
+}
+
+/**
+ * Retired nodes are reclaimed as the list goes, not only when it's gone.
+ **/
+void run_reclaim_test(size_t size)
+{
+	{
+		EntryList list;
+
+		for (size_t round = 0; round != 10; ++round) {
+			for (size_t i = 0; i != size; ++i)
+				assert(list.emplace(static_cast<int>(i)));
+			for (size_t i = 0; i != size; ++i)
+				assert(list.erase(static_cast<int>(i)) == 1);
+		}
+		assert(list.empty());
+		assert(list.epoch_domain().retired() < 1000);
+		assert(Entry::live < 1000);
+
+		for (size_t i = 0; i != size; ++i)
+			list.emplace(static_cast<int>(i));
+	}
+	assert(Entry::live == 0);
+}
+
+/**
+ * Threads insert, erase and look up keys of a small range, so they keep
+ * racing for the same nodes. Every thread counts its successful inserts
+ * and erases of every key: in the end a key is in the list iff it was
+ * inserted once more than erased.
+ **/
+void run_stress_test(size_t threads, int keys, size_t ops)
+{
+	{
+		EntryList list;
+		std::vector<std::vector<long>> counts(threads,
+					std::vector<long>(keys));
+		std::vector<std::thread> workers;
+
+		for (size_t t = 0; t != threads; ++t) {
+			workers.emplace_back([&list, &counts, t, keys, ops] {
+				std::mt19937 gen(static_cast<unsigned>(t));
+				std::vector<long> &count = counts[t];
+
+				for (size_t i = 0; i != ops; ++i) {
+					int const key = static_cast<int>(
+							gen() % keys);
+					Entry val;
+
+					switch (gen() % 4) {
+					case 0:
+						count[key] += list.emplace(key);
+						break;
+					case 1:
+						count[key] -= list.erase(key);
+						break;
+					case 2:
+						if (list.find(key, val))
+							assert(val.key == key
+							&& val.valid());
+						break;
+					default:
+						if (list.lower_bound(key, val))
+							assert(val.key >= key
+							&& val.valid());
+						break;
+					}
+				}
+			});
+		}
+		for (std::thread &worker : workers)
+			worker.join();
+
+		size_t expected = 0;
+		for (int key = 0; key != keys; ++key) {
+			long present = 0;
+
+			for (size_t t = 0; t != threads; ++t)
+				present += counts[t][key];
+			assert(present == 0 || present == 1);
+			assert(list.contains(key) == (present == 1));
+			expected += present;
+		}
+		assert(list.size() == expected);
+
+		int last = -1;
+		list.for_each([&last] (Entry const &x) {
+			assert(x.valid() && x.key > last);
+			last = x.key;
+		});
+	}
+	assert(Entry::live == 0);
+}
+
+int main()
+{
+	size_t const sizes[] = {0, 1, 2, 3, 10, 100, 1000, 10000};
+
+	for (size_t size : sizes)
+		run_serial_test(size);
+	run_reclaim_test(10000);
+
+	run_stress_test(2, 16, 200000);
+	run_stress_test(8, 16, 100000);
+	run_stress_test(8, 1000, 100000);
+	run_stress_test(32, 64, 20000);
+
+	std::cout << "test is successfully passed" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,109 @@
+#include "slab_allocator.hpp"
+
+#include "../linkedlist/linkedlist.hpp"
+#include "../simple-bst/bst.hpp"
+#include "../splay/splay_tree.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+template <typename T>
+struct Id {
+	T const &operator()(T const &x) const
+	{ return x; }
+};
+
+template <typename F>
+double measure(F f)
+{
+	auto const start = std::chrono::steady_clock::now();
+	f();
+	auto const stop = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double>(stop - start).count();
+}
+
+/**
+ * Queue churn: keep size elements in the list, pop one and push one.
+ **/
+template <typename Alloc>
+double list_churn(size_t size, size_t ops)
+{
+	LinkedList<int, Alloc> list;
+
+	for (size_t i = 0; i != size; ++i)
+		list.push_back(static_cast<int>(i));
+
+	return measure([&] {
+		for (size_t i = 0; i != ops; ++i) {
+			list.pop_front();
+			list.push_back(static_cast<int>(i));
+		}
+	});
+}
+
+/**
+ * Tree churn: keep size keys in the tree, erase the smallest one and insert
+ * a random one.
+ **/
+template <typename Alloc>
+double bst_churn(std::vector<int> const &keys, size_t ops)
+{
+	using Tree = BinarySearchTree<int, int, Id<int>, std::less<int>,
+				Alloc>;
+	Tree tree(keys.begin(), keys.end());
+
+	return measure([&] {
+		for (size_t i = 0; i != ops; ++i) {
+			tree.erase(tree.begin());
+			tree.insert(keys[i % keys.size()]);
+		}
+	});
+}
+
+template <typename Alloc>
+double splay_churn(std::vector<int> const &keys, size_t ops)
+{
+	using Tree = SplayTree<int, int, Id<int>, std::less<int>, Alloc>;
+	Tree tree(keys.begin(), keys.end());
+
+	return measure([&] {
+		for (size_t i = 0; i != ops; ++i) {
+			tree.erase(tree.begin());
+			tree.insert(keys[i % keys.size()]);
+		}
+	});
+}
+
+void report(char const *name, double std_time, double slab_time)
+{
+	std::cout << name << ": std::allocator " << std_time
+		<< "s, SlabAllocator " << slab_time << "s" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+	size_t const size = argc > 1 ? atol(argv[1]) : 100000;
+	size_t const ops = argc > 2 ? atol(argv[2]) : 1000000;
+
+	std::vector<int> keys;
+	for (size_t i = 0; i != size; ++i)
+		keys.push_back(rand());
+
+	std::cout << size << " elements, " << ops << " erase/insert pairs"
+		<< std::endl;
+
+	report("LinkedList",
+		list_churn<std::allocator<int>>(size, ops),
+		list_churn<SlabAllocator<int>>(size, ops));
+	report("BinarySearchTree",
+		bst_churn<std::allocator<int>>(keys, ops),
+		bst_churn<SlabAllocator<int>>(keys, ops));
+	report("SplayTree",
+		splay_churn<std::allocator<int>>(keys, ops),
+		splay_churn<SlabAllocator<int>>(keys, ops));
+
+	return 0;
+}
@@ -0,0 +1,173 @@
+#ifndef __SLAB_ALLOCATOR_HPP__
+#define __SLAB_ALLOCATOR_HPP__
+
+#include "slab_pool.hpp"
+
+#include <cstddef>
+#include <new>
+#if __cplusplus >= 201103L
+#include <utility>
+#endif
+
+/**
+ * Node allocator for SplayTree, BinarySearchTree and LinkedList. Single
+ * object allocations (that's all node containers ask for) are served from
+ * a SlabPool, everything else goes to operator new.
+ *
+ * Every default constructed allocator gets its own SlabArena, copies and
+ * rebinds share it, so containers don't share free lists with each other.
+ * With ReleaseWhenEmpty set a pool returns all its blocks to the system once
+ * its last chunk is freed, e. g. when container is cleared.
+ *
+ * Written in C++03 since SplayTree is C++03.
+ **/
+template <typename T, size_t ChunksPerBlock = 256,
+		bool ReleaseWhenEmpty = false>
+class SlabAllocator {
+	template <typename U, size_t N, bool R>
+	friend class SlabAllocator;
+
+public:
+	typedef T value_type;
+	typedef T *pointer;
+	typedef T const *const_pointer;
+	typedef T &reference;
+	typedef T const &const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	template <typename U>
+	struct rebind {
+		typedef SlabAllocator<U, ChunksPerBlock, ReleaseWhenEmpty> other;
+	};
+
+	SlabAllocator()
+	: m_arena(new SlabArena(ChunksPerBlock, ReleaseWhenEmpty))
+	, m_pool(0)
+	{ }
+
+	SlabAllocator(SlabAllocator const &other) throw()
+	: m_arena(other.m_arena)
+	, m_pool(other.m_pool)
+	{ m_arena->acquire(); }
+
+	template <typename U>
+	SlabAllocator(SlabAllocator<U, ChunksPerBlock, ReleaseWhenEmpty> const
+			&other) throw()
+	: m_arena(other.m_arena)
+	, m_pool(0)
+	{ m_arena->acquire(); }
+
+	~SlabAllocator()
+	{
+		if (m_arena->put())
+			delete m_arena;
+	}
+
+	SlabAllocator &operator=(SlabAllocator const &other)
+	{
+		SlabAllocator tmp(other);
+		swap(tmp);
+		return *this;
+	}
+
+	void swap(SlabAllocator &other) throw()
+	{
+		SlabArena *arena = m_arena;
+		SlabPool *pool = m_pool;
+
+		m_arena = other.m_arena;
+		m_pool = other.m_pool;
+		other.m_arena = arena;
+		other.m_pool = pool;
+	}
+
+	/**
+	 * Copy of a container gets its own arena.
+	 **/
+	SlabAllocator select_on_container_copy_construction() const
+	{ return SlabAllocator(); }
+
+	pointer address(reference x) const
+	{ return &x; }
+
+	const_pointer address(const_reference x) const
+	{ return &x; }
+
+	pointer allocate(size_type n, void const * = 0)
+	{
+		if (n != 1)
+			return static_cast<pointer>(
+					::operator new(n * sizeof(T)));
+
+		if (!m_pool)
+			m_pool = m_arena->pool(sizeof(T));
+
+		return static_cast<pointer>(m_pool->allocate());
+	}
+
+	void deallocate(pointer ptr, size_type n)
+	{
+		if (n != 1) {
+			::operator delete(ptr);
+			return;
+		}
+
+		if (!m_pool)
+			m_pool = m_arena->pool(sizeof(T));
+
+		m_pool->deallocate(ptr);
+	}
+
+	/**
+	 * Preallocates memory for n more single object allocations, node
+	 * containers call it from their reserve.
+	 **/
+	void reserve(size_type n)
+	{
+		if (!m_pool)
+			m_pool = m_arena->pool(sizeof(T));
+
+		m_pool->reserve(n);
+	}
+
+	size_type max_size() const throw()
+	{ return size_type(-1) / sizeof(T); }
+
+#if __cplusplus >= 201103L
+	template <typename U, typename ... Args>
+	void construct(U *ptr, Args && ... args)
+	{ ::new (static_cast<void *>(ptr)) U(std::forward<Args>(args)...); }
+
+	template <typename U>
+	void destroy(U *ptr)
+	{ ptr->~U(); }
+#else
+	void construct(pointer ptr, const_reference x)
+	{ ::new (static_cast<void *>(ptr)) T(x); }
+
+	void destroy(pointer ptr)
+	{ ptr->~T(); }
+#endif
+
+	template <typename U>
+	bool operator==(SlabAllocator<U, ChunksPerBlock, ReleaseWhenEmpty> const
+			&other) const throw()
+	{ return m_arena == other.m_arena; }
+
+	template <typename U>
+	bool operator!=(SlabAllocator<U, ChunksPerBlock, ReleaseWhenEmpty> const
+			&other) const throw()
+	{ return m_arena != other.m_arena; }
+
+private:
+	SlabArena *m_arena;
+	SlabPool *m_pool;
+};
+
+template <typename T, size_t N, bool R>
+inline void swap(SlabAllocator<T, N, R> &lhs, SlabAllocator<T, N, R> &rhs)
+			throw()
+{ lhs.swap(rhs); }
+
+#endif /*__SLAB_ALLOCATOR_HPP__*/
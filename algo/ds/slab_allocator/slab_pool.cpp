@@ -0,0 +1,153 @@
+#include "slab_pool.hpp"
+
+#include <cassert>
+#include <new>
+
+namespace
+{
+	/**
+	 * operator new returns memory suitably aligned for any fundamental
+	 * type, chunk and block header sizes are rounded up to keep chunks
+	 * aligned too.
+	 **/
+	size_t const slab_alignment = 2 * sizeof(void *);
+
+	size_t align_up(size_t size)
+	{ return (size + slab_alignment - 1) & ~(slab_alignment - 1); }
+}
+
+size_t SlabPool::round_size(size_t chunk_size)
+{ return align_up(chunk_size < sizeof(Chunk) ? sizeof(Chunk) : chunk_size); }
+
+SlabPool::SlabPool(size_t chunk_size, size_t chunks_per_block,
+			bool release_when_empty)
+: next(0)
+, m_chunk_size(round_size(chunk_size))
+, m_chunks_per_block(chunks_per_block ? chunks_per_block : 1)
+, m_release_when_empty(release_when_empty)
+, m_free(0)
+, m_blocks(0)
+, m_carve(0)
+, m_carve_end(0)
+, m_live(0)
+{ }
+
+SlabPool::~SlabPool()
+{ release(); }
+
+void SlabPool::add_block(size_t chunks)
+{
+	size_t const header = align_up(sizeof(Block));
+	char *memory = static_cast<char *>(::operator new(
+				header + m_chunk_size * chunks));
+	Block *block = reinterpret_cast<Block *>(memory);
+
+	block->next = m_blocks;
+	m_blocks = block;
+	m_carve = memory + header;
+	m_carve_end = m_carve + m_chunk_size * chunks;
+}
+
+void SlabPool::reserve(size_t chunks)
+{
+	size_t avail = static_cast<size_t>(m_carve_end - m_carve)
+			/ m_chunk_size;
+
+	for (Chunk *chunk = m_free; chunk && avail < chunks;
+			chunk = chunk->next)
+		++avail;
+
+	if (avail >= chunks)
+		return;
+
+	/* the rest of the current block goes to the free list, so it isn't
+	 * lost when the new block replaces it */
+	while (m_carve != m_carve_end) {
+		Chunk *chunk = reinterpret_cast<Chunk *>(m_carve);
+
+		chunk->next = m_free;
+		m_free = chunk;
+		m_carve += m_chunk_size;
+	}
+
+	chunks -= avail;
+	add_block(chunks < m_chunks_per_block ? m_chunks_per_block : chunks);
+}
+
+void *SlabPool::allocate()
+{
+	void *ptr;
+
+	if (m_free) {
+		ptr = m_free;
+		m_free = m_free->next;
+	} else {
+		if (m_carve == m_carve_end)
+			add_block(m_chunks_per_block);
+		ptr = m_carve;
+		m_carve += m_chunk_size;
+	}
+
+	++m_live;
+	return ptr;
+}
+
+void SlabPool::deallocate(void *ptr)
+{
+	Chunk *chunk = static_cast<Chunk *>(ptr);
+
+	chunk->next = m_free;
+	m_free = chunk;
+
+	if (--m_live == 0 && m_release_when_empty)
+		release();
+}
+
+void SlabPool::release()
+{
+	assert(m_live == 0);
+
+	while (m_blocks) {
+		Block *block = m_blocks;
+		m_blocks = block->next;
+		::operator delete(block);
+	}
+
+	m_free = 0;
+	m_carve = m_carve_end = 0;
+}
+
+
+SlabArena::SlabArena(size_t chunks_per_block, bool release_when_empty)
+: m_chunks_per_block(chunks_per_block)
+, m_release_when_empty(release_when_empty)
+, m_pools(0)
+, m_refs(1)
+{ }
+
+SlabArena::~SlabArena()
+{
+	while (m_pools) {
+		SlabPool *pool = m_pools;
+		m_pools = pool->next;
+		delete pool;
+	}
+}
+
+SlabPool *SlabArena::pool(size_t chunk_size)
+{
+	size_t const size = SlabPool::round_size(chunk_size);
+	SlabPool **link = &m_pools;
+
+	while (*link && (*link)->chunk_size() < size)
+		link = &(*link)->next;
+
+	if (*link && (*link)->chunk_size() == size)
+		return *link;
+
+	SlabPool *pool = new SlabPool(size, m_chunks_per_block,
+				m_release_when_empty);
+	pool->next = *link;
+	*link = pool;
+	return pool;
+}
@@ -0,0 +1,100 @@
+#ifndef __SLAB_POOL_HPP__
+#define __SLAB_POOL_HPP__
+
+#include <cstddef>
+
+/**
+ * Pool of fixed size chunks carved from big blocks. Freed chunks go to an
+ * intrusive free list and are reused first, fresh blocks are carved lazily
+ * so a new block isn't touched until its chunks are actually used.
+ *
+ * Note: this part is extracted from SlabAllocator template, so all
+ * allocators of the same chunk size share the code.
+ **/
+class SlabPool {
+public:
+	SlabPool(size_t chunk_size, size_t chunks_per_block,
+			bool release_when_empty);
+	~SlabPool();
+
+	void *allocate();
+	void deallocate(void *ptr);
+
+	/**
+	 * Makes sure the next chunks allocations are served without asking
+	 * the system for memory, missing chunks are taken in one block.
+	 **/
+	void reserve(size_t chunks);
+
+	/**
+	 * Returns all blocks to the system, there must be no live chunks.
+	 **/
+	void release();
+
+	/**
+	 * Chunk size actually used for requested chunk_size.
+	 **/
+	static size_t round_size(size_t chunk_size);
+
+	size_t chunk_size() const
+	{ return m_chunk_size; }
+
+	size_t live() const
+	{ return m_live; }
+
+	SlabPool *next;
+
+private:
+	SlabPool(SlabPool const &);
+	SlabPool &operator=(SlabPool const &);
+
+	struct Chunk {
+		Chunk *next;
+	};
+
+	struct Block {
+		Block *next;
+	};
+
+	void add_block(size_t chunks);
+
+	size_t const m_chunk_size;
+	size_t const m_chunks_per_block;
+	bool const m_release_when_empty;
+
+	Chunk *m_free;
+	Block *m_blocks;
+	char *m_carve;
+	char *m_carve_end;
+	size_t m_live;
+};
+
+/**
+ * Reference counted set of pools shared by an allocator and all its copies
+ * and rebinds, one pool per chunk size.
+ **/
+class SlabArena {
+public:
+	SlabArena(size_t chunks_per_block, bool release_when_empty);
+	~SlabArena();
+
+	SlabPool *pool(size_t chunk_size);
+
+	void acquire()
+	{ ++m_refs; }
+
+	bool put()
+	{ return --m_refs == 0; }
+
+private:
+	SlabArena(SlabArena const &);
+	SlabArena &operator=(SlabArena const &);
+
+	size_t const m_chunks_per_block;
+	bool const m_release_when_empty;
+
+	SlabPool *m_pools;
+	size_t m_refs;
+};
+
+#endif /*__SLAB_POOL_HPP__*/
@@ -0,0 +1,199 @@
+#include "slab_allocator.hpp"
+
+#include "../linkedlist/linkedlist.hpp"
+#include "../simple-bst/bst.hpp"
+#include "../splay/splay_tree.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <iterator>
+#include <list>
+#include <string>
+#include <vector>
+
+template <typename Ct>
+void fill_random(Ct &ct, size_t size)
+{ generate_n(std::back_inserter(ct), size, &rand); }
+
+template <typename T>
+struct Id {
+	T const &operator()(T const &x) const
+	{ return x; }
+};
+
+void run_pool_test(size_t size)
+{
+	SlabPool pool(sizeof(int), 16, true);
+	std::vector<void *> chunks;
+
+	for (size_t i = 0; i != size; ++i)
+		chunks.push_back(pool.allocate());
+	assert(pool.live() == size);
+
+	std::sort(chunks.begin(), chunks.end());
+	assert(std::adjacent_find(chunks.begin(), chunks.end())
+				== chunks.end());
+
+	for (size_t i = 0; i != size; ++i)
+		pool.deallocate(chunks[i]);
+	assert(pool.live() == 0);
+}
+
+void run_reserve_test(size_t size)
+{
+	SlabPool pool(sizeof(int), 16, false);
+	size_t const chunk = SlabPool::round_size(sizeof(int));
+	std::vector<char *> chunks;
+
+	/* reservation of a fresh pool is a single block */
+	pool.reserve(size);
+	for (size_t i = 0; i != size; ++i)
+		chunks.push_back(static_cast<char *>(pool.allocate()));
+
+	std::sort(chunks.begin(), chunks.end());
+	if (size)
+		assert(static_cast<size_t>(chunks.back() - chunks.front())
+					== (size - 1) * chunk);
+
+	for (size_t i = 0; i != size / 2; ++i)
+		pool.deallocate(chunks[i]);
+	pool.reserve(size);
+
+	std::vector<void *> more;
+	for (size_t i = 0; i != size + size / 2; ++i)
+		more.push_back(pool.allocate());
+	more.insert(more.end(), chunks.begin() + size / 2, chunks.end());
+
+	std::sort(more.begin(), more.end());
+	assert(std::adjacent_find(more.begin(), more.end()) == more.end());
+	assert(pool.live() == more.size());
+
+	for (size_t i = 0; i != more.size(); ++i)
+		pool.deallocate(more[i]);
+	assert(pool.live() == 0);
+}
+
+void run_allocator_test()
+{
+	SlabAllocator<int> a;
+	SlabAllocator<int> b;
+	SlabAllocator<int> c(a);
+	SlabAllocator<std::string> s(a);
+	SlabAllocator<std::string>::rebind<int>::other d(s);
+
+	assert(a != b);
+	assert(a == c);
+	assert(a == d);
+	assert(s == a);
+
+	int *x = a.allocate(1);
+	int *y = a.allocate(10);
+	c.deallocate(x, 1);
+	d.deallocate(y, 10);
+
+	b = a;
+	assert(a == b);
+}
+
+template <typename Alloc>
+void run_list_test(size_t size)
+{
+	std::vector<std::string> source;
+	for (size_t i = 0; i != size; ++i)
+		source.push_back(std::to_string(rand()));
+
+	LinkedList<std::string, Alloc> list(source.begin(), source.end());
+	LinkedList<std::string, Alloc> copy(list);
+	assert(std::equal(source.begin(), source.end(), copy.begin()));
+
+	for (size_t i = 0; i != size; ++i) {
+		list.pop_front();
+		list.push_back(source[i]);
+	}
+	assert(std::equal(source.begin(), source.end(), list.begin()));
+
+	list.clear();
+	assert(list.empty());
+	list.push_back("reused");
+	assert(list.size() == 1);
+}
+
+template <typename Alloc>
+void run_bst_test(size_t size)
+{
+	using Tree = BinarySearchTree<int, int, Id<int>, std::less<int>,
+				Alloc>;
+
+	std::vector<int> source;
+	fill_random(source, size);
+
+	Tree tree(source.begin(), source.end());
+	std::sort(source.begin(), source.end());
+	assert(std::equal(source.begin(), source.end(), tree.begin()));
+
+	tree.clear();
+	assert(tree.empty());
+	tree.reserve(size);
+	tree.insert(source.begin(), source.end());
+	assert(tree.size() == size);
+	assert(std::equal(source.begin(), source.end(), tree.begin()));
+
+	/**
+	 * Trees have different arenas, so values are moved to new nodes.
+	 **/
+	Tree other(source.begin(), source.end());
+	std::vector<int> merged;
+	std::merge(source.begin(), source.end(), source.begin(), source.end(),
+				std::back_inserter(merged));
+	tree.merge(other);
+	assert(other.empty());
+	assert(tree.size() == merged.size());
+	assert(std::equal(merged.begin(), merged.end(), tree.begin()));
+}
+
+template <typename Alloc>
+void run_splay_test(size_t size)
+{
+	using Tree = SplayTree<int, int, Id<int>, std::less<int>, Alloc>;
+
+	std::vector<int> source;
+	fill_random(source, size);
+
+	Tree tree(source.begin(), source.end());
+	std::sort(source.begin(), source.end());
+	assert(std::equal(source.begin(), source.end(), tree.begin()));
+
+	Tree copy(tree);
+	tree.erase(tree.begin(), tree.end());
+	assert(tree.size() == 0);
+	assert(std::equal(source.begin(), source.end(), copy.begin()));
+
+	/**
+	 * Trees have different arenas, so nodes must be copied.
+	 **/
+	int const pivot = source.empty() ? 0 : source[source.size() / 2];
+	copy.split(pivot, tree);
+	assert(copy.size() + tree.size() == source.size());
+	copy.join(tree);
+	assert(tree.size() == 0);
+	assert(std::equal(source.begin(), source.end(), copy.begin()));
+}
+
+int main()
+{
+	run_allocator_test();
+
+	for (size_t size : {0, 1, 10, 100, 1000, 10000}) {
+		run_pool_test(size);
+		run_reserve_test(size);
+		run_list_test<SlabAllocator<std::string>>(size);
+		run_list_test<SlabAllocator<std::string, 4, true>>(size);
+		run_bst_test<SlabAllocator<int>>(size);
+		run_bst_test<SlabAllocator<int, 4, true>>(size);
+		run_splay_test<SlabAllocator<int>>(size);
+		run_splay_test<SlabAllocator<int, 4, true>>(size);
+	}
+
+	return 0;
+}
@@ -0,0 +1,365 @@
+#include <algorithm>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+#include "splay_tree.hpp"
+#include "threaded_splay_tree.hpp"
+
+static size_t allocations = 0;
+
+void *operator new(size_t size) throw(std::bad_alloc)
+{
+	void *ptr = malloc(size ? size : 1);
+
+	if (!ptr)
+		throw std::bad_alloc();
+	++allocations;
+	return ptr;
+}
+
+void operator delete(void *ptr) throw()
+{
+	free(ptr);
+}
+
+template <typename T>
+struct Ident
+{
+	T const & operator()(T const & t) const
+	{ return t; }
+};
+
+typedef SplayTree<int, int, Ident<int>, std::less<int> > BottomUpTree;
+typedef SplayTree<int, int, Ident<int>, std::less<int>, std::allocator<int>,
+			TopDownSplay> TopDownTree;
+typedef ThreadedSplayTree<int, int, Ident<int>, std::less<int> > ThreadedTree;
+typedef SplayTree<int, int, Ident<int>, std::less<int>, std::allocator<int>,
+			OrderStatistics<> > CountedTree;
+
+/**
+ * Skewed workload: 90% of lookups hit 1% of keys.
+ **/
+std::vector<int> SkewedKeys(size_t keys, size_t lookups)
+{
+	size_t const hot = std::max(keys / 100, static_cast<size_t>(1));
+	std::vector<int> res;
+
+	res.reserve(lookups);
+	for (size_t i = 0; i != lookups; ++i)
+	{
+		if (rand() % 10)
+			res.push_back(static_cast<int>(rand() % hot));
+		else
+			res.push_back(static_cast<int>(rand() % keys));
+	}
+
+	return res;
+}
+
+template <typename Tree>
+double RunLookups(std::vector<int> const & keys,
+			std::vector<int> const & lookups, size_t & found)
+{
+	Tree tree(keys.begin(), keys.end());
+
+	clock_t const start = clock();
+	for (size_t i = 0; i != lookups.size(); ++i)
+		if (tree.find(lookups[i]) != tree.end())
+			++found;
+	clock_t const stop = clock();
+
+	return static_cast<double>(stop - start) / CLOCKS_PER_SEC;
+}
+
+/**
+ * Builds SplayTree from sorted keys inserting them one by one or as a vine
+ * turned into a balanced tree.
+ **/
+double RunBuild(std::vector<int> const & sorted, bool vine)
+{
+	BottomUpTree tree;
+
+	clock_t const start = clock();
+	if (vine)
+	{
+		BottomUpTree built(sorted_unique, sorted.begin(), sorted.end());
+		tree.swap(built);
+	}
+	else
+	{
+		for (size_t i = 0; i != sorted.size(); ++i)
+			tree.insert(sorted[i]);
+	}
+	clock_t const stop = clock();
+
+	return tree.size() == sorted.size()
+		? static_cast<double>(stop - start) / CLOCKS_PER_SEC : 0.0;
+}
+
+/**
+ * Copies SplayTree inserting its values one by one or cloning its shape.
+ **/
+double RunCopy(std::vector<int> const & keys, bool clone)
+{
+	BottomUpTree const tree(keys.begin(), keys.end());
+	BottomUpTree copy;
+
+	clock_t const start = clock();
+	if (clone)
+	{
+		BottomUpTree cloned(tree);
+		copy.swap(cloned);
+	}
+	else
+	{
+		for (BottomUpTree::const_iterator it = tree.begin();
+				it != tree.end(); ++it)
+			copy.insert(*it);
+	}
+	clock_t const stop = clock();
+
+	return copy.size() == tree.size()
+		? static_cast<double>(stop - start) / CLOCKS_PER_SEC : 0.0;
+}
+
+/**
+ * Erases every other element of a tree built by ascending inserts,
+ * walking back from its end.
+ **/
+template <typename Tree>
+double RunEraseEveryOther(size_t size)
+{
+	Tree tree;
+
+	for (size_t i = 0; i != size; ++i)
+		tree.insert(static_cast<int>(i));
+
+	clock_t const start = clock();
+	typename Tree::iterator it = tree.end();
+	for (size_t i = 0; i != size / 2; ++i)
+	{
+		--it;
+		it = tree.erase(--it);
+	}
+	clock_t const stop = clock();
+
+	return tree.size() == size - size / 2
+		? static_cast<double>(stop - start) / CLOCKS_PER_SEC : 0.0;
+}
+
+/**
+ * Nearly sorted stream: increasing keys with every 100th key swapped with
+ * a random one of the next 100.
+ **/
+std::vector<int> NearlySortedKeys(size_t keys)
+{
+	std::vector<int> res;
+
+	res.reserve(keys);
+	for (size_t i = 0; i != keys; ++i)
+		res.push_back(static_cast<int>(i));
+	for (size_t i = 0; i + 100 < keys; i += 100)
+		std::swap(res[i], res[i + 1 + rand() % 99]);
+
+	return res;
+}
+
+template <typename Tree>
+double RunInserts(std::vector<int> const & keys)
+{
+	Tree tree;
+
+	clock_t const start = clock();
+	for (size_t i = 0; i != keys.size(); ++i)
+		tree.insert(keys[i]);
+	clock_t const stop = clock();
+
+	return tree.size() == keys.size()
+		? static_cast<double>(stop - start) / CLOCKS_PER_SEC : 0.0;
+}
+
+double RunHintedInserts(std::vector<int> const & keys)
+{
+	BottomUpTree tree;
+
+	clock_t const start = clock();
+	for (size_t i = 0; i != keys.size(); ++i)
+		tree.insert(tree.end(), keys[i]);
+	clock_t const stop = clock();
+
+	return tree.size() == keys.size()
+		? static_cast<double>(stop - start) / CLOCKS_PER_SEC : 0.0;
+}
+
+/**
+ * Percentiles 1..99 by walking iterator from begin.
+ **/
+double RunWalkPercentiles(std::vector<int> const & keys, long & sum)
+{
+	BottomUpTree tree(keys.begin(), keys.end());
+
+	clock_t const start = clock();
+	for (size_t p = 1; p != 100; ++p)
+	{
+		BottomUpTree::iterator it = tree.begin();
+		std::advance(it, tree.size() * p / 100);
+		sum += *it;
+	}
+	clock_t const stop = clock();
+
+	return static_cast<double>(stop - start) / CLOCKS_PER_SEC;
+}
+
+/**
+ * Percentiles 1..99 using nth.
+ **/
+double RunNthPercentiles(std::vector<int> const & keys, long & sum)
+{
+	CountedTree tree(keys.begin(), keys.end());
+
+	clock_t const start = clock();
+	for (size_t p = 1; p != 100; ++p)
+		sum += *tree.nth(tree.size() * p / 100);
+	clock_t const stop = clock();
+
+	return static_cast<double>(stop - start) / CLOCKS_PER_SEC;
+}
+
+struct StringLess
+{
+	typedef void is_transparent;
+
+	bool operator()(std::string const & lhs, std::string const & rhs) const
+	{ return lhs < rhs; }
+
+	bool operator()(std::string const & lhs, char const * rhs) const
+	{ return lhs.compare(rhs) < 0; }
+
+	bool operator()(char const * lhs, std::string const & rhs) const
+	{ return rhs.compare(lhs) > 0; }
+};
+
+/**
+ * String keyed lookups by char const *: without transparent comparator
+ * every lookup constructs a std::string key. Returns allocations made by
+ * lookups.
+ **/
+template <typename Cmp>
+size_t RunStringLookups(std::vector<int> const & keys,
+			std::vector<int> const & lookups, double & time)
+{
+	typedef SplayTree<std::string, std::string, Ident<std::string>, Cmp>
+				StringTree;
+
+	std::vector<std::string> names(keys.size());
+	for (size_t i = 0; i != keys.size(); ++i)
+	{
+		char buf[32];
+		sprintf(buf, "session-key-%08d", keys[i]);
+		names[i] = buf;
+	}
+	StringTree tree(names.begin(), names.end());
+
+	std::vector<std::string> probes(lookups.size());
+	for (size_t i = 0; i != lookups.size(); ++i)
+	{
+		char buf[32];
+		sprintf(buf, "session-key-%08d", lookups[i]);
+		probes[i] = buf;
+	}
+
+	size_t found = 0;
+	size_t const before = allocations;
+	clock_t const start = clock();
+	for (size_t i = 0; i != probes.size(); ++i)
+		if (tree.find(probes[i].c_str()) != tree.end())
+			++found;
+	clock_t const stop = clock();
+
+	time = static_cast<double>(stop - start) / CLOCKS_PER_SEC;
+	return found == probes.size() ? allocations - before : 0;
+}
+
+int main(int argc, char **argv)
+{
+	size_t const keys = argc > 1 ? atol(argv[1]) : 1000000;
+	size_t const lookups = argc > 2 ? atol(argv[2]) : 10000000;
+
+	std::vector<int> input;
+	input.reserve(keys);
+	for (size_t i = 0; i != keys; ++i)
+		input.push_back(static_cast<int>(i));
+	std::random_shuffle(input.begin(), input.end());
+
+	std::vector<int> const probes = SkewedKeys(keys, lookups);
+
+	size_t bottom_up_found = 0;
+	size_t top_down_found = 0;
+	size_t threaded_found = 0;
+	double const bottom_up = RunLookups<BottomUpTree>(input, probes,
+				bottom_up_found);
+	double const top_down = RunLookups<TopDownTree>(input, probes,
+				top_down_found);
+	double const threaded = RunLookups<ThreadedTree>(input, probes,
+				threaded_found);
+
+	std::cout << keys << " keys, " << lookups << " skewed lookups"
+		<< std::endl;
+	std::cout << "bottom-up splay: " << bottom_up << "s" << std::endl;
+	std::cout << "top-down splay:  " << top_down << "s" << std::endl;
+	std::cout << "threaded splay:  " << threaded << "s" << std::endl;
+	std::vector<int> sorted(input);
+	std::sort(sorted.begin(), sorted.end());
+	std::cout << "sorted build, SplayTree insert per element: "
+		<< RunBuild(sorted, false) << "s" << std::endl;
+	std::cout << "sorted build, SplayTree from vine:          "
+		<< RunBuild(sorted, true) << "s" << std::endl;
+	std::cout << "copy, SplayTree insert per element: "
+		<< RunCopy(input, false) << "s" << std::endl;
+	std::cout << "copy, SplayTree structural clone:   "
+		<< RunCopy(input, true) << "s" << std::endl;
+	std::cout << "node size: " << sizeof(SplayNode<int>) << " vs "
+		<< sizeof(ThreadedSplayNode<int>) << " bytes" << std::endl;
+
+	std::vector<int> const nearly_sorted = NearlySortedKeys(keys);
+	std::cout << "nearly sorted inserts, ThreadedSplayTree: "
+		<< RunInserts<ThreadedTree>(nearly_sorted) << "s" << std::endl;
+	std::cout << "nearly sorted inserts, SplayTree:         "
+		<< RunInserts<BottomUpTree>(nearly_sorted) << "s" << std::endl;
+	std::cout << "nearly sorted inserts, SplayTree at end(): "
+		<< RunHintedInserts(nearly_sorted) << "s" << std::endl;
+
+	std::cout << "erase every other, ThreadedSplayTree: "
+		<< RunEraseEveryOther<ThreadedTree>(keys) << "s" << std::endl;
+	std::cout << "erase every other, SplayTree:         "
+		<< RunEraseEveryOther<BottomUpTree>(keys) << "s" << std::endl;
+
+	double plain_time = 0.0;
+	double transparent_time = 0.0;
+	size_t const plain_allocs = RunStringLookups< std::less<std::string> >(
+				input, probes, plain_time);
+	size_t const transparent_allocs = RunStringLookups<StringLess>(
+				input, probes, transparent_time);
+	std::cout << "string lookups by char const *, std::less<std::string>: "
+		<< plain_allocs << " allocations, " << plain_time << "s"
+		<< std::endl;
+	std::cout << "string lookups by char const *, transparent comparator: "
+		<< transparent_allocs << " allocations, " << transparent_time
+		<< "s" << std::endl;
+
+	long walk_sum = 0;
+	long nth_sum = 0;
+	std::cout << "percentiles, iterator walk: "
+		<< RunWalkPercentiles(input, walk_sum) << "s" << std::endl;
+	std::cout << "percentiles, nth:           "
+		<< RunNthPercentiles(input, nth_sum) << "s" << std::endl;
+
+	return bottom_up_found == top_down_found
+		&& top_down_found == threaded_found
+		&& walk_sum == nth_sum ? 0 : 1;
+}
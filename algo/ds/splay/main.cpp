@@ -1,8 +1,19 @@
+#include <algorithm>
 #include <iostream>
+#include <new>
 #include <string>
+#include <set>
+#include <vector>
 #include <cassert>
+#include <cstdlib>
+#include <cstdio>
+#if __cplusplus >= 201103L
+#include <memory>
+#include <utility>
+#endif
 
 #include "splay_tree.hpp"
+#include "threaded_splay_tree.hpp"
 
 template <typename T>
 struct Ident
@@ -12,15 +23,24 @@ struct Ident
 };
 
 typedef SplayTree<int, int, Ident<int>, std::less<int> > TreeType;
+typedef SplayTree<int, int, Ident<int>, std::less<int>, std::allocator<int>,
+			TopDownSplay> TopDownTreeType;
+typedef ThreadedSplayTree<int, int, Ident<int>, std::less<int> >
+			ThreadedTreeType;
+typedef SplayTree<int, int, Ident<int>, std::less<int>, std::allocator<int>,
+			OrderStatistics<> > CountedTreeType;
+typedef SplayTree<int, int, Ident<int>, std::less<int>, std::allocator<int>,
+			OrderStatistics<TopDownSplay> > CountedTopDownTreeType;
 
-int main()
+template <typename TreeType>
+void RunTest()
 {
 	TreeType tree;
 	assert(tree.begin() == tree.end());
 	assert(tree.rbegin() == tree.rend());
 	assert(tree.size() == 0);
 
-	std::pair<TreeType::iterator, bool> res1 = tree.insert_unique(5);
+	std::pair<typename TreeType::iterator, bool> res1 = tree.insert_unique(5);
 	assert(res1.second);
 	assert(res1.first == tree.begin());
 	assert(*res1.first == 5);
@@ -28,7 +48,7 @@ int main()
 	assert(res1.first == tree.end());
 	assert(tree.size() == 1);
 
-	std::pair<TreeType::iterator, bool> res2 = tree.insert_unique(4);
+	std::pair<typename TreeType::iterator, bool> res2 = tree.insert_unique(4);
 	assert(res2.second);
 	assert(res2.first == tree.begin());
 	assert(*res2.first == 4);
@@ -38,7 +58,7 @@ int main()
 	assert(res2.first == tree.end());
 	assert(tree.size() == 2);
 
-	std::pair<TreeType::iterator, bool> res3 = tree.insert_unique(3);
+	std::pair<typename TreeType::iterator, bool> res3 = tree.insert_unique(3);
 	assert(res3.second);
 	assert(res3.first == tree.begin());
 	assert(*res3.first == 3);
@@ -50,7 +70,7 @@ int main()
 	assert(res3.first == tree.end());
 	assert(tree.size() == 3);
 
-	std::pair<TreeType::iterator, bool> res4 = tree.insert_unique(4);
+	std::pair<typename TreeType::iterator, bool> res4 = tree.insert_unique(4);
 	assert(!res4.second);
 	assert(*res4.first == 4);
 	--res4.first;
@@ -63,7 +83,7 @@ int main()
 	assert(res4.first == tree.end());
 	assert(tree.size() == 3);
 
-	std::pair<TreeType::iterator, bool> res5 = tree.insert_unique(2);
+	std::pair<typename TreeType::iterator, bool> res5 = tree.insert_unique(2);
 	assert(res5.second);
 	assert(res5.first == tree.begin());
 	assert(*res5.first == 2);
@@ -86,7 +106,7 @@ int main()
 	assert(res5.first == tree.begin());
 	assert(tree.size() == 4);
 
-	TreeType::iterator it1 = tree.insert(1);
+	typename TreeType::iterator it1 = tree.insert(1);
 	assert(it1 == tree.begin());
 	assert(*it1 == 1);
 	++it1;
@@ -101,12 +121,12 @@ int main()
 	assert(it1 == tree.end());
 	assert(tree.size() == 5);
 
-	TreeType::iterator it2 = tree.insert(1);
+	typename TreeType::iterator it2 = tree.insert(1);
 	assert(*it2 == 1);
 	assert(it2 == tree.begin() || --it2 == tree.begin());
 	assert(tree.size() == 6);
 
-	std::pair<TreeType::iterator, TreeType::iterator> its = tree.equal_range(1);
+	std::pair<typename TreeType::iterator, typename TreeType::iterator> its = tree.equal_range(1);
 	assert(its.first != its.second);
 	assert(its.first == tree.begin());
 	assert(*its.first == 1);
@@ -118,24 +138,24 @@ int main()
 	assert(*its.first == 2);
 	assert(*its.second == 2);
 
-	TreeType::iterator it3 = tree.find(5);
+	typename TreeType::iterator it3 = tree.find(5);
 	assert(*it3 == 5);
 	++it3;
 	assert(it3 == tree.end());
 	--it3;
-	TreeType::iterator it4 = tree.erase(it3);
+	typename TreeType::iterator it4 = tree.erase(it3);
 	assert(tree.size() == 5);
 	assert(it4 == tree.end());
-	TreeType::iterator it5 = tree.find(5);
+	typename TreeType::iterator it5 = tree.find(5);
 	assert(it5 == tree.end());
 
-	std::pair<TreeType::iterator, TreeType::iterator> its2 = tree.equal_range(1);
-	TreeType::iterator it6 = tree.erase(its2.first, its2.second);
+	std::pair<typename TreeType::iterator, typename TreeType::iterator> its2 = tree.equal_range(1);
+	typename TreeType::iterator it6 = tree.erase(its2.first, its2.second);
 	assert(tree.size() == 3);
 	assert(it6 == its2.second);
 	assert(*it6 == 2);
 
-	TreeType::iterator it7 = tree.find(1);
+	typename TreeType::iterator it7 = tree.find(1);
 	assert(it7 == tree.end());
 
 	TreeType other = tree;
@@ -144,6 +164,601 @@ int main()
 	assert(other.size() == tree.size() + 1);
 	tree = other;
 	assert(other.size() == tree.size());
+	tree = tree;
+	assert(std::equal(other.begin(), other.end(), tree.begin()));
+
+	TreeType swapped;
+	swapped.swap(other);
+	assert(other.size() == 0 && other.begin() == other.end());
+	assert(std::equal(tree.begin(), tree.end(), swapped.begin()));
+	assert(std::equal(tree.rbegin(), tree.rend(), swapped.rbegin()));
+}
+
+template <typename TreeType>
+void RunRandomTest(size_t size)
+{
+	TreeType tree;
+	std::multiset<int> check;
+
+	for (size_t i = 0; i != size; ++i)
+	{
+		int const key = rand() % static_cast<int>(size);
+		tree.insert(key);
+		check.insert(key);
+	}
+	assert(tree.size() == check.size());
+	assert(std::equal(check.begin(), check.end(), tree.begin()));
+
+	for (size_t i = 0; i != size; ++i)
+	{
+		int const key = rand() % static_cast<int>(size);
+		typename TreeType::iterator it = tree.find(key);
+		if (check.find(key) == check.end())
+		{
+			assert(it == tree.end());
+		}
+		else
+		{
+			assert(it != tree.end() && *it == key);
+			tree.erase(it);
+			check.erase(check.find(key));
+		}
+	}
+	assert(tree.size() == check.size());
+	assert(std::equal(check.begin(), check.end(), tree.begin()));
+	assert(std::equal(check.rbegin(), check.rend(), tree.rbegin()));
+
+	tree.clear();
+	assert(tree.size() == 0 && tree.begin() == tree.end());
+	tree.insert(1);
+	assert(tree.size() == 1 && *tree.begin() == 1 && *tree.rbegin() == 1);
+}
+
+template <typename TreeType>
+void RunBuildTest(size_t size)
+{
+	std::vector<int> sorted;
+	for (size_t i = 0; i != size; ++i)
+		sorted.push_back(static_cast<int>(i / 2));
+
+	TreeType from_sorted(sorted.begin(), sorted.end());
+	assert(from_sorted.size() == sorted.size());
+	assert(std::equal(sorted.begin(), sorted.end(), from_sorted.begin()));
+
+	TreeType const & const_tree = from_sorted;
+	for (size_t i = 0; i != sorted.size(); ++i)
+		assert(*const_tree.find(sorted[i]) == sorted[i]);
+	assert(const_tree.find(-1) == const_tree.end());
+	assert(const_tree.find(static_cast<int>(size)) == const_tree.end());
+
+	TreeType tagged(sorted_unique, sorted.begin(), sorted.end());
+	assert(tagged.size() == sorted.size());
+	assert(std::equal(sorted.rbegin(), sorted.rend(), tagged.rbegin()));
+
+	std::vector<int> unsorted(sorted);
+	std::reverse(unsorted.begin() + unsorted.size() / 2, unsorted.end());
+	TreeType from_unsorted(unsorted.begin(), unsorted.end());
+	assert(from_unsorted.size() == sorted.size());
+	assert(std::equal(sorted.begin(), sorted.end(),
+				from_unsorted.begin()));
+
+	TreeType copy(from_unsorted);
+	assert(copy.size() == sorted.size());
+	assert(std::equal(sorted.begin(), sorted.end(), copy.begin()));
+	assert(std::equal(sorted.rbegin(), sorted.rend(), copy.rbegin()));
+
+	copy.insert(-1);
+	from_sorted = copy;
+	assert(from_sorted.size() == copy.size());
+	assert(std::equal(copy.begin(), copy.end(), from_sorted.begin()));
+	assert(*from_sorted.begin() == -1);
+
+	from_sorted.clear();
+	assert(from_sorted.size() == 0);
+	assert(from_sorted.begin() == from_sorted.end());
+	from_sorted.insert(sorted.begin(), sorted.end());
+	assert(std::equal(sorted.begin(), sorted.end(), from_sorted.begin()));
+}
+
+template <typename TreeType>
+void RunSplitJoinTest(size_t size)
+{
+	std::vector<int> keys;
+	for (size_t i = 0; i != size; ++i)
+		keys.push_back(rand() % static_cast<int>(size));
+
+	TreeType tree(keys.begin(), keys.end());
+	std::multiset<int> check(keys.begin(), keys.end());
+
+	int const lo = rand() % static_cast<int>(size);
+	int const hi = lo + rand() % static_cast<int>(size - lo + 1);
+
+	typename TreeType::iterator it = tree.erase(tree.lower_bound(lo),
+				tree.lower_bound(hi));
+	check.erase(check.lower_bound(lo), check.lower_bound(hi));
+	assert(it == tree.lower_bound(hi));
+	assert(tree.size() == check.size());
+	assert(std::equal(check.begin(), check.end(), tree.begin()));
+	assert(std::equal(check.rbegin(), check.rend(), tree.rbegin()));
+
+	int const pivot = rand() % static_cast<int>(size);
+	TreeType greater;
+	greater.insert(pivot);
+	tree.split(pivot, greater);
+	assert(tree.size() + greater.size() == check.size());
+	assert(std::equal(check.begin(), check.lower_bound(pivot),
+				tree.begin()));
+	assert(std::equal(check.lower_bound(pivot), check.end(),
+				greater.begin()));
+	assert(tree.end() == tree.lower_bound(pivot));
+
+	tree.join(greater);
+	assert(greater.size() == 0);
+	assert(greater.begin() == greater.end());
+	assert(tree.size() == check.size());
+	assert(std::equal(check.begin(), check.end(), tree.begin()));
+	assert(std::equal(check.rbegin(), check.rend(), tree.rbegin()));
+
+	TreeType other;
+	tree.swap(other);
+	assert(tree.size() == 0);
+	assert(std::equal(check.begin(), check.end(), other.begin()));
+
+	other.erase(other.begin(), other.end());
+	assert(other.size() == 0);
+	assert(other.begin() == other.end());
+}
+
+template <typename TreeType>
+void CheckOrder(TreeType & tree, std::multiset<int> const & check)
+{
+	std::vector<int> const sorted(check.begin(), check.end());
+	int const limit = sorted.empty() ? 1 : sorted.back() + 2;
+
+	assert(tree.size() == sorted.size());
+	for (size_t i = 0; i != sorted.size(); ++i)
+	{
+		size_t const k = static_cast<size_t>(rand()) % sorted.size();
+		assert(*tree.nth(k) == sorted[k]);
+	}
+	assert(tree.nth(sorted.size()) == tree.end());
+
+	for (int key = -1; key <= limit; ++key)
+	{
+		size_t const rank = std::lower_bound(sorted.begin(),
+					sorted.end(), key) - sorted.begin();
+		assert(tree.rank(key) == rank);
+	}
+}
+
+template <typename TreeType>
+void RunOrderTest(size_t size)
+{
+	std::vector<int> keys;
+	for (size_t i = 0; i != size; ++i)
+		keys.push_back(rand() % static_cast<int>(size));
+
+	std::multiset<int> check(keys.begin(), keys.end());
+	TreeType tree;
+	for (size_t i = 0; i != size; ++i)
+		tree.insert(keys[i]);
+	CheckOrder(tree, check);
+
+	TreeType built(keys.begin(), keys.end());
+	CheckOrder(built, check);
+
+	TreeType copy(built);
+	CheckOrder(copy, check);
+
+	for (size_t i = 0; i != size / 2; ++i)
+	{
+		int const key = rand() % static_cast<int>(size);
+		typename TreeType::iterator it = tree.find(key);
+		if (it != tree.end())
+		{
+			tree.erase(it);
+			check.erase(check.find(key));
+		}
+	}
+	CheckOrder(tree, check);
+
+	int const lo = rand() % static_cast<int>(size);
+	int const hi = lo + rand() % static_cast<int>(size - lo + 1);
+	tree.erase(tree.lower_bound(lo), tree.lower_bound(hi));
+	check.erase(check.lower_bound(lo), check.lower_bound(hi));
+	CheckOrder(tree, check);
+
+	int const pivot = rand() % static_cast<int>(size);
+	std::multiset<int> check_greater(check.lower_bound(pivot), check.end());
+	TreeType greater;
+	tree.split(pivot, greater);
+	check.erase(check.lower_bound(pivot), check.end());
+	CheckOrder(tree, check);
+	CheckOrder(greater, check_greater);
+
+	tree.join(greater);
+	check.insert(check_greater.begin(), check_greater.end());
+	CheckOrder(tree, check);
+
+	for (size_t i = 0; i != size; ++i)
+	{
+		int const key = rand() % static_cast<int>(size);
+		tree.insert(tree.lower_bound(key), key);
+		tree.insert(tree.begin(), key);
+		check.insert(key);
+		check.insert(key);
+	}
+	CheckOrder(tree, check);
+}
+
+template <typename TreeType>
+void RunHintTest(size_t size)
+{
+	TreeType tree;
+	std::multiset<int> check;
+
+	for (size_t i = 0; i != size; ++i)
+	{
+		tree.insert(static_cast<int>(i));
+		tree.insert(-static_cast<int>(i));
+		check.insert(static_cast<int>(i));
+		check.insert(-static_cast<int>(i));
+	}
+	for (size_t i = 0; i != size; ++i)
+	{
+		int const key = static_cast<int>(size + i / 2);
+		assert(*tree.insert(tree.end(), key) == key);
+		check.insert(check.end(), key);
+	}
+	assert(tree.size() == check.size());
+	assert(std::equal(check.begin(), check.end(), tree.begin()));
+	assert(std::equal(check.rbegin(), check.rend(), tree.rbegin()));
+
+	for (size_t i = 0; i != size; ++i)
+	{
+		int const key = rand() % static_cast<int>(3 * size)
+					- static_cast<int>(size);
+		typename TreeType::iterator hint;
+
+		switch (rand() % 4)
+		{
+		case 0:
+			hint = tree.lower_bound(key);
+			break;
+		case 1:
+			hint = tree.upper_bound(key);
+			break;
+		case 2:
+			hint = tree.begin();
+			break;
+		default:
+			hint = tree.end();
+			break;
+		}
+
+		assert(*tree.insert(hint, key) == key);
+		check.insert(key);
+	}
+	assert(tree.size() == check.size());
+	assert(std::equal(check.begin(), check.end(), tree.begin()));
+	assert(std::equal(check.rbegin(), check.rend(), tree.rbegin()));
+}
+
+template <typename Pair>
+struct Select1st
+{
+	typename Pair::first_type const & operator()(Pair const & p) const
+	{ return p.first; }
+};
+
+typedef std::pair<int, int> PairType;
+typedef SplayTree<int, PairType, Select1st<PairType>, std::less<int> >
+			PairTreeType;
+typedef ThreadedSplayTree<int, PairType, Select1st<PairType>,
+			std::less<int> > ThreadedPairTreeType;
+
+/**
+ * Erases elements at random positions of a tree with many equal keys,
+ * pairs tell apart elements with equal keys.
+ **/
+template <typename TreeType>
+void RunEraseTest(size_t size)
+{
+	TreeType tree;
+
+	for (size_t i = 0; i != size; ++i)
+		tree.insert(std::make_pair(rand() % 10, static_cast<int>(i)));
+
+	std::vector<typename TreeType::value_type> check(tree.begin(),
+				tree.end());
+	while (!check.empty())
+	{
+		size_t const pos = rand() % check.size();
+		typename TreeType::iterator it = tree.begin();
+
+		std::advance(it, pos);
+		it = tree.erase(it);
+		check.erase(check.begin() + pos);
+		assert(it == tree.end() || *it == check[pos]);
+		assert(tree.size() == check.size());
+		assert(std::equal(check.begin(), check.end(), tree.begin()));
+	}
+}
+
+struct CountingLess
+{
+	bool operator()(int lhs, int rhs) const
+	{
+		++s_calls;
+		return lhs < rhs;
+	}
+
+	static size_t s_calls;
+};
+
+size_t CountingLess::s_calls = 0;
+
+typedef ThreadedSplayTree<int, int, Ident<int>, CountingLess>
+			CountingThreadedTreeType;
+
+/**
+ * Returns comparisons made by erasing half of the elements at random
+ * positions from a tree built by ascending inserts of keys running from 0
+ * to keys - 1, each repeated size / keys times.
+ **/
+size_t EraseAtRandom(size_t size, size_t keys)
+{
+	CountingThreadedTreeType tree;
+
+	for (size_t i = 0; i != size; ++i)
+		tree.insert(static_cast<int>(i * keys / size));
+
+	size_t calls = 0;
+	for (size_t left = size; left != size / 2; --left)
+	{
+		CountingThreadedTreeType::iterator it = tree.begin();
+
+		std::advance(it, rand() % left);
+		CountingLess::s_calls = 0;
+		tree.erase(it);
+		calls += CountingLess::s_calls;
+	}
+	assert(tree.size() == size / 2);
+
+	return calls;
+}
+
+size_t Log2(size_t size)
+{
+	size_t res = 0;
+
+	for (; size > 1; size /= 2)
+		++res;
+	return res;
+}
+
+/**
+ * Ascending inserts leave a degenerate tree, erasing from it must stay
+ * amortized logarithmic. Erase splays by key, and top-down splay compares
+ * keys of the nodes it passes, so comparisons count the work; among equal
+ * keys erase must not compare them over and over.
+ **/
+void RunEraseCostTest()
+{
+	for (size_t size = 1000; size <= 16000; size *= 4)
+	{
+		/* distinct keys, runs of 16 equal keys and a single run */
+		size_t const keys[] = {size, size / 16, 1};
+
+		for (size_t i = 0; i != sizeof(keys) / sizeof(keys[0]); ++i)
+		{
+			size_t const calls = EraseAtRandom(size, keys[i]);
+
+			assert(calls <= 2 * size + 4 * (size / 2) * Log2(size));
+		}
+	}
+}
+
+/**
+ * Value which copy constructor throws once s_copies_left copies are made,
+ * negative s_copies_left never throws.
+ **/
+struct ThrowingValue
+{
+	explicit ThrowingValue(int key)
+		: m_key(key)
+	{ }
+
+	ThrowingValue(ThrowingValue const & other)
+		: m_key(other.m_key)
+	{
+		if (!s_copies_left)
+			throw std::bad_alloc();
+		if (s_copies_left > 0)
+			--s_copies_left;
+	}
+
+	static int s_copies_left;
+	int m_key;
+};
+
+int ThrowingValue::s_copies_left = -1;
+
+struct ThrowingKey
+{
+	int const & operator()(ThrowingValue const & v) const
+	{ return v.m_key; }
+};
+
+void RunAssignThrowTest()
+{
+	typedef ThreadedSplayTree<int, ThrowingValue, ThrowingKey,
+				std::less<int> > ThrowingTreeType;
+
+	ThrowingTreeType tree;
+	ThrowingTreeType other;
+	for (int i = 0; i != 10; ++i)
+	{
+		tree.insert(ThrowingValue(i));
+		other.insert(ThrowingValue(10 + i));
+	}
+
+	ThrowingValue::s_copies_left = 5;
+	try
+	{
+		tree = other;
+		assert(false);
+	}
+	catch (std::bad_alloc const &)
+	{ }
+	ThrowingValue::s_copies_left = -1;
+
+	assert(tree.size() == 10);
+	int key = 0;
+	for (ThrowingTreeType::iterator it = tree.begin(); it != tree.end();
+				++it)
+		assert((*it).m_key == key++);
+}
+
+struct StringLess
+{
+	typedef void is_transparent;
+
+	bool operator()(std::string const & lhs, std::string const & rhs) const
+	{ return lhs < rhs; }
+
+	bool operator()(std::string const & lhs, char const * rhs) const
+	{ return lhs.compare(rhs) < 0; }
+
+	bool operator()(char const * lhs, std::string const & rhs) const
+	{ return rhs.compare(lhs) > 0; }
+};
+
+template <typename Policy>
+void RunTransparentTest(size_t size)
+{
+	typedef SplayTree<std::string, std::string, Ident<std::string>,
+				StringLess, std::allocator<std::string>,
+				Policy> StringTreeType;
+
+	StringTreeType tree;
+	std::vector<std::string> keys;
+	for (size_t i = 0; i != size; ++i)
+	{
+		char buf[16];
+		sprintf(buf, "%06d", static_cast<int>(i * 2));
+		keys.push_back(buf);
+		tree.insert(keys.back());
+	}
+
+	StringTreeType const & const_tree = tree;
+	for (size_t i = 0; i != size; ++i)
+	{
+		char const *key = keys[i].c_str();
+		char odd[16];
+		sprintf(odd, "%06d", static_cast<int>(i * 2 + 1));
+
+		assert(*tree.find(key) == keys[i]);
+		assert(*const_tree.find(key) == keys[i]);
+		assert(tree.find(static_cast<char const *>(odd)) == tree.end());
+		assert(const_tree.find(static_cast<char const *>(odd))
+					== const_tree.end());
+		assert(*tree.lower_bound(key) == keys[i]);
+		assert(*const_tree.lower_bound(key) == keys[i]);
+		assert(tree.upper_bound(key) == tree.lower_bound(
+					static_cast<char const *>(odd)));
+		assert(tree.equal_range(key).first == tree.find(key));
+		assert(std::distance(tree.equal_range(key).first,
+					tree.equal_range(key).second) == 1);
+	}
+}
+
+#if __cplusplus >= 201103L
+template <typename Policy>
+void RunEmplaceTest()
+{
+	typedef std::pair<std::string const, std::unique_ptr<int>> ValueType;
+	typedef SplayTree<std::string, ValueType, Select1st<ValueType>,
+				std::less<std::string>,
+				std::allocator<ValueType>, Policy> MapType;
+
+	MapType map;
+	std::unique_ptr<int> one(new int(1));
+
+	assert(map.try_emplace("one", std::move(one)).second);
+	assert(!one);
+	std::unique_ptr<int> other(new int(2));
+	auto res = map.try_emplace("one", std::move(other));
+	assert(!res.second && other && *res.first->second == 1);
+
+	assert(map.emplace_unique("two", std::unique_ptr<int>(
+					new int(2))).second);
+	assert(!map.emplace_unique("two", std::unique_ptr<int>(
+					new int(3))).second);
+	map.emplace("two", std::unique_ptr<int>(new int(4)));
+	map.emplace_hint(map.end(), "three", std::unique_ptr<int>(
+					new int(3)));
+	map.insert(ValueType("zero", std::unique_ptr<int>(new int(0))));
+	assert(!map.insert_unique(ValueType("zero", nullptr)).second);
+
+	assert(map.size() == 5);
+	char const *order[] = {"one", "three", "two", "two", "zero"};
+	int const values[] = {1, 3, 4, 2, 0};
+	size_t i = 0;
+	for (auto it = map.begin(); it != map.end(); ++it, ++i)
+	{
+		assert(it->first == order[i]);
+		assert(*it->second == values[i]);
+	}
+}
+#endif
+
+int main()
+{
+	RunTest<TreeType>();
+	RunTest<TopDownTreeType>();
+	RunTest<ThreadedTreeType>();
+	RunTest<CountedTreeType>();
+	RunTest<CountedTopDownTreeType>();
+
+	for (size_t size = 1; size <= 10000; size *= 10)
+	{
+		RunRandomTest<TreeType>(size);
+		RunRandomTest<TopDownTreeType>(size);
+		RunBuildTest<TreeType>(size);
+		RunBuildTest<TopDownTreeType>(size);
+		RunSplitJoinTest<TreeType>(size);
+		RunSplitJoinTest<TopDownTreeType>(size);
+		RunRandomTest<ThreadedTreeType>(size);
+		RunRandomTest<CountedTreeType>(size);
+		RunRandomTest<CountedTopDownTreeType>(size);
+		RunBuildTest<CountedTreeType>(size);
+		RunBuildTest<CountedTopDownTreeType>(size);
+		RunSplitJoinTest<CountedTreeType>(size);
+		RunSplitJoinTest<CountedTopDownTreeType>(size);
+		RunOrderTest<CountedTreeType>(size);
+		RunOrderTest<CountedTopDownTreeType>(size);
+		RunHintTest<TreeType>(size);
+		RunHintTest<TopDownTreeType>(size);
+		RunHintTest<CountedTreeType>(size);
+		RunHintTest<CountedTopDownTreeType>(size);
+		RunTransparentTest<BottomUpSplay>(size);
+		RunTransparentTest<TopDownSplay>(size);
+	}
+
+	for (size_t size = 1; size <= 1000; size *= 10)
+	{
+		RunEraseTest<PairTreeType>(size);
+		RunEraseTest<ThreadedPairTreeType>(size);
+	}
+	RunEraseCostTest();
+	RunAssignThrowTest();
+
+#if __cplusplus >= 201103L
+	RunEmplaceTest<BottomUpSplay>();
+	RunEmplaceTest<TopDownSplay>();
+	RunEmplaceTest< OrderStatistics<> >();
+#endif
 
 	std::cout << "test is successfully passed" << std::endl;
 
@@ -5,14 +5,14 @@
 
 #include "splay_node.hpp"
 
-template <typename T>
+template <typename T, typename Node = SplayNode<T> >
 struct SplayIterator
 		: public std::iterator<std::bidirectional_iterator_tag, T>
 {
 	typedef std::iterator<std::bidirectional_iterator_tag, T> BaseType;
-	typedef SplayIterator<T> SelfType;
+	typedef SplayIterator<T, Node> SelfType;
 	typedef SplayNodeBase *NodeBasePtrType;
-	typedef SplayNode<T> *NodePtrType;
+	typedef Node *NodePtrType;
 
 	typedef typename std::iterator_traits<SelfType>::reference RefType;
 	typedef typename std::iterator_traits<SelfType>::pointer PtrType;
@@ -76,21 +76,21 @@ struct SplayIterator
 	NodeBasePtrType m_node;
 };
 
-template <typename T>
+template <typename T, typename Node = SplayNode<T> >
 struct SplayConstIterator
 		: public std::iterator<std::bidirectional_iterator_tag, T const>
 {	
 	typedef std::iterator<std::bidirectional_iterator_tag, T const>
 				BaseType;
 
-	typedef SplayConstIterator<T> SelfType;
+	typedef SplayConstIterator<T, Node> SelfType;
 	typedef SplayNodeBase const *NodeBasePtrType;
-	typedef SplayNode<T> const *NodePtrType;
+	typedef Node const *NodePtrType;
 
 	typedef typename std::iterator_traits<SelfType>::reference RefType;
 	typedef typename std::iterator_traits<SelfType>::pointer PtrType;
 
-	typedef SplayIterator<T> IteratorType;
+	typedef SplayIterator<T, Node> IteratorType;
 
 	SplayConstIterator() throw()
 		: BaseType()
@@ -156,16 +156,16 @@ struct SplayConstIterator
 	NodeBasePtrType m_node;
 };
 
-template <typename T>
-inline bool operator==(SplayIterator<T> const & lhs,
-			SplayConstIterator<T> const & rhs) throw()
+template <typename T, typename Node>
+inline bool operator==(SplayIterator<T, Node> const & lhs,
+			SplayConstIterator<T, Node> const & rhs) throw()
 {
 	return lhs.m_node == rhs.m_node;
 }
 
-template <typename T>
-inline bool operator!=(SplayIterator<T> const & lhs,
-			SplayConstIterator<T> const & rhs) throw()
+template <typename T, typename Node>
+inline bool operator!=(SplayIterator<T, Node> const & lhs,
+			SplayConstIterator<T, Node> const & rhs) throw()
 {
 	return lhs.m_node != rhs.m_node;
 }
@@ -3,8 +3,8 @@
 
 #include "splay_node_base.hpp"
 
-template <typename T>
-struct SplayNode : public SplayNodeBase
+template <typename T, typename Base = SplayNodeBase>
+struct SplayNode : public Base
 {
 	T m_value;
 };
@@ -14,8 +14,19 @@ namespace
 		return node->m_parent && (node->m_parent->m_right == node);
 	}
 
+	/**
+	 * Subtree of node after rotation contains exactly the same nodes as
+	 * subtree of parent before, so only parent needs recount.
+	 **/
+	void RotateCount(SplayNodeBase *node, SplayNodeBase *parent) throw()
+	{
+		size_t const count = SplayCount(parent);
+		SplayUpdateCount(parent);
+		SplaySetCount(node, count);
+	}
+
 	void RotateLeft(SplayNodeBase *node, SplayNodeBase *parent,
-			SplayNodeBase *grand) throw()
+			SplayNodeBase *grand, bool counted) throw()
 	{
 		SplayNodeBase *const child = node->m_left;
 		SplaySetLeft(node, parent);
@@ -25,10 +36,13 @@ namespace
 			SplaySetLeft(grand, node);
 		else
 			SplaySetRight(grand, node);
+
+		if (counted)
+			RotateCount(node, parent);
 	}
 
 	void RotateRight(SplayNodeBase *node, SplayNodeBase *parent,
-			SplayNodeBase *grand) throw()
+			SplayNodeBase *grand, bool counted) throw()
 	{
 		SplayNodeBase *const child = node->m_right;
 		SplaySetRight(node, parent);
@@ -38,34 +52,62 @@ namespace
 			SplaySetLeft(grand, node);
 		else
 			SplaySetRight(grand, node);
+
+		if (counted)
+			RotateCount(node, parent);
 	}
 
 	void RotateLeftLeft(SplayNodeBase *node, SplayNodeBase *parent,
-			SplayNodeBase *grand, SplayNodeBase *ggrand) throw()
+			SplayNodeBase *grand, SplayNodeBase *ggrand,
+			bool counted) throw()
 	{
-		RotateLeft(parent, grand, ggrand);
-		RotateLeft(node, parent, ggrand);
+		RotateLeft(parent, grand, ggrand, counted);
+		RotateLeft(node, parent, ggrand, counted);
 	}
 
 	void RotateLeftRight(SplayNodeBase *node, SplayNodeBase *parent,
-			SplayNodeBase *grand, SplayNodeBase *ggrand) throw()
+			SplayNodeBase *grand, SplayNodeBase *ggrand,
+			bool counted) throw()
 	{
-		RotateLeft(node, parent, grand);
-		RotateRight(node, grand, ggrand);
+		RotateLeft(node, parent, grand, counted);
+		RotateRight(node, grand, ggrand, counted);
 	}
 
 	void RotateRightLeft(SplayNodeBase *node, SplayNodeBase *parent,
-			SplayNodeBase *grand, SplayNodeBase *ggrand) throw()
+			SplayNodeBase *grand, SplayNodeBase *ggrand,
+			bool counted) throw()
 	{
-		RotateRight(node, parent, grand);
-		RotateLeft(node, grand, ggrand);
+		RotateRight(node, parent, grand, counted);
+		RotateLeft(node, grand, ggrand, counted);
 	}
 
 	void RotateRightRight(SplayNodeBase *node, SplayNodeBase *parent,
-			SplayNodeBase *grand, SplayNodeBase *ggrand) throw()
+			SplayNodeBase *grand, SplayNodeBase *ggrand,
+			bool counted) throw()
 	{
-		RotateRight(parent, grand, ggrand);
-		RotateRight(node, parent, ggrand);
+		RotateRight(parent, grand, ggrand, counted);
+		RotateRight(node, parent, ggrand, counted);
+	}
+
+	SplayNodeBase *BuildFromVine(SplayNodeBase *&vine, size_t size,
+			bool counted) throw()
+	{
+		if (!size)
+			return 0;
+
+		SplayNodeBase *const left = BuildFromVine(vine, size / 2,
+					counted);
+		SplayNodeBase *const root = vine;
+
+		vine = vine->m_right;
+		root->m_parent = 0;
+		SplaySetLeft(root, left);
+		SplaySetRight(root, BuildFromVine(vine, size - size / 2 - 1,
+					counted));
+		if (counted)
+			SplaySetCount(root, size);
+
+		return root;
 	}
 
 } /* anonymous namespace */
@@ -153,7 +195,7 @@ SplayNodeBase *SplayPred(SplayNodeBase *node) throw()
 		SplayPred(const_cast<SplayNodeBase const *>(node)));
 }
 
-void Splay(SplayNodeBase *node, SplayNodeBase *root) throw()
+void Splay(SplayNodeBase *node, SplayNodeBase *root, bool counted) throw()
 {
 	while (node->m_parent != root)
 	{
@@ -163,9 +205,9 @@ void Splay(SplayNodeBase *node, SplayNodeBase *root) throw()
 		if (grand == root)
 		{
 			if (parent->m_left == node)
-				RotateRight(node, parent, grand);
+				RotateRight(node, parent, grand, counted);
 			else
-				RotateLeft(node, parent, grand);
+				RotateLeft(node, parent, grand, counted);
 		}
 		else
 		{
@@ -173,27 +215,32 @@ void Splay(SplayNodeBase *node, SplayNodeBase *root) throw()
 			{
 				if (parent->m_left == node)
 					RotateRightRight(node, parent, grand,
-							grand->m_parent);
+							grand->m_parent,
+							counted);
 				else
 					RotateLeftRight(node, parent, grand,
-							grand->m_parent);
+							grand->m_parent,
+							counted);
 			}
 			else
 			{
 				if (parent->m_left == node)
 					RotateRightLeft(node, parent, grand,
-							grand->m_parent);
+							grand->m_parent,
+							counted);
 				else
 					RotateLeftLeft(node, parent, grand,
-							grand->m_parent);
+							grand->m_parent,
+							counted);
 			}
 		}
 	}
 }
 
-void SplayErase(SplayNodeBase *node, SplayNodeBase *root) throw()
+void SplayErase(SplayNodeBase *node, SplayNodeBase *root, bool counted)
+			throw()
 {
-	Splay(node, root);
+	Splay(node, root, counted);
 
 	if (!node->m_left)
 	{
@@ -206,8 +253,16 @@ void SplayErase(SplayNodeBase *node, SplayNodeBase *root) throw()
 	else
 	{
 		SplayNodeBase *const right = SplayRightMost(node->m_left);
-		Splay(right, node);
+		Splay(right, node, counted);
 		SplaySetRight(right, node->m_right);
 		SplaySetLeft(root, right);
+		if (counted)
+			SplayUpdateCount(right);
 	}
 }
+
+SplayNodeBase *SplayTreeFromVine(SplayNodeBase *vine, size_t size,
+			bool counted) throw()
+{
+	return BuildFromVine(vine, size, counted);
+}
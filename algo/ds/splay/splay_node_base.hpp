@@ -1,6 +1,8 @@
 #ifndef __SPLAY_HPP__
 #define __SPLAY_HPP__
 
+#include <cstddef>
+
 struct SplayNodeBase
 {
 	SplayNodeBase *m_parent;
@@ -8,6 +10,34 @@ struct SplayNodeBase
 	SplayNodeBase *m_right;
 };
 
+/**
+ * Node base for order statistics: m_count is the number of nodes in the
+ * subtree. Functions below maintain it only when called with counted set,
+ * and then all the nodes of the tree (except the header) must be of this
+ * type.
+ **/
+struct SplayCountedNodeBase : public SplayNodeBase
+{
+	size_t m_count;
+};
+
+inline size_t SplayCount(SplayNodeBase const *node) throw()
+{
+	return node ? static_cast<SplayCountedNodeBase const *>(node)->m_count
+			: 0;
+}
+
+inline void SplaySetCount(SplayNodeBase *node, size_t count) throw()
+{
+	static_cast<SplayCountedNodeBase *>(node)->m_count = count;
+}
+
+inline void SplayUpdateCount(SplayNodeBase *node) throw()
+{
+	SplaySetCount(node, SplayCount(node->m_left)
+				+ SplayCount(node->m_right) + 1);
+}
+
 void SplaySetLeft(SplayNodeBase *parent, SplayNodeBase *child) throw();
 void SplaySetRight(SplayNodeBase *parent, SplayNodeBase *child) throw();
 
@@ -21,7 +51,16 @@ SplayNodeBase *SplaySucc(SplayNodeBase *node) throw();
 SplayNodeBase const *SplayPred(SplayNodeBase const *node) throw();
 SplayNodeBase *SplayPred(SplayNodeBase *node) throw();
 
-void Splay(SplayNodeBase *node, SplayNodeBase *root) throw();
-void SplayErase(SplayNodeBase *node, SplayNodeBase *root) throw();
+void Splay(SplayNodeBase *node, SplayNodeBase *root, bool counted = false)
+			throw();
+void SplayErase(SplayNodeBase *node, SplayNodeBase *root,
+			bool counted = false) throw();
+
+/**
+ * Builds perfectly balanced tree from size nodes linked through m_right
+ * in order in linear time, returns the root of the new tree.
+ **/
+SplayNodeBase *SplayTreeFromVine(SplayNodeBase *vine, size_t size,
+			bool counted = false) throw();
 
 #endif /*__SPLAY_HPP__*/
@@ -0,0 +1,128 @@
+#ifndef __SPLAY_POLICY_HPP__
+#define __SPLAY_POLICY_HPP__
+
+#include "splay_node_base.hpp"
+
+/**
+ * Splay policies are empty tags, SplayTree dispatches on them. BottomUpSplay
+ * descends to the node first and then rotates it up using parent pointers,
+ * TopDownSplay (Sleator-Tarjan) splits the tree into left and right parts
+ * while descending and assembles them around the last node of the access
+ * path, so every lookup walks the path only once.
+ **/
+struct BottomUpSplay { };
+struct TopDownSplay { };
+
+/**
+ * OrderStatistics<Policy> splays the same way as Policy, but nodes also keep
+ * sizes of their subtrees, so SplayTree can find k-th element and rank of a
+ * key in amortized logarithmic time. The price is one more word per node and
+ * a bit more work per rotation.
+ **/
+template <typename Policy = BottomUpSplay>
+struct OrderStatistics : public Policy { };
+
+template <typename Policy>
+struct SplayPolicyTraits
+{
+	typedef SplayNodeBase NodeBase;
+	static bool const counted = false;
+};
+
+template <typename Policy>
+struct SplayPolicyTraits< OrderStatistics<Policy> >
+{
+	typedef SplayCountedNodeBase NodeBase;
+	static bool const counted = true;
+};
+
+/**
+ * Top-down splay of subtree rooted at root. locate(node) returns negative
+ * value to continue in left subtree, positive value to continue in right
+ * subtree and zero to stop at node. Returns new root of the subtree, the
+ * caller is responsible for linking it to the parent. With counted set
+ * subtree sizes are fixed up along the left and right parts.
+ **/
+template <typename Locate>
+SplayNodeBase *SplayTopDown(SplayNodeBase *root, Locate locate,
+			bool counted = false) throw()
+{
+	SplayNodeBase header;
+	header.m_parent = header.m_left = header.m_right = 0;
+
+	SplayNodeBase *left = &header;
+	SplayNodeBase *right = &header;
+	SplayNodeBase *node = root;
+
+	for (;;)
+	{
+		int const dir = locate(node);
+
+		if (dir < 0)
+		{
+			SplayNodeBase *child = node->m_left;
+			if (!child)
+				break;
+
+			if (locate(child) < 0)
+			{
+				SplaySetLeft(node, child->m_right);
+				SplaySetRight(child, node);
+				if (counted)
+					SplayUpdateCount(node);
+				node = child;
+				if (!node->m_left)
+					break;
+			}
+
+			SplaySetLeft(right, node);
+			right = node;
+			node = node->m_left;
+		}
+		else if (dir > 0)
+		{
+			SplayNodeBase *child = node->m_right;
+			if (!child)
+				break;
+
+			if (locate(child) > 0)
+			{
+				SplaySetRight(node, child->m_left);
+				SplaySetLeft(child, node);
+				if (counted)
+					SplayUpdateCount(node);
+				node = child;
+				if (!node->m_right)
+					break;
+			}
+
+			SplaySetRight(left, node);
+			left = node;
+			node = node->m_right;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	SplaySetRight(left, node->m_left);
+	SplaySetLeft(right, node->m_right);
+
+	if (counted)
+	{
+		for (SplayNodeBase *p = left; p != &header; p = p->m_parent)
+			SplayUpdateCount(p);
+		for (SplayNodeBase *p = right; p != &header; p = p->m_parent)
+			SplayUpdateCount(p);
+	}
+
+	SplaySetLeft(node, header.m_right);
+	SplaySetRight(node, header.m_left);
+	if (counted)
+		SplayUpdateCount(node);
+
+	return node;
+}
+
+#endif /*__SPLAY_POLICY_HPP__*/
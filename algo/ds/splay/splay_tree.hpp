@@ -1,11 +1,44 @@
 #ifndef __SPLAY_TREE_HPP__
 #define __SPLAY_TREE_HPP__
 
+#include <algorithm>
 #include <iterator>
 #include <memory>
+#if __cplusplus >= 201103L
+#include <tuple>
+#include <utility>
+#endif
 
 #include "splay_iterator.hpp"
 #include "splay_node.hpp"
+#include "splay_policy.hpp"
+
+/**
+ * Tag for constructors that take input already sorted by key.
+ **/
+struct SortedUnique { };
+SortedUnique const sorted_unique = SortedUnique();
+
+template <typename T>
+struct SplayAlwaysVoid
+{
+	typedef void type;
+};
+
+/**
+ * SplayTransparent<Cmp, K, R>::type is R when Cmp declares is_transparent,
+ * so lookup overloads taking any key type K are enabled only for such
+ * comparators, just like in std::set.
+ **/
+template <typename Cmp, typename K, typename R, typename Enable = void>
+struct SplayTransparent { };
+
+template <typename Cmp, typename K, typename R>
+struct SplayTransparent<Cmp, K, R,
+			typename SplayAlwaysVoid<typename Cmp::is_transparent>::type>
+{
+	typedef R type;
+};
 
 template <typename KeyCmp, typename NodeAllocator>
 struct SplayTreeImpl : public NodeAllocator
@@ -37,12 +70,14 @@ struct SplayTreeImpl : public NodeAllocator
 };
 
 template < typename Key, typename Val, typename KeyVal, typename Cmp,
-			typename Alloc = std::allocator<Val> >
+			typename Alloc = std::allocator<Val>,
+			typename Policy = BottomUpSplay >
 class SplayTree
 {
-	typedef typename Alloc::template rebind< SplayNode<Val> >::other
-				NodeAllocator;
-	typedef SplayTree<Key, Val, KeyVal, Cmp, Alloc> SelfType;
+	typedef SplayPolicyTraits<Policy> Traits;
+	typedef SplayNode<Val, typename Traits::NodeBase> Node;
+	typedef typename Alloc::template rebind<Node>::other NodeAllocator;
+	typedef SplayTree<Key, Val, KeyVal, Cmp, Alloc, Policy> SelfType;
 
 public:
 	typedef Key key_type;
@@ -53,9 +88,10 @@ public:
 	typedef value_type const & const_reference;
 	typedef size_t size_type;
 	typedef Alloc allocator_type;
+	typedef Policy splay_policy;
 
-	typedef SplayIterator<value_type> iterator;
-	typedef SplayConstIterator<value_type> const_iterator;
+	typedef SplayIterator<value_type, Node> iterator;
+	typedef SplayConstIterator<value_type, Node> const_iterator;
 	typedef std::reverse_iterator<iterator> reverse_iterator;
 	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
 
@@ -67,8 +103,8 @@ public:
 private:
 	typedef SplayNodeBase * NodeBasePtr;
 	typedef SplayNodeBase const * NodeBaseConstPtr;
-	typedef SplayNode<Val> * NodePtr;
-	typedef SplayNode<Val> const * NodeConstPtr;
+	typedef Node * NodePtr;
+	typedef Node const * NodeConstPtr;
 	typedef SplayTreeImpl<Cmp, NodeAllocator> SplayImpl;
 
 	NodeAllocator & GetAllocator() throw()
@@ -85,6 +121,8 @@ private:
 	{
 		NodePtr tmp = GetAllocator().allocate(1);
 		tmp->m_left = tmp->m_right = tmp->m_parent = 0;
+		if (Traits::counted)
+			SplaySetCount(tmp, 1);
 		return tmp;
 	}
 
@@ -108,6 +146,42 @@ private:
 		return tmp;
 	}
 
+#if __cplusplus >= 201103L
+	template <typename ... Args>
+	NodePtr CreateNode(Args && ... args)
+	{
+		NodePtr tmp = GetNode();
+		try
+		{
+			allocator_type a(GetAllocator());
+			std::allocator_traits<allocator_type>::construct(a,
+					&tmp->m_value,
+					std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			PutNode(tmp);
+			throw;
+		}
+		return tmp;
+	}
+
+	template <typename K, typename ... Args>
+	std::pair<iterator, bool> TryEmplace(K && k, Args && ... args)
+	{
+		NodeBasePtr const found = Lookup(k);
+
+		if (found != &m_impl.m_header)
+			return std::make_pair(iterator(found), false);
+
+		NodePtr const node = CreateNode(std::piecewise_construct,
+				std::forward_as_tuple(std::forward<K>(k)),
+				std::forward_as_tuple(
+					std::forward<Args>(args)...));
+		return std::make_pair(iterator(InsertNode(node)), true);
+	}
+#endif
+
 	void DestroyNode(NodePtr ptr)
 	{
 		get_allocator().destroy(&ptr->m_value);
@@ -116,7 +190,189 @@ private:
 
 	NodePtr CloneNode(NodeConstPtr ptr)
 	{
-		return CreateNode(ptr->m_value);
+		NodePtr tmp = CreateNode(ptr->m_value);
+		if (Traits::counted)
+			SplaySetCount(tmp, SplayCount(ptr));
+		return tmp;
+	}
+
+	NodePtr CloneNode(NodeBaseConstPtr ptr)
+	{
+		return CloneNode(static_cast<NodeConstPtr>(ptr));
+	}
+
+	/**
+	 * Destroys whole subtree without splaying or parent pointers
+	 * bookkeeping: rotates left children up until node has none and
+	 * then destroys it, so no stack is needed for degenerate trees.
+	 **/
+	size_t DestroySubtree(NodeBasePtr node)
+	{
+		size_t count = 0;
+
+		while (node)
+		{
+			NodeBasePtr const left = node->m_left;
+
+			if (left)
+			{
+				node->m_left = left->m_right;
+				left->m_right = node;
+				node = left;
+			}
+			else
+			{
+				NodeBasePtr const right = node->m_right;
+				DestroyNode(static_cast<NodePtr>(node));
+				node = right;
+				++count;
+			}
+		}
+
+		return count;
+	}
+
+	/**
+	 * Preorder walk of subtree with specified root using parent
+	 * pointers, returns 0 when the whole subtree is visited.
+	 **/
+	static NodeBaseConstPtr NextInSubtree(NodeBaseConstPtr node,
+				NodeBaseConstPtr root) throw()
+	{
+		if (node->m_left)
+			return node->m_left;
+
+		if (node->m_right)
+			return node->m_right;
+
+		while (node != root)
+		{
+			NodeBaseConstPtr const parent = node->m_parent;
+
+			if (parent->m_left == node && parent->m_right)
+				return parent->m_right;
+			node = parent;
+		}
+
+		return 0;
+	}
+
+	/**
+	 * Returns number of nodes in subtree first when subtrees first and
+	 * second have total nodes together. Walks both subtrees in lockstep,
+	 * so it takes time proportional to the smaller one.
+	 **/
+	static size_t CountSubtree(NodeBaseConstPtr first,
+				NodeBaseConstPtr second, size_t total) throw()
+	{
+		NodeBaseConstPtr x = first;
+		NodeBaseConstPtr y = second;
+		size_t count = 0;
+
+		while (x && y)
+		{
+			x = NextInSubtree(x, first);
+			y = NextInSubtree(y, second);
+			++count;
+		}
+
+		return x ? total - count : count;
+	}
+
+	/**
+	 * Clones subtree node by node preserving its shape. Walks the source
+	 * using parent pointers, so no stack is needed for degenerate trees.
+	 **/
+	NodeBasePtr CloneSubtree(NodeBaseConstPtr root)
+	{
+		NodeBasePtr const copy = CloneNode(root);
+		NodeBaseConstPtr from = root;
+		NodeBasePtr to = copy;
+
+		try
+		{
+			for (;;)
+			{
+				if (from->m_left && !to->m_left)
+				{
+					from = from->m_left;
+					SplaySetLeft(to, CloneNode(from));
+					to = to->m_left;
+				}
+				else if (from->m_right && !to->m_right)
+				{
+					from = from->m_right;
+					SplaySetRight(to, CloneNode(from));
+					to = to->m_right;
+				}
+				else if (from != root)
+				{
+					from = from->m_parent;
+					to = to->m_parent;
+				}
+				else
+				{
+					break;
+				}
+			}
+		}
+		catch (...)
+		{
+			DestroySubtree(copy);
+			throw;
+		}
+
+		return copy;
+	}
+
+	void CopyFrom(SplayTree const & other)
+	{
+		if (!other.m_impl.m_header.m_left)
+			return;
+
+		SplaySetLeft(&m_impl.m_header,
+				CloneSubtree(other.m_impl.m_header.m_left));
+		m_impl.m_size = other.m_impl.m_size;
+	}
+
+	/**
+	 * Fills empty tree from [first, last). Nodes are collected in a vine
+	 * while input is sorted and then turned into balanced tree in linear
+	 * time, the rest of unsorted input is inserted one by one.
+	 **/
+	template <typename InputIterator>
+	void Build(InputIterator first, InputIterator last, bool sorted)
+	{
+		SplayNodeBase vine;
+		NodeBasePtr tail = &vine;
+		size_t size = 0;
+
+		vine.m_right = 0;
+		try
+		{
+			for (; first != last; ++first, ++size)
+			{
+				if (!sorted && size && m_impl.m_cmp(
+						KeyVal()(*first), GetKey(tail)))
+					break;
+
+				tail->m_right = CreateNode(*first);
+				tail = tail->m_right;
+			}
+		}
+		catch (...)
+		{
+			DestroySubtree(vine.m_right);
+			throw;
+		}
+
+		SplaySetLeft(&m_impl.m_header,
+				SplayTreeFromVine(vine.m_right, size,
+					Traits::counted));
+		m_impl.m_size = size;
+
+		for (; first != last; ++first)
+			insert(*first);
 	}
 
 	static const_reference GetValue(NodeConstPtr x) throw()
@@ -179,7 +435,8 @@ private:
 		return SplayRightMost(x);
 	}
 
-	NodeBaseConstPtr LowerBound(Key const & k) const throw()
+	template <typename K>
+	NodeBaseConstPtr LowerBound(K const & k) const throw()
 	{
 		NodeBaseConstPtr parent = &m_impl.m_header;
 		NodeConstPtr current = GetLeft(parent);
@@ -200,13 +457,29 @@ private:
 		return parent;
 	}
 
-	NodeBasePtr LowerBound(Key const & k) throw()
+	/**
+	 * Non-splaying lookup, returns the header if there is no key k.
+	 **/
+	template <typename K>
+	NodeBaseConstPtr Find(K const & k) const throw()
+	{
+		NodeBaseConstPtr const node = LowerBound(k);
+
+		if (node == &m_impl.m_header || m_impl.m_cmp(k, GetKey(node)))
+			return &m_impl.m_header;
+
+		return node;
+	}
+
+	template <typename K>
+	NodeBasePtr LowerBound(K const & k) throw()
 	{
 		return const_cast<NodeBasePtr>(
 			const_cast<SelfType const *>(this)->LowerBound(k));
 	}
 
-	NodeBaseConstPtr UpperBound(Key const & k) const throw()
+	template <typename K>
+	NodeBaseConstPtr UpperBound(K const & k) const throw()
 	{
 		NodeBaseConstPtr parent = &m_impl.m_header;
 		NodeConstPtr current = GetLeft(parent);
@@ -227,19 +500,77 @@ private:
 		return parent;
 	}
 
-	NodeBasePtr UpperBound(Key const & k) throw()
+	template <typename K>
+	NodeBasePtr UpperBound(K const & k) throw()
 	{
 		return const_cast<NodeBasePtr>(
 			const_cast<SelfType const *>(this)->UpperBound(k));
 	}
 
-	NodeBasePtr Lookup(Key const & k) throw()
+	/**
+	 * Locates node with key k: stops at equal key.
+	 **/
+	template <typename K>
+	struct KeyLocator
+	{
+		KeyLocator(Cmp const & cmp, K const & k)
+			: m_cmp(cmp)
+			, m_key(k)
+		{ }
+
+		int operator()(NodeBaseConstPtr x) const
+		{
+			if (m_cmp(m_key, GetKey(x)))
+				return -1;
+			if (m_cmp(GetKey(x), m_key))
+				return 1;
+			return 0;
+		}
+
+		Cmp const & m_cmp;
+		K const & m_key;
+	};
+
+	/**
+	 * Locates insert position for key k: never stops, goes left on
+	 * equal keys just like InsertNode(node, BottomUpSplay) does.
+	 **/
+	struct InsertLocator
+	{
+		InsertLocator(Cmp const & cmp, Key const & k)
+			: m_cmp(cmp)
+			, m_key(k)
+		{ }
+
+		int operator()(NodeBaseConstPtr x) const
+		{
+			return m_cmp(GetKey(x), m_key) ? 1 : -1;
+		}
+
+		Cmp const & m_cmp;
+		Key const & m_key;
+	};
+
+	template <typename Locate>
+	NodeBasePtr SplayRoot(Locate locate) throw()
+	{
+		NodeBasePtr root = m_impl.m_header.m_left;
+		if (!root)
+			return 0;
+
+		root = SplayTopDown(root, locate, Traits::counted);
+		SplaySetLeft(&m_impl.m_header, root);
+		return root;
+	}
+
+	template <typename K>
+	NodeBasePtr Lookup(K const & k, BottomUpSplay) throw()
 	{
 		NodeBasePtr node = LowerBound(k);
 
 		if (node != &m_impl.m_header)
 		{
-			Splay(node, &m_impl.m_header);
+			Splay(node, &m_impl.m_header, Traits::counted);
 			if (!m_impl.m_cmp(GetKey(node), k)
 					&& !m_impl.m_cmp(k, GetKey(node)))
 				return node;
@@ -248,7 +579,29 @@ private:
 		return &m_impl.m_header;
 	}
 
-	NodePtr Insert(value_type const & v)
+	template <typename K>
+	NodeBasePtr Lookup(K const & k, TopDownSplay) throw()
+	{
+		NodeBasePtr root = SplayRoot(KeyLocator<K>(m_impl.m_cmp, k));
+
+		if (root && !m_impl.m_cmp(GetKey(root), k)
+				&& !m_impl.m_cmp(k, GetKey(root)))
+			return root;
+
+		return &m_impl.m_header;
+	}
+
+	template <typename K>
+	NodeBasePtr Lookup(K const & k) throw()
+	{
+		return Lookup(k, Policy());
+	}
+
+	/**
+	 * Links already constructed node into the tree and splays it to the
+	 * root.
+	 **/
+	NodePtr InsertNode(NodePtr node, BottomUpSplay) throw()
 	{
 		NodeBasePtr parent = &m_impl.m_header;
 		NodePtr current = GetLeft(parent);
@@ -257,7 +610,10 @@ private:
 		while (current)
 		{
 			parent = current;
-			if (!m_impl.m_cmp(GetKey(current), KeyVal()(v)))
+			if (Traits::counted)
+				SplaySetCount(current, SplayCount(current) + 1);
+
+			if (!m_impl.m_cmp(GetKey(current), GetKey(node)))
 			{
 				insert_left = true;
 				current = GetLeft(current);
@@ -269,22 +625,148 @@ private:
 			}
 		}
 
-		NodePtr node = CreateNode(v);
 		if (insert_left)
 			SplaySetLeft(parent, node);
 		else
 			SplaySetRight(parent, node);
 
-		Splay(node, &m_impl.m_header);
+		Splay(node, &m_impl.m_header, Traits::counted);
+		++m_impl.m_size;
+
+		return node;
+	}
+
+	NodePtr InsertNode(NodePtr node, TopDownSplay) throw()
+	{
+		NodeBasePtr root = SplayRoot(
+				InsertLocator(m_impl.m_cmp, GetKey(node)));
+
+		if (root)
+		{
+			if (!m_impl.m_cmp(GetKey(root), GetKey(node)))
+			{
+				SplaySetLeft(node, root->m_left);
+				SplaySetRight(node, root);
+				root->m_left = 0;
+			}
+			else
+			{
+				SplaySetRight(node, root->m_right);
+				SplaySetLeft(node, root);
+				root->m_right = 0;
+			}
+
+			if (Traits::counted)
+			{
+				SplayUpdateCount(root);
+				SplayUpdateCount(node);
+			}
+		}
+
+		SplaySetLeft(&m_impl.m_header, node);
+		++m_impl.m_size;
+
+		return node;
+	}
+
+	/**
+	 * Monotonic fast path: if the root is the maximum and node goes
+	 * after it (or the root is the minimum and node goes before it) node
+	 * becomes the new root without any descent. The last inserted node
+	 * is the root, so increasing and decreasing streams take O(1) per
+	 * insert.
+	 **/
+	bool InsertAtRoot(NodePtr node) throw()
+	{
+		NodeBasePtr const root = m_impl.m_header.m_left;
+
+		if (!root)
+			return false;
+
+		if (!root->m_right && m_impl.m_cmp(GetKey(root), GetKey(node)))
+			SplaySetLeft(node, root);
+		else if (!root->m_left
+				&& !m_impl.m_cmp(GetKey(root), GetKey(node)))
+			SplaySetRight(node, root);
+		else
+			return false;
+
+		if (Traits::counted)
+			SplaySetCount(node, SplayCount(root) + 1);
+		SplaySetLeft(&m_impl.m_header, node);
+		++m_impl.m_size;
+
+		return true;
+	}
+
+	NodePtr InsertNode(NodePtr node) throw()
+	{
+		if (InsertAtRoot(node))
+			return node;
+
+		return InsertNode(node, Policy());
+	}
+
+	/**
+	 * Inserts node right before hint if it's the right place for it,
+	 * otherwise falls back to InsertNode(node). The new node is splayed, so
+	 * inserting a run of keys at the same hint takes O(1) amortized per
+	 * key.
+	 **/
+	NodePtr InsertNodeBefore(NodeBasePtr hint, NodePtr node) throw()
+	{
+		NodeBasePtr const header = &m_impl.m_header;
+		NodeBasePtr const prev = SplayPred(hint);
+
+		if ((hint != header && m_impl.m_cmp(GetKey(hint), GetKey(node)))
+				|| (prev && m_impl.m_cmp(GetKey(node),
+							GetKey(prev))))
+			return InsertNode(node);
+
+		if (!hint->m_left)
+			SplaySetLeft(hint, node);
+		else
+			SplaySetRight(prev, node);
+
+		if (Traits::counted)
+		{
+			for (NodeBasePtr p = node->m_parent; p != header;
+						p = p->m_parent)
+				SplaySetCount(p, SplayCount(p) + 1);
+		}
+
+		Splay(node, header, Traits::counted);
 		++m_impl.m_size;
 
 		return node;
 	}
 
+	NodePtr Insert(value_type const & v)
+	{
+		return InsertNode(CreateNode(v));
+	}
+
+	/**
+	 * Inserts node unless there is an element with the same key already,
+	 * in that case node is destroyed.
+	 **/
+	std::pair<iterator, bool> InsertUniqueNode(NodePtr node)
+	{
+		NodeBasePtr const found = Lookup(GetKey(node));
+
+		if (found != &m_impl.m_header)
+		{
+			DestroyNode(node);
+			return std::make_pair(iterator(found), false);
+		}
+
+		return std::make_pair(iterator(InsertNode(node)), true);
+	}
+
 	NodeBasePtr Erase(NodePtr node)
 	{
 		NodeBasePtr next = SplaySucc(node);
-		SplayErase(node, &m_impl.m_header);
+		SplayErase(node, &m_impl.m_header, Traits::counted);
 		DestroyNode(node);
 		--m_impl.m_size;
 
@@ -296,7 +778,18 @@ public:
 	SplayTree(InputIterator first, InputIterator last)
 		: m_impl()
 	{
-		insert(first, last);
+		Build(first, last, false);
+	}
+
+	/**
+	 * [first, last) must be sorted by key, the tree is built in linear
+	 * time without any checks.
+	 **/
+	template <typename InputIterator>
+	SplayTree(SortedUnique, InputIterator first, InputIterator last)
+		: m_impl()
+	{
+		Build(first, last, true);
 	}
 
 	SplayTree() throw()
@@ -306,21 +799,31 @@ public:
 	SplayTree(SplayTree const & other)
 		: m_impl()
 	{
-		insert(other.begin(), other.end());
+		CopyFrom(other);
 	}
 
 	~SplayTree()
 	{
-		erase(begin(), end());
+		clear();
 	}
 
 	SplayTree & operator=(SplayTree const & other)
 	{
-		erase(begin(), end());
-		insert(other.begin(), other.end());
+		if (this != &other)
+		{
+			clear();
+			CopyFrom(other);
+		}
 		return *this;
 	}
 
+	void clear()
+	{
+		DestroySubtree(m_impl.m_header.m_left);
+		m_impl.Init();
+		m_impl.m_size = 0;
+	}
+
 	iterator begin() throw()
 	{
 		return iterator(GetMinimum(&m_impl.m_header));
@@ -371,6 +874,16 @@ public:
 		return iterator(UpperBound(k));
 	}
 
+	const_iterator lower_bound(Key const & k) const throw()
+	{
+		return const_iterator(LowerBound(k));
+	}
+
+	const_iterator upper_bound(Key const & k) const throw()
+	{
+		return const_iterator(UpperBound(k));
+	}
+
 	std::pair<iterator, iterator> equal_range(Key const & k) throw()
 	{
 		return std::make_pair(lower_bound(k), upper_bound(k));
@@ -381,6 +894,72 @@ public:
 		return iterator(Lookup(k));
 	}
 
+	/**
+	 * Lookup without splaying: doesn't modify the tree, so concurrent
+	 * calls are safe, but doesn't adapt the tree to the access pattern.
+	 **/
+	const_iterator find(Key const & k) const throw()
+	{
+		return const_iterator(Find(k));
+	}
+
+	/**
+	 * Lookups by any type comparable with Key, enabled only when Cmp has
+	 * is_transparent typedef, e. g. std::less<>. Key is never
+	 * constructed, so a std::string keyed tree can be searched by
+	 * char const * without allocations.
+	 **/
+	template <typename K>
+	typename SplayTransparent<Cmp, K, iterator>::type
+	lower_bound(K const & k) throw()
+	{
+		return iterator(LowerBound(k));
+	}
+
+	template <typename K>
+	typename SplayTransparent<Cmp, K, iterator>::type
+	upper_bound(K const & k) throw()
+	{
+		return iterator(UpperBound(k));
+	}
+
+	template <typename K>
+	typename SplayTransparent<Cmp, K, const_iterator>::type
+	lower_bound(K const & k) const throw()
+	{
+		return const_iterator(LowerBound(k));
+	}
+
+	template <typename K>
+	typename SplayTransparent<Cmp, K, const_iterator>::type
+	upper_bound(K const & k) const throw()
+	{
+		return const_iterator(UpperBound(k));
+	}
+
+	template <typename K>
+	typename SplayTransparent<Cmp, K,
+				std::pair<iterator, iterator> >::type
+	equal_range(K const & k) throw()
+	{
+		return std::make_pair(iterator(LowerBound(k)),
+					iterator(UpperBound(k)));
+	}
+
+	template <typename K>
+	typename SplayTransparent<Cmp, K, iterator>::type
+	find(K const & k) throw()
+	{
+		return iterator(Lookup(k));
+	}
+
+	template <typename K>
+	typename SplayTransparent<Cmp, K, const_iterator>::type
+	find(K const & k) const throw()
+	{
+		return const_iterator(Find(k));
+	}
+
 	std::pair<iterator, bool> insert_unique(value_type const & val)
 	{
 		iterator it = find(KeyVal()(val));
@@ -394,6 +973,12 @@ public:
 	template <typename InputIterator>
 	void insert(InputIterator first, InputIterator last)
 	{
+		if (!m_impl.m_size)
+		{
+			Build(first, last, false);
+			return;
+		}
+
 		for (; first != last; ++first)
 			insert(*first);
 	}
@@ -403,17 +988,226 @@ public:
 		return iterator(Insert(val));
 	}
 
+	/**
+	 * Inserts val as close as possible before hint, takes O(1) amortized
+	 * time if the hint is right.
+	 **/
+	iterator insert(const_iterator hint, value_type const & val)
+	{
+		return iterator(InsertNodeBefore(
+				const_cast<NodeBasePtr>(hint.m_node),
+				CreateNode(val)));
+	}
+
+#if __cplusplus >= 201103L
+	iterator insert(value_type && val)
+	{
+		return iterator(InsertNode(CreateNode(std::move(val))));
+	}
+
+	iterator insert(const_iterator hint, value_type && val)
+	{
+		return iterator(InsertNodeBefore(
+				const_cast<NodeBasePtr>(hint.m_node),
+				CreateNode(std::move(val))));
+	}
+
+	std::pair<iterator, bool> insert_unique(value_type && val)
+	{
+		iterator it = find(KeyVal()(val));
+
+		if (it == end())
+			return std::make_pair(iterator(InsertNode(
+					CreateNode(std::move(val)))), true);
+
+		return std::make_pair(it, false);
+	}
+
+	template <typename ... Args>
+	iterator emplace(Args && ... args)
+	{
+		return iterator(InsertNode(
+				CreateNode(std::forward<Args>(args)...)));
+	}
+
+	/**
+	 * The value has to be constructed to get its key, so it's destroyed
+	 * again if the key is already in the tree. Use try_emplace to avoid
+	 * that.
+	 **/
+	template <typename ... Args>
+	std::pair<iterator, bool> emplace_unique(Args && ... args)
+	{
+		return InsertUniqueNode(
+				CreateNode(std::forward<Args>(args)...));
+	}
+
+	template <typename ... Args>
+	iterator emplace_hint(const_iterator hint, Args && ... args)
+	{
+		return iterator(InsertNodeBefore(
+				const_cast<NodeBasePtr>(hint.m_node),
+				CreateNode(std::forward<Args>(args)...)));
+	}
+
+	/**
+	 * For map-like trees (value_type is std::pair<Key const, T>): if there
+	 * is no key k inserts value constructed from k and args, otherwise
+	 * nothing is constructed and args are left untouched.
+	 **/
+	template <typename ... Args>
+	std::pair<iterator, bool> try_emplace(Key const & k, Args && ... args)
+	{
+		return TryEmplace(k, std::forward<Args>(args)...);
+	}
+
+	template <typename ... Args>
+	std::pair<iterator, bool> try_emplace(Key && k, Args && ... args)
+	{
+		return TryEmplace(std::move(k), std::forward<Args>(args)...);
+	}
+#endif
+
 	iterator erase(iterator it)
 	{
 		return iterator(Erase(static_cast<NodePtr>(it.m_node)));
 	}
 
+	/**
+	 * Erases [first, last) splaying only both boundaries: predecessor
+	 * of first ends up as a left child of last, so the range is exactly
+	 * its right subtree and is destroyed at once without per node
+	 * rebalancing.
+	 **/
 	iterator erase(iterator first, iterator last)
 	{
-		iterator it = first;
-		for (; it != last;)
-			it = erase(it);
-		return it;
+		if (first == last)
+			return last;
+
+		NodeBasePtr const header = &m_impl.m_header;
+		NodeBasePtr const prev = SplayPred(first.m_node);
+		NodeBasePtr parent = header;
+		NodeBasePtr range;
+
+		if (last.m_node != header)
+		{
+			Splay(last.m_node, header, Traits::counted);
+			parent = last.m_node;
+		}
+
+		if (prev)
+		{
+			Splay(prev, parent, Traits::counted);
+			range = prev->m_right;
+			prev->m_right = 0;
+		}
+		else
+		{
+			range = parent->m_left;
+			parent->m_left = 0;
+		}
+
+		m_impl.m_size -= DestroySubtree(range);
+
+		if (Traits::counted)
+		{
+			if (prev)
+				SplayUpdateCount(prev);
+			if (parent != header)
+				SplayUpdateCount(parent);
+		}
+
+		return last;
+	}
+
+	void swap(SplayTree & other)
+	{
+		std::swap(m_impl.m_cmp, other.m_impl.m_cmp);
+		std::swap(GetAllocator(), other.GetAllocator());
+		std::swap(m_impl.m_header.m_left, other.m_impl.m_header.m_left);
+		std::swap(m_impl.m_size, other.m_impl.m_size);
+
+		if (m_impl.m_header.m_left)
+			m_impl.m_header.m_left->m_parent = &m_impl.m_header;
+		if (other.m_impl.m_header.m_left)
+			other.m_impl.m_header.m_left->m_parent =
+						&other.m_impl.m_header;
+	}
+
+	/**
+	 * Moves all elements with keys not less than k to greater, previous
+	 * content of greater is destroyed. Nodes are moved without copying
+	 * if both trees use equal allocators.
+	 **/
+	void split(Key const & k, SplayTree & greater)
+	{
+		greater.clear();
+
+		if (get_allocator() != greater.get_allocator())
+		{
+			iterator const from = lower_bound(k);
+			greater.insert(from, end());
+			erase(from, end());
+			return;
+		}
+
+		NodeBasePtr const node = LowerBound(k);
+		if (node == &m_impl.m_header)
+			return;
+
+		Splay(node, &m_impl.m_header, Traits::counted);
+
+		NodeBasePtr const left = node->m_left;
+		size_t const size = m_impl.m_size;
+		size_t const moved = Traits::counted
+				? size - SplayCount(left)
+				: size - CountSubtree(left, node->m_right,
+					size - 1);
+
+		node->m_left = 0;
+		if (Traits::counted)
+			SplaySetCount(node, moved);
+		SplaySetLeft(&m_impl.m_header, left);
+		m_impl.m_size -= moved;
+
+		SplaySetLeft(&greater.m_impl.m_header, node);
+		greater.m_impl.m_size = moved;
+	}
+
+	/**
+	 * Moves all elements of other to the end of this tree, keys of other
+	 * must not be less than any key of this tree. Takes O(log n)
+	 * amortized time if both trees use equal allocators.
+	 **/
+	void join(SplayTree & other)
+	{
+		if (this == &other || !other.m_impl.m_size)
+			return;
+
+		if (get_allocator() != other.get_allocator())
+		{
+			insert(other.begin(), other.end());
+			other.clear();
+			return;
+		}
+
+		NodeBasePtr const root = other.m_impl.m_header.m_left;
+
+		other.m_impl.m_header.m_left = 0;
+		m_impl.m_size += other.m_impl.m_size;
+		other.m_impl.m_size = 0;
+
+		if (!m_impl.m_header.m_left)
+		{
+			SplaySetLeft(&m_impl.m_header, root);
+			return;
+		}
+
+		NodeBasePtr const max = GetMaximum(m_impl.m_header.m_left);
+		Splay(max, &m_impl.m_header, Traits::counted);
+		SplaySetRight(max, root);
+		if (Traits::counted)
+			SplayUpdateCount(max);
 	}
 
 	size_t size() const throw()
@@ -421,6 +1215,59 @@ public:
 		return m_impl.m_size;
 	}
 
+	/**
+	 * Returns iterator to k-th (starting from 0) element in order or end()
+	 * if k >= size(), the element is splayed to the root. Available only
+	 * with OrderStatistics policy.
+	 **/
+	iterator nth(size_t k) throw()
+	{
+		typedef char CountedOnly[Traits::counted ? 1 : -1];
+		(void)sizeof(CountedOnly);
+
+		NodeBasePtr node = m_impl.m_header.m_left;
+
+		while (node)
+		{
+			size_t const left = SplayCount(node->m_left);
+
+			if (k < left)
+			{
+				node = node->m_left;
+			}
+			else if (k > left)
+			{
+				k -= left + 1;
+				node = node->m_right;
+			}
+			else
+			{
+				Splay(node, &m_impl.m_header, true);
+				return iterator(node);
+			}
+		}
+
+		return end();
+	}
+
+	/**
+	 * Returns number of elements with keys less than k, i. e. position of
+	 * lower_bound(k). Available only with OrderStatistics policy.
+	 **/
+	size_t rank(Key const & k) throw()
+	{
+		typedef char CountedOnly[Traits::counted ? 1 : -1];
+		(void)sizeof(CountedOnly);
+
+		NodeBasePtr const node = LowerBound(k);
+
+		if (node == &m_impl.m_header)
+			return m_impl.m_size;
+
+		Splay(node, &m_impl.m_header, true);
+		return SplayCount(node->m_left);
+	}
+
 private:
 	SplayImpl m_impl;
 };
@@ -0,0 +1,173 @@
+#ifndef __THREADED_SPLAY_ITERATOR_HPP__
+#define __THREADED_SPLAY_ITERATOR_HPP__
+
+#include <iterator>
+
+#include "threaded_splay_node.hpp"
+
+template <typename T>
+struct ThreadedSplayIterator
+		: public std::iterator<std::bidirectional_iterator_tag, T>
+{
+	typedef std::iterator<std::bidirectional_iterator_tag, T> BaseType;
+	typedef ThreadedSplayIterator<T> SelfType;
+	typedef ThreadedSplayNodeBase *NodeBasePtrType;
+	typedef ThreadedSplayNode<T> *NodePtrType;
+
+	typedef typename std::iterator_traits<SelfType>::reference RefType;
+	typedef typename std::iterator_traits<SelfType>::pointer PtrType;
+
+	ThreadedSplayIterator() throw()
+		: BaseType()
+		, m_node(0)
+	{ }
+
+	explicit ThreadedSplayIterator(NodeBasePtrType ptr) throw()
+		: BaseType()
+		, m_node(ptr)
+	{ }
+
+	RefType operator*() const throw()
+	{
+		return static_cast<NodePtrType>(m_node)->m_value;
+	}
+
+	PtrType operator->() const throw()
+	{
+		return &static_cast<NodePtrType>(m_node)->m_value;
+	}
+
+	SelfType &operator++() throw()
+	{
+		m_node = ThreadedSplaySucc(m_node);
+		return *this;
+	}
+
+	SelfType operator++(int) throw()
+	{
+		SelfType tmp = *this;
+		m_node = ThreadedSplaySucc(m_node);
+		return tmp;
+	}
+
+	SelfType &operator--() throw()
+	{
+		m_node = ThreadedSplayPred(m_node);
+		return *this;
+	}
+
+	SelfType operator--(int) throw()
+	{
+		SelfType tmp = *this;
+		m_node = ThreadedSplayPred(m_node);
+		return tmp;
+	}
+
+	bool operator==(SelfType const & other) const throw()
+	{
+		return m_node == other.m_node;
+	}
+
+	bool operator!=(SelfType const & other) const throw()
+	{
+		return m_node != other.m_node;
+	}
+
+	NodeBasePtrType m_node;
+};
+
+template <typename T>
+struct ThreadedSplayConstIterator
+		: public std::iterator<std::bidirectional_iterator_tag, T const>
+{	
+	typedef std::iterator<std::bidirectional_iterator_tag, T const>
+				BaseType;
+
+	typedef ThreadedSplayConstIterator<T> SelfType;
+	typedef ThreadedSplayNodeBase const *NodeBasePtrType;
+	typedef ThreadedSplayNode<T> const *NodePtrType;
+
+	typedef typename std::iterator_traits<SelfType>::reference RefType;
+	typedef typename std::iterator_traits<SelfType>::pointer PtrType;
+
+	typedef ThreadedSplayIterator<T> IteratorType;
+
+	ThreadedSplayConstIterator() throw()
+		: BaseType()
+		, m_node(0)
+	{ }
+
+	explicit ThreadedSplayConstIterator(NodeBasePtrType ptr) throw()
+		: BaseType()
+		, m_node(ptr)
+	{ }
+
+	ThreadedSplayConstIterator(IteratorType const & it)
+		: BaseType()
+		, m_node(it.m_node)
+	{ }
+
+	RefType operator*() const throw()
+	{
+		return static_cast<NodePtrType>(m_node)->m_value;
+	}
+
+	PtrType operator->() const throw()
+	{
+		return &static_cast<NodePtrType>(m_node)->m_value;
+	}
+
+	SelfType &operator++() throw()
+	{
+		m_node = ThreadedSplaySucc(m_node);
+		return *this;
+	}
+
+	SelfType operator++(int) throw()
+	{
+		SelfType tmp = *this;
+		m_node = ThreadedSplaySucc(m_node);
+		return tmp;
+	}
+
+	SelfType &operator--() throw()
+	{
+		m_node = ThreadedSplayPred(m_node);
+		return *this;
+	}
+
+	SelfType operator--(int) throw()
+	{
+		SelfType tmp = *this;
+		m_node = ThreadedSplayPred(m_node);
+		return tmp;
+	}
+
+	bool operator==(SelfType const & other) const throw()
+	{
+		return m_node == other.m_node;
+	}
+
+	bool operator!=(SelfType const & other) const throw()
+	{
+		return m_node != other.m_node;
+	}
+
+	NodeBasePtrType m_node;
+};
+
+template <typename T>
+inline bool operator==(ThreadedSplayIterator<T> const & lhs,
+			ThreadedSplayConstIterator<T> const & rhs) throw()
+{
+	return lhs.m_node == rhs.m_node;
+}
+
+template <typename T>
+inline bool operator!=(ThreadedSplayIterator<T> const & lhs,
+			ThreadedSplayConstIterator<T> const & rhs) throw()
+{
+	return lhs.m_node != rhs.m_node;
+}
+
+#endif /*__THREADED_SPLAY_ITERATOR_HPP__*/
@@ -0,0 +1,12 @@
+#ifndef __THREADED_SPLAY_NODE_HPP__
+#define __THREADED_SPLAY_NODE_HPP__
+
+#include "threaded_splay_node_base.hpp"
+
+template <typename T>
+struct ThreadedSplayNode : public ThreadedSplayNodeBase
+{
+	T m_value;
+};
+
+#endif /*__THREADED_SPLAY_NODE_HPP__*/
@@ -0,0 +1,179 @@
+#include <cassert>
+#include "threaded_splay_node_base.hpp"
+
+namespace
+{
+
+	struct AlwaysLeft
+	{
+		int operator()(ThreadedSplayNodeBase const *) const throw()
+		{ return -1; }
+	};
+
+	struct AlwaysRight
+	{
+		int operator()(ThreadedSplayNodeBase const *) const throw()
+		{ return 1; }
+	};
+
+	/**
+	 * Splays subtree with root link and returns its new root, so that
+	 * minimum or maximum is found in amortized logarithmic time instead
+	 * of walking down the subtree.
+	 **/
+	template <typename Locate>
+	ThreadedSplayNodeBase *SplaySubtree(uintptr_t root, Locate locate)
+			throw()
+	{
+		ThreadedSplayNodeBase header;
+		header.m_left = root;
+		header.m_right = 0;
+
+		return ThreadedSplayTopDown(&header, locate);
+	}
+
+} /* anonymous namespace */
+
+
+void ThreadedSplayInit(ThreadedSplayNodeBase *header) throw()
+{
+	header->m_left = ThreadedThread(header);
+	header->m_right = ThreadedThread(header);
+}
+
+ThreadedSplayNodeBase const *ThreadedSplayLeftMost(
+			ThreadedSplayNodeBase const *node) throw()
+{
+	assert(node);
+	while (!ThreadedIsThread(node->m_left))
+		node = ThreadedGetNode(node->m_left);
+	return node;
+}
+
+ThreadedSplayNodeBase *ThreadedSplayLeftMost(ThreadedSplayNodeBase *node)
+			throw()
+{
+	return const_cast<ThreadedSplayNodeBase *>(ThreadedSplayLeftMost(
+			const_cast<ThreadedSplayNodeBase const *>(node)));
+}
+
+ThreadedSplayNodeBase const *ThreadedSplayRightMost(
+			ThreadedSplayNodeBase const *node) throw()
+{
+	assert(node);
+	while (!ThreadedIsThread(node->m_right))
+		node = ThreadedGetNode(node->m_right);
+	return node;
+}
+
+ThreadedSplayNodeBase *ThreadedSplayRightMost(ThreadedSplayNodeBase *node)
+			throw()
+{
+	return const_cast<ThreadedSplayNodeBase *>(ThreadedSplayRightMost(
+			const_cast<ThreadedSplayNodeBase const *>(node)));
+}
+
+ThreadedSplayNodeBase const *ThreadedSplaySucc(
+			ThreadedSplayNodeBase const *node) throw()
+{
+	assert(node);
+
+	if (ThreadedIsThread(node->m_right))
+		return ThreadedGetNode(node->m_right);
+
+	return ThreadedSplayLeftMost(ThreadedGetNode(node->m_right));
+}
+
+ThreadedSplayNodeBase *ThreadedSplaySucc(ThreadedSplayNodeBase *node) throw()
+{
+	return const_cast<ThreadedSplayNodeBase *>(ThreadedSplaySucc(
+			const_cast<ThreadedSplayNodeBase const *>(node)));
+}
+
+ThreadedSplayNodeBase const *ThreadedSplayPred(
+			ThreadedSplayNodeBase const *node) throw()
+{
+	assert(node);
+
+	if (ThreadedIsThread(node->m_left))
+		return ThreadedGetNode(node->m_left);
+
+	return ThreadedSplayRightMost(ThreadedGetNode(node->m_left));
+}
+
+ThreadedSplayNodeBase *ThreadedSplayPred(ThreadedSplayNodeBase *node) throw()
+{
+	return const_cast<ThreadedSplayNodeBase *>(ThreadedSplayPred(
+			const_cast<ThreadedSplayNodeBase const *>(node)));
+}
+
+ThreadedSplayNodeBase *ThreadedSplayParent(ThreadedSplayNodeBase *node)
+			throw()
+{
+	ThreadedSplayNodeBase *min = node;
+	ThreadedSplayNodeBase *max = node;
+
+	if (!ThreadedIsThread(node->m_left))
+	{
+		min = SplaySubtree(node->m_left, AlwaysLeft());
+		node->m_left = ThreadedChild(min);
+	}
+
+	ThreadedSplayNodeBase *const pred = ThreadedGetNode(min->m_left);
+	if (pred->m_right == ThreadedChild(node))
+		return pred;
+
+	if (!ThreadedIsThread(node->m_right))
+	{
+		max = SplaySubtree(node->m_right, AlwaysRight());
+		node->m_right = ThreadedChild(max);
+	}
+
+	return ThreadedGetNode(max->m_right);
+}
+
+ThreadedSplayNodeBase *ThreadedSplayErase(ThreadedSplayNodeBase *node,
+			ThreadedSplayNodeBase *header) throw()
+{
+	ThreadedSplayNodeBase *const parent = node == ThreadedGetNode(
+			header->m_left) ? header : ThreadedSplayParent(node);
+	bool const has_left = !ThreadedIsThread(node->m_left);
+	bool const has_right = !ThreadedIsThread(node->m_right);
+	bool const is_left = parent->m_left == ThreadedChild(node);
+	ThreadedSplayNodeBase *succ = ThreadedGetNode(node->m_right);
+	uintptr_t link;
+
+	if (!has_left && !has_right)
+	{
+		link = is_left ? node->m_left : node->m_right;
+	}
+	else if (!has_right)
+	{
+		ThreadedSplayNodeBase *const max =
+				SplaySubtree(node->m_left, AlwaysRight());
+		max->m_right = node->m_right;
+		link = ThreadedChild(max);
+	}
+	else if (!has_left)
+	{
+		succ = SplaySubtree(node->m_right, AlwaysLeft());
+		succ->m_left = node->m_left;
+		link = ThreadedChild(succ);
+	}
+	else
+	{
+		ThreadedSplayNodeBase *const max =
+				SplaySubtree(node->m_left, AlwaysRight());
+		succ = SplaySubtree(node->m_right, AlwaysLeft());
+		max->m_right = ThreadedChild(succ);
+		succ->m_left = ThreadedThread(max);
+		link = ThreadedChild(max);
+	}
+
+	if (is_left)
+		parent->m_left = link;
+	else
+		parent->m_right = link;
+
+	return succ;
+}
@@ -0,0 +1,249 @@
+#ifndef __THREADED_SPLAY_HPP__
+#define __THREADED_SPLAY_HPP__
+
+#include <stdint.h>
+
+/**
+ * Splay tree node without parent pointer. Empty child links are threads: an
+ * empty left link points to in-order predecessor and an empty right link
+ * points to in-order successor, the lowest bit of the link tells thread from
+ * child. Tree header takes part in threading: its left link is the root (or
+ * a thread to the header itself for an empty tree), minimum's left thread and
+ * maximum's right thread point to the header.
+ *
+ * Splaying can't go up without parent pointers, so all splaying is top-down.
+ **/
+struct ThreadedSplayNodeBase
+{
+	uintptr_t m_left;
+	uintptr_t m_right;
+};
+
+inline bool ThreadedIsThread(uintptr_t link) throw()
+{
+	return link & 1;
+}
+
+inline ThreadedSplayNodeBase *ThreadedGetNode(uintptr_t link) throw()
+{
+	return reinterpret_cast<ThreadedSplayNodeBase *>(link & ~uintptr_t(1));
+}
+
+inline uintptr_t ThreadedChild(ThreadedSplayNodeBase const *node) throw()
+{
+	return reinterpret_cast<uintptr_t>(node);
+}
+
+inline uintptr_t ThreadedThread(ThreadedSplayNodeBase const *node) throw()
+{
+	return reinterpret_cast<uintptr_t>(node) | 1;
+}
+
+void ThreadedSplayInit(ThreadedSplayNodeBase *header) throw();
+
+ThreadedSplayNodeBase const *ThreadedSplayLeftMost(
+			ThreadedSplayNodeBase const *node) throw();
+ThreadedSplayNodeBase *ThreadedSplayLeftMost(
+			ThreadedSplayNodeBase *node) throw();
+ThreadedSplayNodeBase const *ThreadedSplayRightMost(
+			ThreadedSplayNodeBase const *node) throw();
+ThreadedSplayNodeBase *ThreadedSplayRightMost(
+			ThreadedSplayNodeBase *node) throw();
+
+ThreadedSplayNodeBase const *ThreadedSplaySucc(
+			ThreadedSplayNodeBase const *node) throw();
+ThreadedSplayNodeBase *ThreadedSplaySucc(
+			ThreadedSplayNodeBase *node) throw();
+ThreadedSplayNodeBase const *ThreadedSplayPred(
+			ThreadedSplayNodeBase const *node) throw();
+ThreadedSplayNodeBase *ThreadedSplayPred(
+			ThreadedSplayNodeBase *node) throw();
+
+/**
+ * Finds parent of node using threads of its leftmost and rightmost
+ * descendants. Subtrees of node are splayed to bring them next to node,
+ * so it takes amortized logarithmic time.
+ **/
+ThreadedSplayNodeBase *ThreadedSplayParent(ThreadedSplayNodeBase *node)
+			throw();
+
+/**
+ * Unlinks node from tree with specified header, fixes threads and returns
+ * in-order successor of node. Parent of node other than the root is found
+ * with ThreadedSplayParent and subtrees of node are splayed to join them,
+ * so it takes amortized logarithmic time.
+ **/
+ThreadedSplayNodeBase *ThreadedSplayErase(ThreadedSplayNodeBase *node,
+			ThreadedSplayNodeBase *header) throw();
+
+/**
+ * Top-down splay of the tree with specified header. locate(node) returns
+ * negative value to continue in left subtree, positive value to continue
+ * in right subtree and zero to stop at node. The tree must not be empty.
+ * Returns new root.
+ **/
+template <typename Locate>
+ThreadedSplayNodeBase *ThreadedSplayTopDown(ThreadedSplayNodeBase *header,
+			Locate locate) throw()
+{
+	ThreadedSplayNodeBase tmp;
+	tmp.m_left = tmp.m_right = 0;
+
+	ThreadedSplayNodeBase *left = &tmp;
+	ThreadedSplayNodeBase *right = &tmp;
+	ThreadedSplayNodeBase *node = ThreadedGetNode(header->m_left);
+
+	for (;;)
+	{
+		int const dir = locate(node);
+
+		if (dir < 0)
+		{
+			if (ThreadedIsThread(node->m_left))
+				break;
+
+			ThreadedSplayNodeBase *child =
+					ThreadedGetNode(node->m_left);
+			if (locate(child) < 0)
+			{
+				node->m_left = ThreadedIsThread(child->m_right)
+					? ThreadedThread(child)
+					: child->m_right;
+				child->m_right = ThreadedChild(node);
+				node = child;
+				if (ThreadedIsThread(node->m_left))
+					break;
+			}
+
+			right->m_left = ThreadedChild(node);
+			right = node;
+			node = ThreadedGetNode(node->m_left);
+		}
+		else if (dir > 0)
+		{
+			if (ThreadedIsThread(node->m_right))
+				break;
+
+			ThreadedSplayNodeBase *child =
+					ThreadedGetNode(node->m_right);
+			if (locate(child) > 0)
+			{
+				node->m_right = ThreadedIsThread(child->m_left)
+					? ThreadedThread(child)
+					: child->m_left;
+				child->m_left = ThreadedChild(node);
+				node = child;
+				if (ThreadedIsThread(node->m_right))
+					break;
+			}
+
+			left->m_right = ThreadedChild(node);
+			left = node;
+			node = ThreadedGetNode(node->m_right);
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	if (left != &tmp)
+	{
+		left->m_right = ThreadedIsThread(node->m_left)
+				? ThreadedThread(node) : node->m_left;
+		node->m_left = tmp.m_right;
+	}
+
+	if (right != &tmp)
+	{
+		right->m_left = ThreadedIsThread(node->m_right)
+				? ThreadedThread(node) : node->m_right;
+		node->m_right = tmp.m_left;
+	}
+
+	header->m_left = ThreadedChild(node);
+	return node;
+}
+
+/**
+ * Top-down insert of new_node into the tree with specified header: splits
+ * the tree along the search path and assembles both parts around new_node,
+ * so new_node becomes the root. locate(node) must never return zero.
+ **/
+template <typename Locate>
+void ThreadedSplayInsert(ThreadedSplayNodeBase *new_node,
+			ThreadedSplayNodeBase *header, Locate locate) throw()
+{
+	ThreadedSplayNodeBase tmp;
+	tmp.m_left = tmp.m_right = 0;
+
+	ThreadedSplayNodeBase *left = &tmp;
+	ThreadedSplayNodeBase *right = &tmp;
+	uintptr_t link = header->m_left;
+
+	while (!ThreadedIsThread(link))
+	{
+		ThreadedSplayNodeBase *node = ThreadedGetNode(link);
+
+		if (locate(node) < 0)
+		{
+			ThreadedSplayNodeBase *child =
+					ThreadedGetNode(node->m_left);
+			if (!ThreadedIsThread(node->m_left)
+					&& locate(child) < 0)
+			{
+				node->m_left = ThreadedIsThread(child->m_right)
+					? ThreadedThread(child)
+					: child->m_right;
+				child->m_right = ThreadedChild(node);
+				node = child;
+			}
+
+			right->m_left = ThreadedChild(node);
+			right = node;
+			link = node->m_left;
+		}
+		else
+		{
+			ThreadedSplayNodeBase *child =
+					ThreadedGetNode(node->m_right);
+			if (!ThreadedIsThread(node->m_right)
+					&& locate(child) > 0)
+			{
+				node->m_right = ThreadedIsThread(child->m_left)
+					? ThreadedThread(child)
+					: child->m_left;
+				child->m_left = ThreadedChild(node);
+				node = child;
+			}
+
+			left->m_right = ThreadedChild(node);
+			left = node;
+			link = node->m_right;
+		}
+	}
+
+	if (left != &tmp)
+	{
+		left->m_right = ThreadedThread(new_node);
+		new_node->m_left = tmp.m_right;
+	}
+	else
+	{
+		new_node->m_left = ThreadedThread(header);
+	}
+
+	if (right != &tmp)
+	{
+		right->m_left = ThreadedThread(new_node);
+		new_node->m_right = tmp.m_left;
+	}
+	else
+	{
+		new_node->m_right = ThreadedThread(header);
+	}
+
+	header->m_left = ThreadedChild(new_node);
+}
+
+#endif /*__THREADED_SPLAY_HPP__*/
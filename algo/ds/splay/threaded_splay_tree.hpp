@@ -0,0 +1,493 @@
+#ifndef __THREADED_SPLAY_TREE_HPP__
+#define __THREADED_SPLAY_TREE_HPP__
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+
+#include "threaded_splay_iterator.hpp"
+#include "threaded_splay_node.hpp"
+
+/**
+ * ThreadedSplayTree has the same interface as SplayTree, but its nodes have
+ * no parent pointer: iterators follow threads stored in empty child links and
+ * all splaying is top-down. SplayNode<int> takes 32 bytes while
+ * ThreadedSplayNode<int> takes 24 bytes on 64 bit platforms.
+ **/
+template <typename KeyCmp, typename NodeAllocator>
+struct ThreadedSplayTreeImpl : public NodeAllocator
+{
+	ThreadedSplayTreeImpl()
+		: NodeAllocator()
+		, m_cmp()
+		, m_header()
+		, m_size(0)
+	{ Init(); }
+
+	ThreadedSplayTreeImpl(KeyCmp const & cmp, NodeAllocator const & a)
+		: NodeAllocator(a)
+		, m_cmp(cmp)
+		, m_header()
+		, m_size(0)
+	{ Init(); }
+
+	void Init() throw()
+	{
+		ThreadedSplayInit(&m_header);
+	}
+
+	KeyCmp m_cmp;
+	ThreadedSplayNodeBase m_header;
+	size_t m_size;
+};
+
+template < typename Key, typename Val, typename KeyVal, typename Cmp,
+			typename Alloc = std::allocator<Val> >
+class ThreadedSplayTree
+{
+	typedef typename Alloc::template rebind< ThreadedSplayNode<Val> >::other
+				NodeAllocator;
+	typedef ThreadedSplayTree<Key, Val, KeyVal, Cmp, Alloc> SelfType;
+
+public:
+	typedef Key key_type;
+	typedef Val value_type;
+	typedef value_type * pointer;
+	typedef value_type const * const_pointer;
+	typedef value_type & reference;
+	typedef value_type const & const_reference;
+	typedef size_t size_type;
+	typedef Alloc allocator_type;
+
+	typedef ThreadedSplayIterator<value_type> iterator;
+	typedef ThreadedSplayConstIterator<value_type> const_iterator;
+	typedef std::reverse_iterator<iterator> reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+	allocator_type get_allocator() const throw()
+	{
+		return allocator_type(GetAllocator());
+	}
+
+private:
+	typedef ThreadedSplayNodeBase * NodeBasePtr;
+	typedef ThreadedSplayNodeBase const * NodeBaseConstPtr;
+	typedef ThreadedSplayNode<Val> * NodePtr;
+	typedef ThreadedSplayNode<Val> const * NodeConstPtr;
+	typedef ThreadedSplayTreeImpl<Cmp, NodeAllocator> SplayImpl;
+
+	NodeAllocator & GetAllocator() throw()
+	{
+		return *static_cast<NodeAllocator *>(&m_impl);
+	}
+
+	NodeAllocator const & GetAllocator() const throw()
+	{
+		return *static_cast<NodeAllocator const *>(&m_impl);
+	}
+
+	NodePtr GetNode()
+	{
+		NodePtr tmp = GetAllocator().allocate(1);
+		tmp->m_left = tmp->m_right = 0;
+		return tmp;
+	}
+
+	void PutNode(NodePtr ptr) throw()
+	{
+		GetAllocator().deallocate(ptr, 1);
+	}
+
+	NodePtr CreateNode(value_type const &x)
+	{
+		NodePtr tmp = GetNode();
+		try
+		{
+			get_allocator().construct(&tmp->m_value, x);
+		}
+		catch (...)
+		{
+			PutNode(tmp);
+			throw;
+		}
+		return tmp;
+	}
+
+	void DestroyNode(NodePtr ptr)
+	{
+		get_allocator().destroy(&ptr->m_value);
+		PutNode(ptr);
+	}
+
+	static const_reference GetValue(NodeConstPtr x) throw()
+	{
+		return x->m_value;
+	}
+
+	static const_reference GetValue(NodeBaseConstPtr x) throw()
+	{
+		return GetValue(static_cast<NodeConstPtr>(x));
+	}
+
+	static Key const & GetKey(NodeConstPtr x) throw()
+	{
+		return KeyVal()(GetValue(x));
+	}
+
+	static Key const & GetKey(NodeBaseConstPtr x) throw()
+	{
+		return GetKey(static_cast<NodeConstPtr>(x));
+	}
+
+	bool Empty() const throw()
+	{
+		return ThreadedIsThread(m_impl.m_header.m_left);
+	}
+
+	struct KeyLocator
+	{
+		KeyLocator(Cmp const & cmp, Key const & k)
+			: m_cmp(cmp)
+			, m_key(k)
+		{ }
+
+		int operator()(NodeBaseConstPtr x) const
+		{
+			if (m_cmp(m_key, GetKey(x)))
+				return -1;
+			if (m_cmp(GetKey(x), m_key))
+				return 1;
+			return 0;
+		}
+
+		Cmp const & m_cmp;
+		Key const & m_key;
+	};
+
+	struct InsertLocator
+	{
+		InsertLocator(Cmp const & cmp, Key const & k)
+			: m_cmp(cmp)
+			, m_key(k)
+		{ }
+
+		int operator()(NodeBaseConstPtr x) const
+		{
+			return m_cmp(GetKey(x), m_key) ? 1 : -1;
+		}
+
+		Cmp const & m_cmp;
+		Key const & m_key;
+	};
+
+	NodeBaseConstPtr LowerBound(Key const & k) const throw()
+	{
+		NodeBaseConstPtr parent = &m_impl.m_header;
+		uintptr_t link = m_impl.m_header.m_left;
+
+		while (!ThreadedIsThread(link))
+		{
+			NodeBaseConstPtr current = ThreadedGetNode(link);
+
+			if (!m_impl.m_cmp(GetKey(current), k))
+			{
+				parent = current;
+				link = current->m_left;
+			}
+			else
+			{
+				link = current->m_right;
+			}
+		}
+
+		return parent;
+	}
+
+	NodeBasePtr LowerBound(Key const & k) throw()
+	{
+		return const_cast<NodeBasePtr>(
+			const_cast<SelfType const *>(this)->LowerBound(k));
+	}
+
+	NodeBaseConstPtr UpperBound(Key const & k) const throw()
+	{
+		NodeBaseConstPtr parent = &m_impl.m_header;
+		uintptr_t link = m_impl.m_header.m_left;
+
+		while (!ThreadedIsThread(link))
+		{
+			NodeBaseConstPtr current = ThreadedGetNode(link);
+
+			if (m_impl.m_cmp(k, GetKey(current)))
+			{
+				parent = current;
+				link = current->m_left;
+			}
+			else
+			{
+				link = current->m_right;
+			}
+		}
+
+		return parent;
+	}
+
+	NodeBasePtr UpperBound(Key const & k) throw()
+	{
+		return const_cast<NodeBasePtr>(
+			const_cast<SelfType const *>(this)->UpperBound(k));
+	}
+
+	NodeBasePtr Lookup(Key const & k) throw()
+	{
+		if (Empty())
+			return &m_impl.m_header;
+
+		NodeBasePtr root = ThreadedSplayTopDown(&m_impl.m_header,
+					KeyLocator(m_impl.m_cmp, k));
+
+		if (!m_impl.m_cmp(GetKey(root), k)
+				&& !m_impl.m_cmp(k, GetKey(root)))
+			return root;
+
+		return &m_impl.m_header;
+	}
+
+	NodePtr Insert(value_type const & v)
+	{
+		NodePtr node = CreateNode(v);
+
+		ThreadedSplayInsert(node, &m_impl.m_header,
+				InsertLocator(m_impl.m_cmp, KeyVal()(v)));
+		++m_impl.m_size;
+
+		return node;
+	}
+
+	NodeBasePtr Erase(NodePtr node)
+	{
+		/* node becomes the root unless its key is not unique, then
+		 * ThreadedSplayErase finds its parent */
+		ThreadedSplayTopDown(&m_impl.m_header,
+				KeyLocator(m_impl.m_cmp, GetKey(node)));
+		NodeBasePtr next = ThreadedSplayErase(node, &m_impl.m_header);
+		DestroyNode(node);
+		--m_impl.m_size;
+
+		return next;
+	}
+
+	/**
+	 * Points threads of minimum and maximum to the header of this tree
+	 * after the root moved here from another tree.
+	 **/
+	void Rethread() throw()
+	{
+		NodeBasePtr const header = &m_impl.m_header;
+
+		if (Empty())
+		{
+			ThreadedSplayInit(header);
+			return;
+		}
+
+		NodeBasePtr const root = ThreadedGetNode(header->m_left);
+		ThreadedSplayLeftMost(root)->m_left = ThreadedThread(header);
+		ThreadedSplayRightMost(root)->m_right = ThreadedThread(header);
+	}
+
+public:
+	template <typename InputIterator>
+	ThreadedSplayTree(InputIterator first, InputIterator last)
+		: m_impl()
+	{
+		insert(first, last);
+	}
+
+	ThreadedSplayTree() throw()
+		: m_impl()
+	{ }
+
+	ThreadedSplayTree(ThreadedSplayTree const & other)
+		: m_impl(other.m_impl.m_cmp, other.GetAllocator())
+	{
+		try
+		{
+			insert(other.begin(), other.end());
+		}
+		catch (...)
+		{
+			clear();
+			throw;
+		}
+	}
+
+	~ThreadedSplayTree()
+	{
+		clear();
+	}
+
+	/**
+	 * Copies other aside and swaps with the copy, so the tree is left
+	 * unchanged if copying throws.
+	 **/
+	ThreadedSplayTree & operator=(ThreadedSplayTree const & other)
+	{
+		if (this != &other)
+		{
+			ThreadedSplayTree copy(other);
+			swap(copy);
+		}
+		return *this;
+	}
+
+	/**
+	 * Frees nodes in one pass without splaying: while the root has a
+	 * left child it's rotated up, a root without one is freed and its
+	 * right child takes its place.
+	 **/
+	void clear()
+	{
+		uintptr_t link = m_impl.m_header.m_left;
+
+		while (!ThreadedIsThread(link))
+		{
+			NodeBasePtr const node = ThreadedGetNode(link);
+
+			if (ThreadedIsThread(node->m_left))
+			{
+				link = node->m_right;
+				DestroyNode(static_cast<NodePtr>(node));
+				continue;
+			}
+
+			NodeBasePtr const left = ThreadedGetNode(node->m_left);
+			node->m_left = left->m_right;
+			left->m_right = ThreadedChild(node);
+			link = ThreadedChild(left);
+		}
+
+		m_impl.Init();
+		m_impl.m_size = 0;
+	}
+
+	iterator begin() throw()
+	{
+		return iterator(ThreadedSplayLeftMost(&m_impl.m_header));
+	}
+
+	const_iterator begin() const throw()
+	{
+		return const_iterator(ThreadedSplayLeftMost(&m_impl.m_header));
+	}
+
+	reverse_iterator rbegin() throw()
+	{
+		return reverse_iterator(end());
+	}
+
+	const_reverse_iterator rbegin() const throw()
+	{
+		return const_reverse_iterator(end());
+	}
+
+	iterator end() throw()
+	{
+		return iterator(&m_impl.m_header);
+	}
+
+	const_iterator end() const throw()
+	{
+		return const_iterator(&m_impl.m_header);
+	}
+
+	reverse_iterator rend() throw()
+	{
+		return reverse_iterator(begin());
+	}
+
+	const_reverse_iterator rend() const throw()
+	{
+		return const_reverse_iterator(begin());
+	}
+
+	iterator lower_bound(Key const & k) throw()
+	{
+		return iterator(LowerBound(k));
+	}
+
+	iterator upper_bound(Key const & k) throw()
+	{
+		return iterator(UpperBound(k));
+	}
+
+	std::pair<iterator, iterator> equal_range(Key const & k) throw()
+	{
+		return std::make_pair(lower_bound(k), upper_bound(k));
+	}
+
+	iterator find(Key const & k) throw()
+	{
+		return iterator(Lookup(k));
+	}
+
+	std::pair<iterator, bool> insert_unique(value_type const & val)
+	{
+		iterator it = find(KeyVal()(val));
+
+		if (it == end())
+			return std::make_pair(iterator(Insert(val)), true);
+
+		return std::make_pair(it, false);
+	}
+
+	template <typename InputIterator>
+	void insert(InputIterator first, InputIterator last)
+	{
+		for (; first != last; ++first)
+			insert(*first);
+	}
+
+	iterator insert(value_type const & val)
+	{
+		return iterator(Insert(val));
+	}
+
+	iterator erase(iterator it)
+	{
+		return iterator(Erase(static_cast<NodePtr>(it.m_node)));
+	}
+
+	iterator erase(iterator first, iterator last)
+	{
+		iterator it = first;
+		for (; it != last;)
+			it = erase(it);
+		return it;
+	}
+
+	size_t size() const throw()
+	{
+		return m_impl.m_size;
+	}
+
+	/**
+	 * Minimum and maximum thread to the header, so swap takes time
+	 * proportional to the leftmost and rightmost paths of both trees.
+	 **/
+	void swap(ThreadedSplayTree & other)
+	{
+		std::swap(m_impl.m_cmp, other.m_impl.m_cmp);
+		std::swap(GetAllocator(), other.GetAllocator());
+		std::swap(m_impl.m_header.m_left, other.m_impl.m_header.m_left);
+		std::swap(m_impl.m_size, other.m_impl.m_size);
+
+		Rethread();
+		other.Rethread();
+	}
+
+private:
+	SplayImpl m_impl;
+};
+
+#endif /*__THREADED_SPLAY_TREE_HPP__*/